@@ -0,0 +1,389 @@
+#ifndef BOARD_GEOMETRY_HPP
+#define BOARD_GEOMETRY_HPP
+#include <cstdint>
+#include <cstddef>
+#include <type_traits>
+#include <bit>
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
+typedef std::size_t s_t;
+
+
+/*Smallest unsigned integer type holding at least `bits` bits.
+ *Used to pick the storage word for bitboards and packed positions at compile time.*/
+template <s_t bits>
+using UnsignedWord = std::conditional_t<(bits <= 16), uint16_t,
+	std::conditional_t<(bits <= 32), uint32_t,
+	std::conditional_t<(bits <= 64), uint64_t, unsigned __int128>>>;
+
+
+/*Number of set bits in a 64-bit word.
+ *Without a popcount instruction, (eg. building for plain x86-64), compilers turn std::popcount into a library call,
+ *which is slow enough to show up in the search, so the bits are counted in registers instead.*/
+constexpr int popCount64(uint64_t word)
+{
+#if defined(__POPCNT__) || defined(__ARM_NEON) || defined(__aarch64__)
+	return std::popcount(word);
+#else
+	word = word - ((word >> 1) & 0x5555555555555555);
+	word = (word & 0x3333333333333333) + ((word >> 2) & 0x3333333333333333);
+	word = (word + (word >> 4)) & 0x0F0F0F0F0F0F0F0F;
+	return int((word * 0x0101010101010101) >> 56);
+#endif
+}
+
+
+/*Number of set bits in `word`.
+ *128-bit words are split in half.*/
+template <class Word>
+constexpr int popCount(Word word)
+{
+	if constexpr (sizeof(Word) > sizeof(uint64_t))
+	{
+		return popCount64(uint64_t(word)) + popCount64(uint64_t(word >> 64));
+	}
+	else
+	{
+		return popCount64(word);
+	}
+}
+
+
+/*Index of the lowest set bit of `word`.
+ *Precondition: `word` is not zero.*/
+template <class Word>
+constexpr int lowestBit(Word word)
+{
+	if constexpr (sizeof(Word) > sizeof(uint64_t))
+	{
+		return (uint64_t(word) != 0) ? std::countr_zero(uint64_t(word))
+			: 64 + std::countr_zero(uint64_t(word >> 64));
+	}
+	else
+	{
+		return std::countr_zero(word);
+	}
+}
+
+
+/*Index of the highest set bit of `word`.
+ *Precondition: `word` is not zero.*/
+template <class Word>
+constexpr int highestBit(Word word)
+{
+	if constexpr (sizeof(Word) > sizeof(uint64_t))
+	{
+		return (uint64_t(word >> 64) != 0) ? 127 - std::countl_zero(uint64_t(word >> 64))
+			: 63 - std::countl_zero(uint64_t(word));
+	}
+	else
+	{
+		return std::bit_width(word) - 1;
+	}
+}
+
+
+/*Index of the `index`th lowest set bit of `word`, counting from 0.
+ *With BMI2, the bit is deposited straight into place with one instruction.
+ *Without it, the lower set bits are cleared one at a time.
+ *Precondition: `word` has more than `index` set bits.*/
+template <class Word>
+inline int selectBit(Word word, int index)
+{
+#if defined(__BMI2__)
+	if constexpr (sizeof(Word) <= sizeof(uint64_t))
+	{
+		return std::countr_zero(_pdep_u64(uint64_t(1) << index, word));
+	}
+#endif
+	for (; index > 0; index--)
+	{
+		word &= word - 1;
+	}
+	return lowestBit(word);
+}
+
+
+/*Reflections and rotations which map the board onto itself.
+ *Every board has the first four. Square boards have all eight.*/
+enum Symmetry : uint8_t
+{
+	IDENTITY,
+	FLIP_HORIZONTAL,	//Mirror left to right; (row, col) -> (row, COLUMNS-1-col).
+	FLIP_VERTICAL,		//Mirror top to bottom; (row, col) -> (ROWS-1-row, col).
+	ROTATE_180,			//Both of the above.
+	TRANSPOSE,			//Mirror along the main diagonal; (row, col) -> (col, row).
+	ROTATE_90,			//Quarter turn clockwise; (row, col) -> (col, ROWS-1-row).
+	ROTATE_270,			//Quarter turn counter-clockwise; (row, col) -> (COLUMNS-1-col, row).
+	ANTI_TRANSPOSE		//Mirror along the other diagonal; (row, col) -> (COLUMNS-1-col, ROWS-1-row).
+};
+
+
+/*Returns the symmetry which undoes the given one.
+ *Every symmetry is its own inverse, except for the two quarter turns.*/
+constexpr Symmetry inverseSymmetry(Symmetry symmetry)
+{
+	return (symmetry == ROTATE_90) ? ROTATE_270
+		: (symmetry == ROTATE_270) ? ROTATE_90
+		: symmetry;
+}
+
+
+/*Spreads the bits of a packed position, (any unsigned integer up to 128 bits), over a 64-bit hash.
+ *Unlike the Zobrist hashes, this only depends on the key itself, so it never changes between builds,
+ *which lets files store positions in slots picked by it.*/
+template <class Key>
+constexpr uint64_t hashPositionKey(Key key)
+{
+	uint64_t mixed = uint64_t(key);
+	if constexpr (sizeof(Key) > sizeof(uint64_t))
+	{
+		mixed ^= uint64_t(key >> 64) * 0x9E3779B97F4A7C15;
+	}
+	mixed = (mixed ^ (mixed >> 30)) * 0xBF58476D1CE4E5B9;
+	mixed = (mixed ^ (mixed >> 27)) * 0x94D049BB133111EB;
+	return mixed ^ (mixed >> 31);
+}
+
+
+/*Everything about a board which only depends on its size and rules:
+ *the storage types, and tables of winning lines, hash keys, and symmetries.
+ *All of it is generated at compile time, once per board variant.
+ *Square (row, col) is always stored in bit (row * COLUMNS + col),
+ *so the top-left square is bit 0, and the bottom-right square is the highest bit.*/
+template <uint8_t Rows, uint8_t Columns, uint8_t NumToWin, s_t NumPlayers>
+struct BoardGeometry
+{
+	static constexpr uint8_t ROWS = Rows;
+	static constexpr uint8_t COLUMNS = Columns;
+	static constexpr uint8_t NUM_TO_WIN = NumToWin;
+	static constexpr s_t NUM_PLAYERS = NumPlayers;
+	static constexpr uint8_t NUM_SQUARES = ROWS * COLUMNS;
+	static constexpr uint8_t NUM_SYMMETRIES = (ROWS == COLUMNS) ? 8 : 4;
+
+	static_assert(NUM_PLAYERS >= 2 && NUM_PLAYERS <= 3, "Only X, O, and Y tokens exist.");
+	static_assert(NUM_TO_WIN >= 2 && NUM_TO_WIN <= ROWS && NUM_TO_WIN <= COLUMNS,
+		"A winning line has to fit on the board.");
+	static_assert(NUM_SQUARES <= 128, "Board does not fit in a Bitboard.");
+
+
+	/*One bit per square, used to store each player's tokens.*/
+	typedef UnsignedWord<NUM_SQUARES> Bitboard;
+
+
+	/*A whole position packed into one integer: each player's bitboard in turn order,
+	 *(X in the lowest NUM_SQUARES bits), followed by two bits for the index of the turn player.
+	 *Two positions are equal iff their keys are equal.*/
+	typedef UnsignedWord<NUM_PLAYERS * NUM_SQUARES + 2> PositionKey;
+	static_assert(NUM_PLAYERS * NUM_SQUARES + 2 <= 128, "Position does not fit in a PositionKey.");
+
+
+	static constexpr Bitboard squareBit(s_t square) { return Bitboard(1) << square; }
+
+
+	/*Every square on the board.*/
+	static constexpr Bitboard ALL_SQUARES = (NUM_SQUARES == 8 * sizeof(Bitboard))
+		? Bitboard(~Bitboard(0)) : Bitboard((Bitboard(1) << NUM_SQUARES) - 1);
+
+
+	/*Every line of NUM_TO_WIN squares which wins the game.
+	 *`throughSquare[square]` lists each winning line containing that square,
+	 *which is all that needs checking after a token is placed there.
+	 *Each of the 4 directions can hold at most NUM_TO_WIN lines through the same square.
+	 *`lineStarts[direction]` holds the lowest bit of every line running in that direction,
+	 *and `lineSteps[direction]` how many bits apart consecutive squares of those lines are,
+	 *which is all hasLine() needs to check a whole direction at once.*/
+	struct WinLineTable
+	{
+		Bitboard lines[4 * NUM_SQUARES];
+		uint8_t numLines;
+
+		Bitboard lineStarts[4];
+		uint8_t lineSteps[4];
+
+		Bitboard throughSquare[NUM_SQUARES][4 * NUM_TO_WIN];
+		uint8_t numThroughSquare[NUM_SQUARES];
+	};
+
+
+	/*Random keys used to hash board positions with Zobrist hashing.
+	 *A position's hash is the XOR of the key for every (player, square) pair holding a token,
+	 *and the key for the turn player, so each move only needs to XOR in or out a couple of keys.*/
+	struct ZobristTable
+	{
+		uint64_t squares[NUM_PLAYERS][NUM_SQUARES];
+		uint64_t turn[NUM_PLAYERS];
+	};
+
+
+	/*`squares[symmetry][square]` is the square that `square` lands on under `symmetry`.*/
+	struct SymmetryTable
+	{
+		uint8_t squares[NUM_SYMMETRIES][NUM_SQUARES];
+	};
+
+
+	/*Builds the win-line table by sliding a NUM_TO_WIN long window
+	 *horizontally, vertically, and along both diagonals.*/
+	static constexpr WinLineTable buildWinLineTable()
+	{
+		WinLineTable table{};
+		const int directions[4][2] = {{0, 1}, {1, 0}, {1, 1}, {-1, 1}};
+
+		for (s_t index = 0; index < 4; index++)
+		{
+			const auto& direction = directions[index];
+			//Lines running up and to the right start from their top-right square, one row down and one column left per step.
+			table.lineSteps[index] = uint8_t((direction[0] < 0) ? COLUMNS - 1 : direction[0] * COLUMNS + direction[1]);
+
+			for (int row = 0; row < ROWS; row++)
+			{
+				for (int col = 0; col < COLUMNS; col++)
+				{
+					//Skip any window that would run off of the board.
+					int endRow = row + direction[0] * (NUM_TO_WIN - 1);
+					int endCol = col + direction[1] * (NUM_TO_WIN - 1);
+					if (endRow < 0 || endRow >= ROWS || endCol >= COLUMNS)
+					{
+						continue;
+					}
+
+					Bitboard line = 0;
+					for (int step = 0; step < NUM_TO_WIN; step++)
+					{
+						line |= squareBit((row + direction[0] * step) * COLUMNS + col + direction[1] * step);
+					}
+
+					table.lines[table.numLines++] = line;
+					table.lineStarts[index] |= line & Bitboard(~line + 1);
+					for (int square = 0; square < NUM_SQUARES; square++)
+					{
+						if (line & squareBit(square))
+						{
+							table.throughSquare[square][table.numThroughSquare[square]++] = line;
+						}
+					}
+				}
+			}
+		}
+
+		return table;
+	}
+
+
+	/*Fills the Zobrist table using the SplitMix64 generator with a fixed seed,
+	 *so hashes stay the same across runs and builds.*/
+	static constexpr ZobristTable buildZobristTable()
+	{
+		ZobristTable table{};
+		uint64_t state = 0x4D6F546163546F65;	//"MoTacToe"
+
+		auto next = [&state]()
+		{
+			state += 0x9E3779B97F4A7C15;
+			uint64_t mixed = state;
+			mixed = (mixed ^ (mixed >> 30)) * 0xBF58476D1CE4E5B9;
+			mixed = (mixed ^ (mixed >> 27)) * 0x94D049BB133111EB;
+			return mixed ^ (mixed >> 31);
+		};
+
+		for (s_t player = 0; player < NUM_PLAYERS; player++)
+		{
+			for (s_t square = 0; square < NUM_SQUARES; square++)
+			{
+				table.squares[player][square] = next();
+			}
+			table.turn[player] = next();
+		}
+
+		return table;
+	}
+
+
+	static constexpr SymmetryTable buildSymmetryTable()
+	{
+		SymmetryTable table{};
+
+		for (uint8_t symmetry = 0; symmetry < NUM_SYMMETRIES; symmetry++)
+		{
+			for (int row = 0; row < ROWS; row++)
+			{
+				for (int col = 0; col < COLUMNS; col++)
+				{
+					int newRow = row, newCol = col;
+					switch (symmetry)
+					{
+						case FLIP_HORIZONTAL: newCol = COLUMNS - 1 - col; break;
+						case FLIP_VERTICAL: newRow = ROWS - 1 - row; break;
+						case ROTATE_180: newRow = ROWS - 1 - row; newCol = COLUMNS - 1 - col; break;
+						case TRANSPOSE: newRow = col; newCol = row; break;
+						case ROTATE_90: newRow = col; newCol = ROWS - 1 - row; break;
+						case ROTATE_270: newRow = COLUMNS - 1 - col; newCol = row; break;
+						case ANTI_TRANSPOSE: newRow = COLUMNS - 1 - col; newCol = ROWS - 1 - row; break;
+						default: break;
+					}
+					table.squares[symmetry][row * COLUMNS + col] = newRow * COLUMNS + newCol;
+				}
+			}
+		}
+
+		return table;
+	}
+
+
+	static constexpr WinLineTable WIN_LINES = buildWinLineTable();
+	static constexpr ZobristTable ZOBRIST = buildZobristTable();
+	static constexpr SymmetryTable SYMMETRIES = buildSymmetryTable();
+
+
+	/*Returns true iff `tokens` holds every square of some winning line.
+	 *Shifts each direction's line starts along the line, so every line in a direction is checked at once.*/
+	static bool hasLine(Bitboard tokens)
+	{
+		for (s_t direction = 0; direction < 4; direction++)
+		{
+			Bitboard run = tokens & WIN_LINES.lineStarts[direction];
+			for (s_t step = 1; step < NUM_TO_WIN; step++)
+			{
+				run &= Bitboard(tokens >> (step * WIN_LINES.lineSteps[direction]));
+			}
+			if (run)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+
+	/*Returns every square which would complete a winning line of `tokens` if it held one more token,
+	 *(occupied or not; mask with the empty squares for a player's actual threats).
+	 *Works a direction at a time like hasLine(): for each position along the line that could be the missing one,
+	 *the line starts whose other squares are all present are shifted onto that position.
+	 *No branches or table lookups, so it is cheap enough to recompute from scratch after every move.*/
+	static Bitboard threatSquares(Bitboard tokens)
+	{
+		Bitboard threats = 0;
+		for (s_t direction = 0; direction < 4; direction++)
+		{
+			s_t step = WIN_LINES.lineSteps[direction];
+			for (s_t missing = 0; missing < NUM_TO_WIN; missing++)
+			{
+				Bitboard run = WIN_LINES.lineStarts[direction];
+				for (s_t present = 0; present < NUM_TO_WIN; present++)
+				{
+					if (present != missing)
+					{
+						run &= Bitboard(tokens >> (present * step));
+					}
+				}
+				threats |= Bitboard(run << (missing * step));
+			}
+		}
+		return threats;
+	}
+};
+
+
+#endif
@@ -0,0 +1,104 @@
+#include "mapped_file.hpp"
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+#include <iterator>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define MAPPED_FILE_MMAP
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+
+MappedFile::MappedFile(const std::string& path)
+{
+	contents = nullptr;
+	length = 0;
+	mapped = false;
+
+#ifdef MAPPED_FILE_MMAP
+	int descriptor = open(path.c_str(), O_RDONLY);
+	if (descriptor < 0)
+	{
+		throw std::runtime_error("Could not open \"" + path + "\".");
+	}
+
+	struct stat status;
+	if (fstat(descriptor, &status) == 0 && status.st_size > 0)
+	{
+		void* mapping = mmap(nullptr, status.st_size, PROT_READ, MAP_SHARED, descriptor, 0);
+		if (mapping != MAP_FAILED)
+		{
+			contents = static_cast<const uint8_t*>(mapping);
+			length = status.st_size;
+			mapped = true;
+		}
+	}
+	close(descriptor);
+
+	//Otherwise fall back to reading it, (an empty file, for one, can't be mapped).
+	if (mapped)
+	{
+		return;
+	}
+#endif
+
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+	{
+		throw std::runtime_error("Could not open \"" + path + "\".");
+	}
+	buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	contents = buffer.data();
+	length = buffer.size();
+}
+
+
+MappedFile::~MappedFile()
+{
+	release();
+}
+
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+{
+	contents = nullptr;
+	length = 0;
+	mapped = false;
+	*this = std::move(other);
+}
+
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+	if (this != &other)
+	{
+		release();
+		mapped = other.mapped;
+		buffer = std::move(other.buffer);
+		contents = mapped ? other.contents : buffer.data();
+		length = other.length;
+		other.contents = nullptr;
+		other.length = 0;
+		other.mapped = false;
+	}
+	return *this;
+}
+
+
+void MappedFile::release()
+{
+#ifdef MAPPED_FILE_MMAP
+	if (mapped)
+	{
+		munmap(const_cast<uint8_t*>(contents), length);
+	}
+#endif
+	buffer.clear();
+	contents = nullptr;
+	length = 0;
+	mapped = false;
+}
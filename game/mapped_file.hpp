@@ -0,0 +1,50 @@
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+
+/*Read-only view of a whole file's contents.
+ *Where the platform supports it, the file is memory-mapped, so nothing is read until it is touched,
+ *and several processes opening the same file share one copy of it in memory.
+ *Elsewhere, the file is simply read into memory up front.*/
+class MappedFile
+{
+	private:
+		const uint8_t* contents;
+		std::size_t length;
+
+
+		/*Whether `contents` points into a mapping, or into `buffer`,
+		 *which holds the contents when the file couldn't be mapped.*/
+		bool mapped;
+		std::vector<uint8_t> buffer;
+
+
+		void release();
+
+
+	public:
+		/*Opens and maps the file at `path`.
+		 *Throws std::runtime_error if it can't be opened.*/
+		explicit MappedFile(const std::string& path);
+
+
+		~MappedFile();
+
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+		MappedFile(MappedFile&& other) noexcept;
+		MappedFile& operator=(MappedFile&& other) noexcept;
+
+
+		const uint8_t* data() const { return contents; }
+		std::size_t size() const { return length; }
+};
+
+
+#endif
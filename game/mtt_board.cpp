@@ -1,33 +1,33 @@
 #include "mtt_board.hpp"
-#include <cmath>	//abs()
+#include <charconv>
 
 
 //Public Functions
 
 //Default constructor.
-MTT_Board::MTT_Board()
+template <uint8_t ROWS, uint8_t COLUMNS, uint8_t NUM_TO_WIN, s_t NUM_PLAYERS>
+MTT_Board<ROWS, COLUMNS, NUM_TO_WIN, NUM_PLAYERS>::MTT_Board()
 {
-	Position position;
-
-	//Initialize all of the blocks in the array to contain "NONE".
-	for (position.row = 0; position.row < ROWS; position.row++)
+	//Start with every square empty.
+	for (s_t player = 0; player < NUM_PLAYERS; player++)
 	{
-		for (position.col = 0; position.col < COLUMNS; position.col++)
-		{
-			placeToken(position, NONE);
-		}
+		playerBoards[player] = 0;
+		threatBoards[player] = 0;
 	}
 
 	//Set the rest of the values and flags to the value they have at the start of the game.
 	turnPlayer = X;
+	resetHash(X);
 	gameOver = false;
 	victor = NONE;
 	numberOfMoves = 0;
+	historySize = 0;
 }
 
 
 //Parameterized constructor.
-MTT_Board::MTT_Board(const std::string boardPosition)
+template <uint8_t ROWS, uint8_t COLUMNS, uint8_t NUM_TO_WIN, s_t NUM_PLAYERS>
+MTT_Board<ROWS, COLUMNS, NUM_TO_WIN, NUM_PLAYERS>::MTT_Board(std::string_view boardPosition)
 {
 	setBoard(boardPosition);
 }
@@ -35,7 +35,8 @@ MTT_Board::MTT_Board(const std::string boardPosition)
 
 /*After verifying the desired move is in bounds and empty, places the turn player's token there.
  *Returns true iff the token was placed successfully.*/
-bool MTT_Board::makeMove(uint8_t row, uint8_t column)
+template <uint8_t ROWS, uint8_t COLUMNS, uint8_t NUM_TO_WIN, s_t NUM_PLAYERS>
+bool MTT_Board<ROWS, COLUMNS, NUM_TO_WIN, NUM_PLAYERS>::makeMove(uint8_t row, uint8_t column)
 {
 	bool successfulMove;
 
@@ -53,12 +54,36 @@ bool MTT_Board::makeMove(uint8_t row, uint8_t column)
 		//If the above check failed, then the move is invalid. No need to advance the game state.
 		if (successfulMove)
 		{
+			/*The move wins iff it was played on one of the turn player's winning squares.
+			 *Check before the token goes down, since the square stops being a threat once it is filled.*/
+			Bitboard bit = squareBit(position);
+			s_t player = tokenIndex(turnPlayer);
+			bool winningMove = threatBoards[player] & bit;
+			MTT_COUNT(STAT_WIN_CHECKS);
+
+			//Remember what undoLastMove() will need to put back.
+			MoveRecord& record = history[historySize++];
+			record.square = position.row * COLUMNS + position.col;
+			record.player = player;
+			record.turnPlayer = turnPlayer;
+			for (s_t index = 0; index < NUM_PLAYERS; index++)
+			{
+				record.threats[index] = threatBoards[index];
+			}
+
 			//Increase the move count, then actually place the token.
 			numberOfMoves++;
 			placeToken(position, turnPlayer);
 
+			//The square is no longer a threat for anyone, but may have created new threats for the turn player.
+			for (s_t index = 0; index < NUM_PLAYERS; index++)
+			{
+				threatBoards[index] &= Bitboard(~bit);
+			}
+			addThreats(player, position.row * COLUMNS + position.col);
+
 			/*Check if the turn player won with that last move.*/
-			if (isWinningMove(position))
+			if (winningMove)
 			{
 				gameOver = true;
 				victor = turnPlayer;
@@ -76,85 +101,73 @@ bool MTT_Board::makeMove(uint8_t row, uint8_t column)
 			/*Now that the hypothetical winner has been determined,
 			 *we can advance the turn player.*/
 			s_t playerIndex = (numberOfMoves) % NUM_PLAYERS;
-			turnPlayer = players[playerIndex];
+			setTurnPlayer(players[playerIndex]);
+			MTT_COUNT(STAT_MAKE_MOVES);
 		}
 	}
 	return successfulMove;
 }
 
 
-/*Returns a string representation of the board state.
- *Scrolls through each row on the board, depicting the contents of each square,
+template <uint8_t ROWS, uint8_t COLUMNS, uint8_t NUM_TO_WIN, s_t NUM_PLAYERS>
+std::string MTT_Board<ROWS, COLUMNS, NUM_TO_WIN, NUM_PLAYERS>::getBoardPosition() const
+{
+	char buffer[MAX_POSITION_LENGTH];
+	return std::string(buffer, writeBoardPosition(buffer));
+}
+
+
+/*Scrolls through each row on the board, depicting the contents of each square,
  *and the number of empty spaces inbetween.*/
-std::string MTT_Board::getBoardPosition() const
+template <uint8_t ROWS, uint8_t COLUMNS, uint8_t NUM_TO_WIN, s_t NUM_PLAYERS>
+s_t MTT_Board<ROWS, COLUMNS, NUM_TO_WIN, NUM_PLAYERS>::writeBoardPosition(char* buffer) const
 {
-	Position curSquare;
-	std::string boardPosition = "";
-	int numberOfBlanks;
-	Token token;
+	char* next = buffer;
+	Bitboard occupied = occupiedSquares();
 
-	for (curSquare.row = 0; curSquare.row < ROWS; curSquare.row++)
+	for (s_t row = 0; row < ROWS; row++)
 	{
-		/*Bulk of the algorithm; figure out where all of the tokens are.
-		 *If the box is empty, add to the counter of empty spaces.
-		 *If square is not empty, add the previous number of empty squares, (if not 0),
-		 *and the contents of the square to the position string.*/
-		numberOfBlanks = 0;
-		for (curSquare.col = 0; curSquare.col < COLUMNS; curSquare.col++)
+		/*If the square is empty, add to the counter of empty spaces.
+		 *If not, write the previous number of empty squares, (if not 0), and the contents of the square.*/
+		uint8_t numberOfBlanks = 0;
+		for (s_t col = 0; col < COLUMNS; col++)
 		{
-			token = getToken(curSquare);
-			switch (token)
+			Bitboard bit = Geometry::squareBit(row * COLUMNS + col);
+			if (!(occupied & bit))
 			{
-				//Non-empty square; print the contents, as well as the number of blanks before it.
-				case X:
-				case O:
-				case Y:
-					//If `numberOfBlanks` is 0, then the last square wasn't empty.
-					//In that case, no need to append the number of preceding blanks.
-					if (numberOfBlanks != 0)
-					{
-						boardPosition += std::to_string(numberOfBlanks);
-						numberOfBlanks = 0;
-					}
-
-					//Now grab the appropriate character for the token, and append it to the string.
-					boardPosition += token;
-					break;
-
-				//Empty square, Don't add anythig to the string, unless we're on the last column.
-				case NONE:
-					numberOfBlanks++;
+				numberOfBlanks++;
+				continue;
+			}
 
-					//Special case where the last square on the row hasn't been filled yet.
-					if (curSquare.col == COLUMNS-1)
-					{
-						boardPosition += std::to_string(numberOfBlanks);
-					}
-					break;
+			next = writeBlanks(next, numberOfBlanks);
+			numberOfBlanks = 0;
 
-				default:
-					throw std::logic_error("Someone drew something weird on this board.");
-					break;
+			s_t player = 0;
+			while (!(playerBoards[player] & bit))
+			{
+				player++;
 			}
+			*next++ = players[player];
 		}
+		next = writeBlanks(next, numberOfBlanks);
 
 		/*Separate each row by a slash. No need to do it on the last row*/
-		if (!(curSquare.row == (ROWS-1)))
+		if (row != ROWS - 1)
 		{
-			boardPosition += '/';
+			*next++ = '/';
 		}
 	}
 
-	/*Lastly, Append the turn player to the board position string.
-	 *Make sure it is separated by a space from the token section.*/
-	boardPosition += ' ';
-	boardPosition += turnPlayer;
+	/*Lastly, append the turn player, separated by a space from the token section.*/
+	*next++ = ' ';
+	*next++ = turnPlayer;
 
-	return boardPosition;
+	return next - buffer;
 }
 
 
-bool MTT_Board::undoMove(uint8_t row, uint8_t col)
+template <uint8_t ROWS, uint8_t COLUMNS, uint8_t NUM_TO_WIN, s_t NUM_PLAYERS>
+bool MTT_Board<ROWS, COLUMNS, NUM_TO_WIN, NUM_PLAYERS>::undoMove(uint8_t row, uint8_t col)
 {
 	Position target = {row, col};
 	if (!(this->boxInBounds(target)))
@@ -162,8 +175,13 @@ bool MTT_Board::undoMove(uint8_t row, uint8_t col)
 		return false;
 	}
 
-	//Use modulo stuff to determine the previous player.
-	s_t playerIndex = (numberOfMoves-1) % NUM_PLAYERS;
+	if (numberOfMoves == 0)
+	{
+		return false;
+	}
+
+	//The last move made records who made it. Otherwise, use modulo stuff to determine the previous player.
+	s_t playerIndex = (historySize > 0) ? history[historySize - 1].player : (numberOfMoves-1) % NUM_PLAYERS;
 	Token prevPlayer = players[playerIndex];
 
 	if (prevPlayer != getToken(target))
@@ -171,25 +189,80 @@ bool MTT_Board::undoMove(uint8_t row, uint8_t col)
 		return false;
 	}
 
-	//At this point, the function is successful.
-	this->placeToken(target, ' ');
+	//The usual case, (taking back the last move), doesn't need anything rebuilt.
+	if (historySize > 0 && history[historySize - 1].square == row * COLUMNS + col)
+	{
+		return undoLastMove();
+	}
+
+	/*Some other token of the previous player's is being taken away,
+	 *so the history no longer leads to this position, and everything has to be worked out again.
+	 *The position may even still be won, if the token wasn't part of the winning line.*/
+	Bitboard boards[NUM_PLAYERS];
+	for (s_t player = 0; player < NUM_PLAYERS; player++)
+	{
+		boards[player] = playerBoards[player];
+	}
+	boards[playerIndex] &= Bitboard(~squareBit(target));
+	setPosition(boards, prevPlayer);
+	MTT_COUNT(STAT_UNDO_MOVES);
+
+	return true;
+}
+
+
+template <uint8_t ROWS, uint8_t COLUMNS, uint8_t NUM_TO_WIN, s_t NUM_PLAYERS>
+bool MTT_Board<ROWS, COLUMNS, NUM_TO_WIN, NUM_PLAYERS>::undoLastMove()
+{
+	if (historySize == 0)
+	{
+		return false;
+	}
+
+	const MoveRecord& record = history[--historySize];
+	MTT_COUNT(STAT_UNDO_MOVES);
+
+	playerBoards[record.player] &= Bitboard(~Geometry::squareBit(record.square));
+	toggleHash(record.player, record.square);
 	numberOfMoves--;
-	turnPlayer = prevPlayer;
+	setTurnPlayer(record.turnPlayer);
 
-	/*I had some difficulty deciding whether to do this,
-	 *but then I realized that the way I was using this,
-	 *undoMove would never be used on a won board to undo a move
-	 *that wasn't winning.*/
+	for (s_t player = 0; player < NUM_PLAYERS; player++)
+	{
+		threatBoards[player] = record.threats[player];
+	}
+
+	//Moves can't be made once the game is over, so there was no winner before this one.
 	gameOver = false;
+	victor = NONE;
 
-	//Function is always successful when reaching this point, so
 	return true;
 }
 
 
+/*Tries every symmetry, keeping whichever one packs into the smallest key.*/
+template <uint8_t ROWS, uint8_t COLUMNS, uint8_t NUM_TO_WIN, s_t NUM_PLAYERS>
+auto MTT_Board<ROWS, COLUMNS, NUM_TO_WIN, NUM_PLAYERS>::canonical() const -> CanonicalPosition
+{
+	CanonicalPosition best {packKey(IDENTITY), IDENTITY};
+
+	for (uint8_t symmetry = 1; symmetry < NUM_SYMMETRIES; symmetry++)
+	{
+		PositionKey key = packKey(static_cast<Symmetry>(symmetry));
+		if (key < best.key)
+		{
+			best = {key, static_cast<Symmetry>(symmetry)};
+		}
+	}
+
+	return best;
+}
+
+
 //Private functions
 //-------------------------------------------------------------------------------------------------
-bool MTT_Board::boxInBounds(Position target) const
+template <uint8_t ROWS, uint8_t COLUMNS, uint8_t NUM_TO_WIN, s_t NUM_PLAYERS>
+bool MTT_Board<ROWS, COLUMNS, NUM_TO_WIN, NUM_PLAYERS>::boxInBounds(Position target) const
 {
 	bool goodRow = (target.row >= 0) && (target.row < ROWS);
 	bool goodCol = (target.col >= 0) && (target.col < COLUMNS);
@@ -197,282 +270,386 @@ bool MTT_Board::boxInBounds(Position target) const
 	return (goodRow && goodCol);
 }
 
-bool MTT_Board::isWinningMove(Position targetPos)
+/*A player threatens a line once it holds every square of the line but one,
+ *and that last square is still empty.*/
+template <uint8_t ROWS, uint8_t COLUMNS, uint8_t NUM_TO_WIN, s_t NUM_PLAYERS>
+void MTT_Board<ROWS, COLUMNS, NUM_TO_WIN, NUM_PLAYERS>::addThreats(s_t player, s_t square)
 {
-	assert(boxInBounds(targetPos));
-
-
-	bool verticalWin = traceLine(targetPos, 1, 0);		//Vertical; row changes, column doesn't.
-	bool horizontalWin = traceLine(targetPos, 0, 1);	//Horizontal; Column changes, row doesn't.
-	bool upDiagWin = traceLine(targetPos, -1, 1);		//Down and to the right.
-	bool downDiagWin = traceLine(targetPos, 1, 1);		//Up and to the right.
+	Bitboard empty = emptySquares();
 
-	return (verticalWin || horizontalWin || upDiagWin || downDiagWin);
+	for (uint8_t index = 0; index < Geometry::WIN_LINES.numThroughSquare[square]; index++)
+	{
+		Bitboard missing = Geometry::WIN_LINES.throughSquare[square][index] & Bitboard(~playerBoards[player]);
+		if (isSingleSquare(missing) && (missing & empty))
+		{
+			threatBoards[player] |= missing;
+		}
+	}
 }
 
 
-/*Searches for N-in-a-row pattern by "drawing" 2 lines
- *emanating from the target square in opposite directions
- *and scanning them for matching symbols.
- *Lines stop emanating once a non-matching symbol is found, or line goes out of bounds.*/
-bool MTT_Board::traceLine(Position targetPos, int rowIncrease, int colIncrease) const
+template <uint8_t ROWS, uint8_t COLUMNS, uint8_t NUM_TO_WIN, s_t NUM_PLAYERS>
+void MTT_Board<ROWS, COLUMNS, NUM_TO_WIN, NUM_PLAYERS>::recomputeThreats()
 {
-	bool result = false;			//Flag for whether or not a complete line has been found
-									//Start by assuming it isn't.
+	Bitboard empty = emptySquares();
 
-	int16_t rowDistance, colDistance;	//Distance between checked square and target.
-	Position checkPos;				//Coordinates for the current square to be checked.
-	uint8_t numInARow = 1;
+	for (s_t player = 0; player < NUM_PLAYERS; player++)
+	{
+		threatBoards[player] = 0;
+		for (uint8_t index = 0; index < Geometry::WIN_LINES.numLines; index++)
+		{
+			Bitboard missing = Geometry::WIN_LINES.lines[index] & Bitboard(~playerBoards[player]);
+			if (isSingleSquare(missing) && (missing & empty))
+			{
+				threatBoards[player] |= missing;
+			}
+		}
+	}
+}
 
-	//flags for checking in either direction.
-	bool checkForwardLine = true;
-	bool checkBackwardLine = true;
 
-	Token targetSymbol = getToken(targetPos);	//Symbol each square will be compared to.
+/*Walks the string once, keeping track of the square the next token lands on.
+ *Tokens only ever go into `boards`, so a rejected string leaves no trace anywhere.*/
+template <uint8_t ROWS, uint8_t COLUMNS, uint8_t NUM_TO_WIN, s_t NUM_PLAYERS>
+ParseError MTT_Board<ROWS, COLUMNS, NUM_TO_WIN, NUM_PLAYERS>::parsePosition(std::string_view boardPosition,
+	Bitboard boards[NUM_PLAYERS], Token& turn)
+{
+	for (s_t player = 0; player < NUM_PLAYERS; player++)
+	{
+		boards[player] = 0;
+	}
 
-	/*Check each square above the target, until either a square is found not matching the target,
-	 *search goes out of bounds, or distance from target becomes so great as to not matter.
-	 *Exit function early if the number of matches found equals a win.*/
-	for (rowDistance = rowIncrease, colDistance = colIncrease;
-		 (((uint16_t) abs(rowDistance)) < NUM_TO_WIN) && (((uint16_t) abs(colDistance)) < NUM_TO_WIN);
-		 rowDistance+=rowIncrease, colDistance+=colIncrease)
+	enum State { FILL_BOARD, GET_TURN, DONE };
+	State curState = FILL_BOARD;
+	s_t row = 0;
+	s_t squaresFilled = 0;
+	s_t consecutiveBlanks = 0;
+
+	for (char curChar : boardPosition)
 	{
-		/*If both lines have been cut, then there's no need to continue checking.*/
-		if (!(checkForwardLine || checkBackwardLine))
+		if (curState == DONE)
 		{
-			result = false;
-			break;
+			return ParseError::TRAILING_CHARACTERS;
 		}
 
-		/*Check the next square in one direction.
-		 *Will not execute if line has gone out of bounds, or encountered non-matching symbol.*/
-		if (checkForwardLine)
+		switch (curChar)
 		{
-			checkPos.row = targetPos.row + rowDistance;
-			checkPos.col = targetPos.col + colDistance;
+			/*In the FILL_BOARD state, the character represents a token.
+			 *Make sure the row has enough space for unplaced blanks and the token, then place it.
+			 *In the GET_TURN state, it is the turn player.*/
+			case 'X':
+			case 'O':
+			case 'Y':
+				if (tokenIndex(curChar) >= NUM_PLAYERS)
+				{
+					return ParseError::ILLEGAL_CHARACTER;
+				}
+				if (curState == GET_TURN)
+				{
+					turn = static_cast<Token>(curChar);
+					curState = DONE;
+					break;
+				}
+				if (squaresFilled + consecutiveBlanks + 1 > COLUMNS)
+				{
+					return ParseError::ROW_OVERFLOW;
+				}
+				squaresFilled += consecutiveBlanks;
+				consecutiveBlanks = 0;
+				boards[tokenIndex(curChar)] |= Geometry::squareBit(row * COLUMNS + squaresFilled);
+				squaresFilled++;
+				break;
 
-			checkForwardLine = checkLineForMatch(checkPos, targetSymbol,
-				numInARow);
+			//In the FILL_BOARD state, update the number of blanks.
+			case '0':
+			case '1':
+			case '2':
+			case '3':
+			case '4':
+			case '5':
+			case '6':
+			case '7':
+			case '8':
+			case '9':
+				if (curState != FILL_BOARD)
+				{
+					return ParseError::UNEXPECTED_DIGIT;
+				}
+				consecutiveBlanks = consecutiveBlanks * 10 + (curChar - '0');
+				//Checked straight away, so a long run of digits can't overflow the count.
+				if (squaresFilled + consecutiveBlanks > COLUMNS)
+				{
+					return ParseError::ROW_OVERFLOW;
+				}
+				break;
 
-			if (numInARow == NUM_TO_WIN)
-			{
-				result = true;
+			/*In the FILL_BOARD state, make sure every square in the row is accounted for,
+			 *and that more rows remain, then move on to the next row.*/
+			case '/':
+				if (curState != FILL_BOARD)
+				{
+					return ParseError::UNEXPECTED_SLASH;
+				}
+				if (squaresFilled + consecutiveBlanks != COLUMNS || row == ROWS - 1)
+				{
+					return ParseError::ROW_INCOMPLETE;
+				}
+				row++;
+				squaresFilled = 0;
+				consecutiveBlanks = 0;
 				break;
-			}
+
+			//In the FILL_BOARD state, make sure every square on the board is accounted for.
+			case ' ':
+				if (curState != FILL_BOARD)
+				{
+					return ParseError::UNEXPECTED_SPACE;
+				}
+				if (row != ROWS - 1 || squaresFilled + consecutiveBlanks != COLUMNS)
+				{
+					return ParseError::BOARD_INCOMPLETE;
+				}
+				curState = GET_TURN;
+				break;
+
+			default:
+				return ParseError::ILLEGAL_CHARACTER;
 		}
+	}
+
+	switch (curState)
+	{
+		case DONE:
+			return ParseError::OK;
+		case GET_TURN:
+			return ParseError::MISSING_TURN_PLAYER;
+		default:
+			return ParseError::BOARD_INCOMPLETE;
+	}
+}
 
-		//Perform the same operations in the other direction.
-		if (checkBackwardLine)
+
+template <uint8_t ROWS, uint8_t COLUMNS, uint8_t NUM_TO_WIN, s_t NUM_PLAYERS>
+s_t MTT_Board<ROWS, COLUMNS, NUM_TO_WIN, NUM_PLAYERS>::countWinners(const Bitboard boards[NUM_PLAYERS], Token& winner)
+{
+	s_t numWinners = 0;
+	winner = NONE;
+
+	for (s_t player = 0; player < NUM_PLAYERS; player++)
+	{
+		MTT_COUNT(STAT_WIN_CHECKS);
+		if (Geometry::hasLine(boards[player]))
 		{
-			checkPos.row = targetPos.row - rowDistance;
-			checkPos.col = targetPos.col - colDistance;
+			numWinners++;
+			winner = players[player];
+		}
+	}
+	return numWinners;
+}
 
-			checkBackwardLine = checkLineForMatch(checkPos, targetSymbol,
-				numInARow);
 
-			if (numInARow == NUM_TO_WIN)
-			{
-				result = true;
-				break;
-			}
+template <uint8_t ROWS, uint8_t COLUMNS, uint8_t NUM_TO_WIN, s_t NUM_PLAYERS>
+void MTT_Board<ROWS, COLUMNS, NUM_TO_WIN, NUM_PLAYERS>::setPosition(const Bitboard boards[NUM_PLAYERS], Token turn)
+{
+	numberOfMoves = 0;
+	historySize = 0;
+	turnPlayer = turn;
+	resetHash(turn);
+
+	for (s_t player = 0; player < NUM_PLAYERS; player++)
+	{
+		playerBoards[player] = boards[player];
+		numberOfMoves += popCount(boards[player]);
+
+		Bitboard tokens = boards[player];
+		while (tokens)
+		{
+			toggleHash(player, lowestBit(tokens));
+			tokens &= tokens - 1;
 		}
 	}
 
-	return result;
+	//Any complete line means that player has won.
+	gameOver = countWinners(boards, victor) > 0 || numberOfMoves == (ROWS * COLUMNS);
+
+	recomputeThreats();
 }
 
 
-/**/
-bool MTT_Board::checkLineForMatch(Position checkPos, char targetSymbol,
-								uint8_t& numInARow) const
+template <uint8_t ROWS, uint8_t COLUMNS, uint8_t NUM_TO_WIN, s_t NUM_PLAYERS>
+void MTT_Board<ROWS, COLUMNS, NUM_TO_WIN, NUM_PLAYERS>::setBoard(std::string_view boardPosition)
 {
-	if ((boxInBounds(checkPos))
-		&& (getToken(checkPos) == targetSymbol))
+	ParseError error = trySetBoard(boardPosition);
+	if (error != ParseError::OK)
 	{
-		numInARow++;
-		return true;
+		throw std::invalid_argument(describeParseError(error));
 	}
-	else
+}
+
+
+template <uint8_t ROWS, uint8_t COLUMNS, uint8_t NUM_TO_WIN, s_t NUM_PLAYERS>
+ParseError MTT_Board<ROWS, COLUMNS, NUM_TO_WIN, NUM_PLAYERS>::trySetBoard(std::string_view boardPosition)
+{
+	Bitboard boards[NUM_PLAYERS];
+	Token turn;
+	Token winner;
+
+	ParseError error = parsePosition(boardPosition, boards, turn);
+	if (error == ParseError::OK && countWinners(boards, winner) > 1)
 	{
-		return false;
+		error = ParseError::MULTIPLE_WINNERS;
+	}
+
+	if (error == ParseError::OK)
+	{
+		setPosition(boards, turn);
 	}
+	return error;
 }
 
 
-void MTT_Board::placeSpaces(Position position, uint8_t spaces)
+template <uint8_t ROWS, uint8_t COLUMNS, uint8_t NUM_TO_WIN, s_t NUM_PLAYERS>
+ParseError MTT_Board<ROWS, COLUMNS, NUM_TO_WIN, NUM_PLAYERS>::parseKey(std::string_view boardPosition, PositionKey& key)
 {
-	for (s_t space = 0; space < spaces; space++)
+	Bitboard boards[NUM_PLAYERS];
+	Token turn;
+	Token winner;
+
+	ParseError error = parsePosition(boardPosition, boards, turn);
+	if (error == ParseError::OK && countWinners(boards, winner) > 1)
+	{
+		error = ParseError::MULTIPLE_WINNERS;
+	}
+
+	if (error == ParseError::OK)
 	{
-		placeToken(position, NONE);
-		position.col++;
+		key = packBoards(boards, turn);
 	}
+	return error;
 }
 
 
-void MTT_Board::setBoard(const std::string boardPosition)
+template <uint8_t ROWS, uint8_t COLUMNS, uint8_t NUM_TO_WIN, s_t NUM_PLAYERS>
+void MTT_Board<ROWS, COLUMNS, NUM_TO_WIN, NUM_PLAYERS>::setKey(PositionKey key)
 {
-	//Assume we're starting from a fresh new board.
-	numberOfMoves = 0;
-	gameOver = false;
-
-	//Local variables for this function specifically.
-	enum State { FILL_BOARD, GET_TURN };
-	State curState = FILL_BOARD;
-	Position curPos{0, 0};
-	bool positionComplete = false;
-	uint16_t squaresFilled = 0;
-	uint16_t totalSquares = 0;
-	uint8_t consecutiveBlanks = 0;
-	char curChar;
-
-	//Analyze the portion of the string which depicts the placement of tokens on the board.
-	for (s_t index = 0; index < boardPosition.size(); index++)
+	s_t turnIndex = s_t(key >> (NUM_PLAYERS * NUM_SQUARES));
+	if (turnIndex >= NUM_PLAYERS)
 	{
-		curChar = boardPosition[index];
+		throw std::invalid_argument("Invalid key; no such turn player.");
+	}
 
-		if (positionComplete)
+	Bitboard boards[NUM_PLAYERS];
+	Bitboard occupied = 0;
+	for (s_t player = 0; player < NUM_PLAYERS; player++)
+	{
+		boards[player] = Bitboard(key >> (player * NUM_SQUARES)) & Geometry::ALL_SQUARES;
+		if (boards[player] & occupied)
 		{
-			throw std::invalid_argument("Unexpected characters after Turn Player token.");
+			throw std::invalid_argument("Invalid key; two tokens share a square.");
 		}
-		else
-		{
-			switch (curChar)
-			{
+		occupied |= boards[player];
+	}
 
-				case 'X':
-				case 'O':
-				case 'Y':
-					switch (curState)
-					{
-						/*In this case, the character represents a token,
-						 *make sure curPos is in bounds.
-						 *If it is, check to make sure the row has enough space for unplaced blanks and the current token.
-						 *If it does, place said spaces and the token on the board in the correct positions,
-						 *and prepare the loop to move on to the next column.
-						 *If not, throw an exception.*/
-						case FILL_BOARD:
-							if ((squaresFilled + consecutiveBlanks + 1) <= COLUMNS)
-							{
-								/*Place any spaces that may be there,
-								 *and update local variables to reflect this.*/
-								placeSpaces(curPos, consecutiveBlanks);
-								squaresFilled += consecutiveBlanks;
-								totalSquares += consecutiveBlanks;
-								curPos.col += consecutiveBlanks;
-
-								/*Place the indicated token on the board,
-								 *updating object and local variables.*/
-								placeToken(curPos, curChar);
-								curPos.col++;
-								numberOfMoves++;
-								squaresFilled++;
-								totalSquares++;
-								consecutiveBlanks = 0;
-							}
-							else
-							{
-								throw std::invalid_argument("Invalid position; Indicated tokens do not fit on row.");
-							}
-							break;
-
-						//Set the turn player, and set the positionComplete flag.
-						case GET_TURN:
-							turnPlayer = static_cast<Token>(curChar);
-							positionComplete = true;
-							break;
-
-						default:
-							throw std::logic_error("This shouldn't be possible.");
-					}
-					break;
+	Token winner;
+	if (countWinners(boards, winner) > 1)
+	{
+		throw std::invalid_argument(describeParseError(ParseError::MULTIPLE_WINNERS));
+	}
+	setPosition(boards, players[turnIndex]);
+}
 
-				/*In the FILL_BOARD state, update the number of blanks.
-				 *In all other states, throw an exception.*/
-				case '0':
-				case '1':
-				case '2':
-				case '3':
-				case '4':
-				case '5':
-				case '6':
-				case '7':
-				case '8':
-				case '9':
-					switch (curState)
-					{
-						case FILL_BOARD:
-							consecutiveBlanks *= 10;
-							consecutiveBlanks += (curChar-48);	//Convert from a character representing a digit to the number.
-							break;
-
-						default:
-							throw std::invalid_argument("Invalid string; integer character in unexpected location.");
-					}
-					break;
 
-				/*In the FILL_BOARD state, first make sure all squares in the row have either all been filled,
-				 *or been shown to be blank.
-				 *Next, make sure more rows remain.
-				 *If they do, fill in any unmarked blanks and move on to the next row.
-				 *If not, or if not in the FILL_BOARD state, throw an exception.*/
-				case '/':
-					switch (curState)
-					{
-						case FILL_BOARD:
-							//I subtract 1 from ROWS because I'm comparing it to an index.
-							if ((squaresFilled+consecutiveBlanks) == COLUMNS && curPos.row < (ROWS-1))
-							{
-								/*Place any blanks that may be there.*/
-								placeSpaces(curPos, consecutiveBlanks);
-								squaresFilled += consecutiveBlanks;
-								totalSquares += consecutiveBlanks;
-								consecutiveBlanks = 0;
-
-								//Move on to the next row.
-								curPos.row++;
-								curPos.col = 0;
-								squaresFilled = 0;
-							}
-							else
-							{
-								throw std::invalid_argument("Invalid string; not all squares in row accounted for.");
-							}
-							break;
-
-						default:
-							throw std::invalid_argument("Invalid string; slash character in unexpected location.");
-					}
-					break;
+const char* describeParseError(ParseError error)
+{
+	switch (error)
+	{
+		case ParseError::OK:
+			return "No error.";
+		case ParseError::ILLEGAL_CHARACTER:
+			return "Invalid position string; illegal character detected.";
+		case ParseError::ROW_OVERFLOW:
+			return "Invalid position; Indicated tokens do not fit on row.";
+		case ParseError::ROW_INCOMPLETE:
+			return "Invalid string; not all squares in row accounted for.";
+		case ParseError::BOARD_INCOMPLETE:
+			return "Invalid position string; not all squares on row are accounted for.";
+		case ParseError::UNEXPECTED_DIGIT:
+			return "Invalid string; integer character in unexpected location.";
+		case ParseError::UNEXPECTED_SLASH:
+			return "Invalid string; slash character in unexpected location.";
+		case ParseError::UNEXPECTED_SPACE:
+			return "Invalid position string; space character in unexpected location.";
+		case ParseError::MISSING_TURN_PLAYER:
+			return "Invalid position string; no turn player given.";
+		case ParseError::TRAILING_CHARACTERS:
+			return "Unexpected characters after Turn Player token.";
+		case ParseError::MULTIPLE_WINNERS:
+			return "Invalid position; more than one player has won.";
+	}
+	return "Unknown error.";
+}
 
-				/*In FILL_BOARD state, make sure any unplaced spaces will completely fill the board.
-				 *If they do, place said spaces, and change curState to GET_TURN.
-				 *If not, throw an exception.
-				 *In any other state, throw an exception.*/
-				case ' ':
-					switch (curState)
-					{
-						case FILL_BOARD:
-							if (totalSquares + consecutiveBlanks == (ROWS*COLUMNS))
-							{
-								placeSpaces(curPos, consecutiveBlanks);
-								curState = GET_TURN;
-							}
-							else
-							{
-								throw std::invalid_argument("Invalid position string; not all squares on row are accounted for.");
-							}
-							break;
-
-						default:
-							throw std::invalid_argument("Invalid position string; space character in unexpected location.");
-					}
-					break;
 
-				/*If the character is anything else, throw an exception.*/
-				default:
-					throw std::invalid_argument("Invalid position string; illegal character detected.");
-					break;
+bool boardSizeOf(std::string_view boardPosition, uint8_t& rows, uint8_t& columns)
+{
+	rows = 1;
+	columns = 0;
+	bool firstRow = true;
+
+	//Count the slashes in the token field, and the squares described before the first one.
+	for (s_t index = 0; index < boardPosition.size() && boardPosition[index] != ' '; index++)
+	{
+		char curChar = boardPosition[index];
+		if (curChar == '/')
+		{
+			rows++;
+			firstRow = false;
+		}
+		else if (firstRow && curChar >= '0' && curChar <= '9')
+		{
+			//Multi-digit runs of blanks are rare, but handle them anyway.
+			uint8_t blanks = curChar - '0';
+			while (index + 1 < boardPosition.size() && boardPosition[index + 1] >= '0' && boardPosition[index + 1] <= '9')
+			{
+				blanks = blanks * 10 + (boardPosition[++index] - '0');
 			}
+			columns += blanks;
+		}
+		else if (firstRow)
+		{
+			columns++;
 		}
 	}
+
+	return columns > 0;
 }
+
+
+bool parseBoardSize(std::string_view size, uint8_t& rows, uint8_t& columns)
+{
+	//Each half has to be a whole number from 1 to 255, with nothing else around it.
+	auto readLength = [](std::string_view text, unsigned& length)
+	{
+		std::from_chars_result read = std::from_chars(text.data(), text.data() + text.size(), length);
+		return read.ec == std::errc() && read.ptr == text.data() + text.size() && length > 0 && length <= UINT8_MAX;
+	};
+
+	s_t separator = size.find('x');
+	unsigned readRows = 0;
+	unsigned readColumns = 0;
+	if (separator == std::string_view::npos
+		|| !readLength(size.substr(0, separator), readRows) || !readLength(size.substr(separator + 1), readColumns))
+	{
+		return false;
+	}
+
+	rows = readRows;
+	columns = readColumns;
+	return true;
+}
+
+
+//Every board variant the project uses. See the typedefs at the bottom of mtt_board.hpp.
+template class MTT_Board<3, 5, 3, 3>;
+template class MTT_Board<4, 4, 3, 3>;
+template class MTT_Board<5, 5, 3, 3>;
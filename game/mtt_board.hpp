@@ -1,19 +1,57 @@
 #ifndef MTT_BOARD_HPP
 #define MTT_BOARD_HPP
 #include <string>
+#include <string_view>
 #include <array>
 #include <unordered_set>
+#include <functional>
+#include <compare>
 #include <stdexcept>
 #include <cassert>
-typedef std::size_t s_t;
+#include <cstdint>
+#include "board_geometry.hpp"
+#include "search_stats.hpp"
 
 
-const s_t NUM_PLAYERS = 3;
-const uint8_t ROWS = 3;
-const uint8_t COLUMNS = 5;
-const uint8_t NUM_TO_WIN = 3;
 enum Token{X = 'X', O = 'O', Y = 'Y', NONE = ' '};
-const Token players[] = {X, O, Y, NONE};
+
+
+/*Lists the players of a NUM_PLAYERS player game in turn order, followed by NONE.*/
+template <s_t NUM_PLAYERS>
+constexpr std::array<Token, NUM_PLAYERS + 1> buildPlayers()
+{
+	const Token allPlayers[] = {X, O, Y};
+	std::array<Token, NUM_PLAYERS + 1> players{};
+	for (s_t index = 0; index < NUM_PLAYERS; index++)
+	{
+		players[index] = allPlayers[index];
+	}
+	players[NUM_PLAYERS] = NONE;
+	return players;
+}
+
+
+/*Why a position string could not be read, as returned by the non-throwing parsers,
+ *(MTT_Board::trySetBoard() and MTT_Board::parseKey()).
+ *describeParseError() gives the message the throwing versions use.*/
+enum class ParseError : uint8_t
+{
+	OK,
+	ILLEGAL_CHARACTER,
+	ROW_OVERFLOW,
+	ROW_INCOMPLETE,
+	BOARD_INCOMPLETE,
+	UNEXPECTED_DIGIT,
+	UNEXPECTED_SLASH,
+	UNEXPECTED_SPACE,
+	MISSING_TURN_PLAYER,
+	TRAILING_CHARACTERS,
+	MULTIPLE_WINNERS
+};
+
+
+/*Returns a human readable description of `error`.*/
+const char* describeParseError(ParseError error);
 
 
 /*Represents a specific square inside the game board, noted by its row and column.*/
@@ -21,25 +59,83 @@ struct Position
 {
 	uint8_t row;
 	uint8_t col;
+
+	friend constexpr bool operator==(const Position&, const Position&) = default;
+	friend constexpr auto operator<=>(const Position&, const Position&) = default;
 };
 
 
+template <>
+struct std::hash<Position>
+{
+	std::size_t operator()(Position position) const noexcept
+	{
+		return (std::size_t(position.row) << 8) | position.col;
+	}
+};
+
+
+/*A Moe-Tac-Toe board of any size, for any number of players, (up to 3).
+ *Every table the board relies on is generated at compile time for its geometry,
+ *so each variant gets its own fully specialized code.
+ *Member functions are defined in mtt_board.cpp, and only the variants instantiated there,
+ *(see the typedefs at the bottom of this file), can be used.*/
+template <uint8_t ROWS = 3, uint8_t COLUMNS = 5, uint8_t NUM_TO_WIN = 3, s_t NUM_PLAYERS = 3>
 class MTT_Board
 {
+	public:
+		typedef BoardGeometry<ROWS, COLUMNS, NUM_TO_WIN, NUM_PLAYERS> Geometry;
+		typedef typename Geometry::Bitboard Bitboard;
+		typedef typename Geometry::PositionKey PositionKey;
+		static constexpr uint8_t NUM_SQUARES = Geometry::NUM_SQUARES;
+		static constexpr uint8_t NUM_SYMMETRIES = Geometry::NUM_SYMMETRIES;
+
+
+		/*Every player in turn order, followed by NONE.*/
+		static constexpr std::array<Token, NUM_PLAYERS + 1> players = buildPlayers<NUM_PLAYERS>();
+
+
+		/*A position's smallest key out of all of its symmetric copies,
+		 *along with the symmetry that turns the position into that copy.
+		 *A move on the canonical copy maps back to the original board with inverseSymmetry(symmetry).*/
+		struct CanonicalPosition
+		{
+			PositionKey key;
+			Symmetry symmetry;
+		};
+
+
+		/*Returns the player who moves after the given player.*/
+		static Token nextPlayer(Token player)
+		{
+			return players[(tokenIndex(player) + 1) % NUM_PLAYERS];
+		}
+
+
 	private:
-		/*Each element of this 2D array represents a square in the game board.
-		 *The indexes for the rows start at 0 and increase from top to bottom.
-		 *The indexes for the columns start at 0 and increase from left to right.
-		 *Array access looks like "gameBoard[row][column]".
-		 *As an example, accessing the top-left square looks like "gameBoard[0][0]".
-		 *The state of each square is represented using each player's respective character.*/
-		Token gameBoard[ROWS][COLUMNS];
+		/*One bitboard per player, indexed in turn order, (ie. X, O, then Y).
+		 *A set bit means that player has a token on the corresponding square.
+		 *A square is empty iff its bit is clear in every player's bitboard.*/
+		Bitboard playerBoards[NUM_PLAYERS];
+		
+		
+		/*For each player, in the same order as `playerBoards`, every empty square
+		 *on which a token of theirs would complete a winning line.
+		 *Updated incrementally by makeMove(), restored by undoLastMove(), and rebuilt by setBoard().*/
+		Bitboard threatBoards[NUM_PLAYERS];
 		
 		
 		/*Represents the player whose turn it currently is.*/
 		Token turnPlayer;
 		
 		
+		/*Zobrist hashes of the current position, including the turn player.
+		 *`hashKeys[symmetry]` is the hash of the position after applying that symmetry,
+		 *so `hashKeys[IDENTITY]` is the hash of the position as it stands.
+		 *Kept up to date by placeToken() and setTurnPlayer().*/
+		uint64_t hashKeys[NUM_SYMMETRIES];
+		
+		
 		//Variable representing whether the game has either been won by a player,
 		//or ended in a draw.
 		bool gameOver;
@@ -57,61 +153,202 @@ class MTT_Board
 		uint16_t numberOfMoves;
 		
 		
+		/*What makeMove() changed that can't be worked out again cheaply, so undoLastMove() can put it back.
+		 *A move can only be made while the game isn't over, so there is no need to remember `gameOver` or `victor`;
+		 *undoing a move always leads back to a game in progress.*/
+		struct MoveRecord
+		{
+			Bitboard threats[NUM_PLAYERS];		//`threatBoards` before the move.
+			uint8_t square;
+			uint8_t player;			//Index of the player who moved, (who needn't be the one the move count implies).
+			Token turnPlayer;		//`turnPlayer` before the move.
+		};
+		
+		
+		/*Every move made by makeMove() since the board was last set up, oldest first,
+		 *followed by unused records. Holds `historySize` moves.
+		 *A game never lasts more than NUM_SQUARES moves, so the stack never overflows.*/
+		MoveRecord history[NUM_SQUARES];
+		uint8_t historySize;
+		
+		
 		/*Returns a bool representing whether a target position
 		 *is in bounds. Returns true if it is, returns false if it
 		 *is not.*/
 		bool boxInBounds(Position target) const;
 		
 		
-		/*Helper function called by any function that can alter the board state,
-		 *scpecifically by placing a symbol in the selected square.
-		 *Function is to be called AFTER placing the symbol in the square.
-		 *Thus, the given position will always be in bounds.
-		 *Returns true iff the shape at the selected position creaes a 
-		 *winning three-in-a-row sequence.*/
-		bool isWinningMove(Position targetPos);
+		/*Adds any squares which became winning squares for `player`
+		 *after they placed a token on `square`.
+		 *Only lines passing through `square` can have changed.*/
+		void addThreats(s_t player, s_t square);
 		
 		
-		/*Helper function called by isWinningMove().
-		 *Draws a line emanating from the target position in a given direction
-		 *(ie. horizontal, diagonal, vertical), */
-		bool traceLine(Position targetPos, int rowIncrease, int colIncrease) const;
+		/*Rebuilds every player's winning squares from scratch, by checking every line on the board.*/
+		void recomputeThreats();
 		
 		
-		/*Helper function to handle repeated logic in checkLine().
-		 *Checks the selected square to make sure it matches the target symbol,
-		 *and determines wheteher or not the loop should continue.*/
-		bool checkLineForMatch(Position checkPos, char targetSymbol,
-							 uint8_t& numInARow) const;
+		/*Returns the bit representing the given square inside of a Bitboard.*/
+		static Bitboard squareBit(Position position)
+		{
+			return Geometry::squareBit(position.row * COLUMNS + position.col);
+		}
+		
+		
+		/*Returns true iff exactly one bit of `bitboard` is set.*/
+		static bool isSingleSquare(Bitboard bitboard)
+		{
+			return bitboard != 0 && (bitboard & (bitboard - 1)) == 0;
+		}
+		
+		
+		/*Returns a bitboard of every occupied square.*/
+		Bitboard occupiedSquares() const
+		{
+			Bitboard occupied = 0;
+			for (s_t player = 0; player < NUM_PLAYERS; player++)
+			{
+				occupied |= playerBoards[player];
+			}
+			return occupied;
+		}
 		
 		
 		/*Returns a copy of the symbol indicated at the specified position.
 		 *Created for use in const methods.*/
 		Token getToken(Position position) const
 		{
-			return gameBoard[position.row][position.col];
+			Bitboard bit = squareBit(position);
+			for (s_t player = 0; player < NUM_PLAYERS; player++)
+			{
+				if (playerBoards[player] & bit)
+				{
+					return players[player];
+				}
+			}
+			return NONE;
 		}
 		
 		
 		/*Helper function called by any method that can alter the game board.
 		 *Responsible for actually placing the symbol on the correct spot on the board.
+		 *Placing NONE empties the square.
 		 *Precondition: supplied position is within bounds.*/
 		void placeToken(Position position, char token)
 		{
-			gameBoard[position.row][position.col] = static_cast<Token> (token);
+			Bitboard bit = squareBit(position);
+			s_t square = position.row * COLUMNS + position.col;
+			for (s_t player = 0; player < NUM_PLAYERS; player++)
+			{
+				if (playerBoards[player] & bit)
+				{
+					toggleHash(player, square);
+				}
+				playerBoards[player] &= Bitboard(~bit);
+			}
+			if (token != NONE)
+			{
+				playerBoards[tokenIndex(token)] |= bit;
+				toggleHash(tokenIndex(token), square);
+			}
+		}
+		
+		
+		/*XORs the key for `player` having a token on `square` in or out of every hash.*/
+		void toggleHash(s_t player, s_t square)
+		{
+			for (uint8_t symmetry = 0; symmetry < NUM_SYMMETRIES; symmetry++)
+			{
+				hashKeys[symmetry] ^= Geometry::ZOBRIST.squares[player][Geometry::SYMMETRIES.squares[symmetry][square]];
+			}
+		}
+		
+		
+		/*Resets every hash to that of an empty board with the given turn player.*/
+		void resetHash(Token player)
+		{
+			for (uint8_t symmetry = 0; symmetry < NUM_SYMMETRIES; symmetry++)
+			{
+				hashKeys[symmetry] = Geometry::ZOBRIST.turn[tokenIndex(player)];
+			}
+		}
+		
+		
+		/*Packs the position, after applying `symmetry`, into a PositionKey.*/
+		PositionKey packKey(Symmetry symmetry) const
+		{
+			PositionKey key = PositionKey(tokenIndex(turnPlayer)) << (NUM_PLAYERS * NUM_SQUARES);
+			for (s_t player = 0; player < NUM_PLAYERS; player++)
+			{
+				key |= PositionKey(transformBitboard(playerBoards[player], symmetry)) << (player * NUM_SQUARES);
+			}
+			return key;
 		}
 		
 		
-		/*Helper function which is called by any method which sets up from a provided board position.
-		 *Starting at `position`, places a number of consecutive empty spaces on the board,
-		 *equal to the number represented by `spaces`.
-		 *Relies on calling function to check whether array has enough space.*/
-		void placeSpaces(Position position, uint8_t spaces);
+		/*Changes the turn player, keeping the hash up to date.*/
+		void setTurnPlayer(Token player)
+		{
+			for (uint8_t symmetry = 0; symmetry < NUM_SYMMETRIES; symmetry++)
+			{
+				hashKeys[symmetry] ^= Geometry::ZOBRIST.turn[tokenIndex(turnPlayer)] ^ Geometry::ZOBRIST.turn[tokenIndex(player)];
+			}
+			turnPlayer = player;
+		}
+		
+		
+		/*Writes a run of `blanks` empty squares the way position strings do,
+		 *(nothing at all for zero), and returns where the next character goes.*/
+		static char* writeBlanks(char* next, uint8_t blanks)
+		{
+			if (blanks >= 10)
+			{
+				next = writeBlanks(next, blanks / 10);
+				blanks %= 10;
+			}
+			else if (blanks == 0)
+			{
+				return next;
+			}
+			*next++ = char('0' + blanks);
+			return next;
+		}
+
+
+		/*Reads the token placement and turn player out of a position string,
+		 *without touching any board, so it neither allocates nor throws.
+		 *`boards` is filled in turn order, the same way as `playerBoards`.
+		 *Does not check for multiple winners; see countWinners().*/
+		static ParseError parsePosition(std::string_view boardPosition, Bitboard boards[NUM_PLAYERS], Token& turn);
+		
+		
+		/*Returns how many players have a complete line in `boards`,
+		 *setting `winner` to the last of them, (or NONE if nobody has one).*/
+		static s_t countWinners(const Bitboard boards[NUM_PLAYERS], Token& winner);
+		
+		
+		/*Packs the given tokens and turn player into a PositionKey, the same way as packKey(IDENTITY).*/
+		static PositionKey packBoards(const Bitboard boards[NUM_PLAYERS], Token turn)
+		{
+			PositionKey key = PositionKey(tokenIndex(turn)) << (NUM_PLAYERS * NUM_SQUARES);
+			for (s_t player = 0; player < NUM_PLAYERS; player++)
+			{
+				key |= PositionKey(boards[player]) << (player * NUM_SQUARES);
+			}
+			return key;
+		}
+		
+		
+		/*Replaces the whole position with the given tokens and turn player,
+		 *rebuilding the move count, hashes and winning squares from scratch, and emptying the move history.
+		 *Sets `gameOver` and `victor` if the position is already won or drawn.
+		 *Precondition: no square is held by two players, and at most one player has won.*/
+		void setPosition(const Bitboard boards[NUM_PLAYERS], Token turn);
 	
 	
 	public:
 		//Creates an empty Moe-Tac-Toe board.
-		//3 row-by-5 column grid containing all empty spaces.
+		//ROWS row-by-COLUMNS column grid containing all empty spaces.
 		MTT_Board();
 
 
@@ -123,15 +360,15 @@ class MTT_Board
 		 *shown from left to right.
 		 *The contents of each square is shown as either an X, O, or Y,
 		 *representing players 1, 2, and 3 respectively.
-		 *Similar to FEN, empty squares are noted by the number of consecutive empty squares, ([1-5]),
+		 *Similar to FEN, empty squares are noted by the number of consecutive empty squares, ([1-COLUMNS]),
 		 *and each row is separated by a "/".
 		 *The next field simply shows who the turn player is, that being either X, O, or Y.
 		 *Sets the "gameOver" bit if the supplied position depicts either a player victory or a draw.
-		 *This constructor will throw an Invalid_Position_Exception if the input string
-		 *has invalid formatting, or ends up describing a board which does not fit into a 3x5 grid.
+		 *This constructor will throw std::invalid_argument if the input string
+		 *has invalid formatting, or ends up describing a board which does not fit into a ROWS x COLUMNS grid.
 		 *This constructor does not check if the position is actually attainable in a real game without skipping turns,
 		 *but it does throw an exception if there are multiple winners.*/
-		MTT_Board(const std::string boardPosition);
+		MTT_Board(std::string_view boardPosition);
 
 
 		/*Places an X, O, or Y in the desired square,
@@ -157,23 +394,258 @@ class MTT_Board
 		uint16_t getNumMoves() const { return numberOfMoves; }
 		
 		
+		/*Returns the Zobrist hash of the current position.
+		 *Equal positions with the same turn player always have equal hashes.*/
+		uint64_t getHash() const { return hashKeys[IDENTITY]; }
+		
+		
+		/*Returns the smallest hash out of the position's symmetric copies,
+		 *which is shared by every position that is a reflection or rotation of this one.
+		 *`symmetry` is set to the symmetry which produces the copy with that hash.*/
+		uint64_t getSymmetricHash(Symmetry& symmetry) const
+		{
+			symmetry = IDENTITY;
+			for (uint8_t candidate = 1; candidate < NUM_SYMMETRIES; candidate++)
+			{
+				if (hashKeys[candidate] < hashKeys[symmetry])
+				{
+					symmetry = static_cast<Symmetry>(candidate);
+				}
+			}
+			return hashKeys[symmetry];
+		}
+		
+		
+		/*Returns the current position packed into a single key,
+		 *or the key of its copy under `symmetry`, if one is given.*/
+		PositionKey getKey(Symmetry symmetry = IDENTITY) const { return packKey(symmetry); }
+		
+		
+		/*Returns the smallest key out of the position's symmetric copies,
+		 *and the symmetry which produces it.
+		 *Reflections and rotations of the same position always share the same canonical key.*/
+		CanonicalPosition canonical() const;
+		
+		
+		/*Returns the square that `position` lands on under `symmetry`.*/
+		static Position transformSquare(Position position, Symmetry symmetry)
+		{
+			uint8_t square = Geometry::SYMMETRIES.squares[symmetry][position.row * COLUMNS + position.col];
+			return {uint8_t(square / COLUMNS), uint8_t(square % COLUMNS)};
+		}
+		
+		
+		/*Moves every set bit of `bitboard` to where its square lands under `symmetry`.*/
+		static Bitboard transformBitboard(Bitboard bitboard, Symmetry symmetry)
+		{
+			if (symmetry == IDENTITY)
+			{
+				return bitboard;
+			}
+
+			Bitboard transformed = 0;
+			while (bitboard)
+			{
+				transformed |= Geometry::squareBit(Geometry::SYMMETRIES.squares[symmetry][lowestBit(bitboard)]);
+				bitboard &= bitboard - 1;
+			}
+			return transformed;
+		}
+		
+		
+		/*Returns the index of the given player in turn order, (ie. 0 for X).
+		 *Precondition: token is not NONE.*/
+		static s_t tokenIndex(char token)
+		{
+			return (token == X) ? 0 : (token == O) ? 1 : 2;
+		}
+		
+		
+		/*Returns the token on the given square, or NONE if it is empty.
+		 *Precondition: the square is in bounds.*/
+		Token getSquare(uint8_t row, uint8_t column) const { return getToken({row, column}); }
+		
+		
+		/*Returns the player whose turn it currently is.*/
+		Token getTurnPlayer() const { return turnPlayer; }
+		
+		
+		/*Returns true iff `player` placing a token on the given empty square
+		 *would complete a winning line. The board itself is left untouched,
+		 *so this works for players other than the turn player.
+		 *Precondition: the square is in bounds and empty.*/
+		bool isWinningSquare(uint8_t row, uint8_t column, Token player) const
+		{
+			assert(boxInBounds({row, column}) && getToken({row, column}) == NONE);
+			return winningSquares(player) & squareBit({row, column});
+		}
+		
+		
+		/*Returns a bitboard of every empty square, (bit (row * COLUMNS + col) for each square).*/
+		Bitboard emptySquares() const { return Bitboard(Geometry::ALL_SQUARES & ~occupiedSquares()); }
+		
+		
+		/*Returns a bitboard of every square holding one of `player`'s tokens.*/
+		Bitboard playerSquares(Token player) const { return playerBoards[tokenIndex(player)]; }
+		
+		
+		/*Returns a bitboard of every empty square on which `player` would immediately win.
+		 *This is kept up to date as moves are made, so it costs nothing to ask for.
+		 *Only meaningful while the game is not over.*/
+		Bitboard winningSquares(Token player) const
+		{
+			MTT_COUNT(STAT_WIN_CHECKS);
+			return threatBoards[tokenIndex(player)];
+		}
+		
+		
+		/*Returns the squares the semi-competent rule restricts the turn player to:
+		 *their own winning squares if they have any,
+		 *otherwise the next player's winning squares, which have to be blocked.
+		 *Returns an empty bitboard if the turn player is free to play on any empty square.*/
+		Bitboard forcedMoves() const
+		{
+			Bitboard wins = threatBoards[tokenIndex(turnPlayer)];
+			return wins ? wins : threatBoards[tokenIndex(nextPlayer(turnPlayer))];
+		}
+		
+		
+		/*Returns every square the semi-competent rule allows the turn player to play on:
+		 *a single one of their winning squares if they have any, (since any of them ends the game the same way),
+		 *otherwise the next player's winning squares, which have to be blocked,
+		 *and otherwise every empty square.*/
+		Bitboard semiCompetentMoves() const
+		{
+			Bitboard wins = threatBoards[tokenIndex(turnPlayer)];
+			if (wins)
+			{
+				return wins & Bitboard(~wins + 1);
+			}
+			Bitboard blocks = threatBoards[tokenIndex(nextPlayer(turnPlayer))];
+			return blocks ? blocks : emptySquares();
+		}
+		
+		
+		/*Returns the row and column of the square stored in bit `square` of a bitboard.*/
+		static Position squarePosition(s_t square)
+		{
+			return {uint8_t(square / COLUMNS), uint8_t(square % COLUMNS)};
+		}
+		
+		
+		/*Longest string getBoardPosition() can return:
+		 *one character per square, the slashes between rows, then the space and the turn player.*/
+		static constexpr s_t MAX_POSITION_LENGTH = NUM_SQUARES + (ROWS - 1) + 2;
+		
+		
 		/*Returns a string describing the current board position,
 		 *using the same notation as the boardPosition Constructor.*/
 		std::string getBoardPosition() const;
 		
 		
+		/*Writes the same string as getBoardPosition() into `buffer`, without allocating,
+		 *and returns its length. No terminating null is written.
+		 *Precondition: `buffer` has room for MAX_POSITION_LENGTH characters.*/
+		s_t writeBoardPosition(char* buffer) const;
+		
+		
 		/*Erases the symbol in the target position, decreases the turn counter,
 		 *and reverts the turn player back to the previous player.
 		 *Function is successful iff the symbol on the target position matches the
 		 *previous turn player, and the position is in bounds.
-		 *Function returns true if successful, and false if not.*/
+		 *Function returns true if successful, and false if not.
+		 *Undoing the last move made is as fast as undoLastMove().
+		 *Undoing any other token has to rebuild the board's state from scratch, and clears the move history.*/
 		bool undoMove(uint8_t row, uint8_t col);
+		
+		
+		/*Takes back the last move made by makeMove(), in constant time,
+		 *restoring the exact state the board was in before it, (including winning squares, and whether the game was over).
+		 *Only moves made since the board was last set up, (by a constructor, setBoard(), or setKey()), can be taken back.
+		 *Returns false, leaving the board untouched, if there is no such move.*/
+		bool undoLastMove();
+		
+		
+		/*Returns how many moves undoLastMove() can currently take back.*/
+		s_t getHistorySize() const { return historySize; }
 
 
 		/* Places tokens on the board based on the string passed to it
-		 * Throws various exceptions if the string is invalid.*/
-		void setBoard(const std::string boardPosition);
+		 * Sets `gameOver` and `victor` if the position is already won or drawn.
+		 * Throws std::invalid_argument if the string is invalid, or shows more than one winner,
+		 * in which case the board is left as it was.*/
+		void setBoard(std::string_view boardPosition);
+
+
+		/*Like setBoard(), but reports a bad string by returning why it couldn't be read,
+		 *rather than throwing. Returns ParseError::OK once the position has been set up.
+		 *The board is left as it was if the string is rejected.*/
+		ParseError trySetBoard(std::string_view boardPosition);
+
+
+		/*Reads a position string straight into a key, (as returned by getKey()), without setting up a board.
+		 *Accepts exactly the strings setBoard() does. `key` is only written if the string is accepted.
+		 *Neither allocates nor throws, so it suits reading positions in bulk.*/
+		static ParseError parseKey(std::string_view boardPosition, PositionKey& key);
+
+
+
+		/*Sets up the position packed into `key`, as returned by getKey().
+		 *Like setBoard(), sets `gameOver` and `victor` if the position is already won or drawn.
+		 *Throws std::invalid_argument if the key does not describe a board,
+		 *or shows more than one winner.*/
+		void setKey(PositionKey key);
 };
 
 
+/*The board variants compiled into the project.
+ *MTT_Board3x5 is the board the project started with, and MTT_Board5x5 is the original Tic-Tac-Moe.
+ *To add a new variant, add its typedef here, and instantiate it at the bottom of mtt_board.cpp.*/
+typedef MTT_Board<3, 5, 3, 3> MTT_Board3x5;
+typedef MTT_Board<4, 4, 3, 3> MTT_Board4x4;
+typedef MTT_Board<5, 5, 3, 3> MTT_Board5x5;
+
+extern template class MTT_Board<3, 5, 3, 3>;
+extern template class MTT_Board<4, 4, 3, 3>;
+extern template class MTT_Board<5, 5, 3, 3>;
+
+
+/*Calls `function` with an empty board of the given size, if that size is one of the compiled variants.
+ *`function` must accept any board variant, (eg. a generic lambda).
+ *Returns false without calling anything if no variant has that size.*/
+template <class Function>
+bool withBoardSize(uint8_t rows, uint8_t columns, Function&& function)
+{
+	if (rows == 3 && columns == 5)
+	{
+		function(MTT_Board3x5());
+	}
+	else if (rows == 4 && columns == 4)
+	{
+		function(MTT_Board4x4());
+	}
+	else if (rows == 5 && columns == 5)
+	{
+		function(MTT_Board5x5());
+	}
+	else
+	{
+		return false;
+	}
+	return true;
+}
+
+
+/*Reads the number of rows and columns described by a position string,
+ *using the notation described by MTT_Board's string constructor.
+ *Only the first row is used to count columns; the board itself checks the rest.
+ *Returns false if the string is too malformed to tell.*/
+bool boardSizeOf(std::string_view boardPosition, uint8_t& rows, uint8_t& columns);
+
+
+/*Reads a board size written as rows and columns, like "5x5", as given to the tools' --size option.
+ *Returns false, leaving `rows` and `columns` alone, if `size` isn't two positive numbers separated by an 'x'.*/
+bool parseBoardSize(std::string_view size, uint8_t& rows, uint8_t& columns);
+
+
 #endif
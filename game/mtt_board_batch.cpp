@@ -0,0 +1,377 @@
+#include "mtt_board_batch.hpp"
+
+/*The AVX2 kernels are compiled for AVX2 whatever the rest of the build targets, using GCC and Clang's target attribute,
+ *and only called once the CPU has been checked for it, so one binary runs everywhere, and uses AVX2 wherever it can.*/
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define MTT_BATCH_AVX2
+#include <immintrin.h>
+#define AVX2_TARGET __attribute__((target("avx2")))
+#endif
+
+
+namespace
+{
+	typedef uint32_t Lane;
+
+
+	/*Scalar kernels, one board at a time, using the same bit tricks as MTT_Board.
+	 *Each one starts at lane `start`, so they can finish off whatever the AVX2 kernels leave over.*/
+	template <class Geometry>
+	void findWinnersScalar(const Lane* const* tokens, std::size_t start, std::size_t count, Lane* winners)
+	{
+		for (std::size_t index = start; index < count; index++)
+		{
+			Lane found = 0;
+			for (s_t player = 0; player < Geometry::NUM_PLAYERS; player++)
+			{
+				found |= Lane(Geometry::hasLine(typename Geometry::Bitboard(tokens[player][index]))) << player;
+			}
+			winners[index] = found;
+		}
+	}
+
+
+	template <class Geometry>
+	void legalMovesScalar(const Lane* const* tokens, std::size_t start, std::size_t count, Lane* moves)
+	{
+		for (std::size_t index = start; index < count; index++)
+		{
+			Lane occupied = 0;
+			bool won = false;
+			for (s_t player = 0; player < Geometry::NUM_PLAYERS; player++)
+			{
+				occupied |= tokens[player][index];
+				won |= Geometry::hasLine(typename Geometry::Bitboard(tokens[player][index]));
+			}
+			moves[index] = won ? 0 : Lane(Geometry::ALL_SQUARES) & ~occupied;
+		}
+	}
+
+
+	template <class Geometry>
+	void threatsScalar(const Lane* const* tokens, s_t player, std::size_t start, std::size_t count, Lane* squares)
+	{
+		for (std::size_t index = start; index < count; index++)
+		{
+			Lane occupied = 0;
+			for (s_t other = 0; other < Geometry::NUM_PLAYERS; other++)
+			{
+				occupied |= tokens[other][index];
+			}
+			squares[index] = Lane(Geometry::threatSquares(typename Geometry::Bitboard(tokens[player][index]))) & ~occupied;
+		}
+	}
+
+
+	template <class Geometry>
+	void applyMovesScalar(Lane* const* tokens, Lane* turns, const uint8_t* squares, std::size_t start, std::size_t count)
+	{
+		for (std::size_t index = start; index < count; index++)
+		{
+			if (squares[index] < Geometry::NUM_SQUARES)
+			{
+				tokens[turns[index]][index] |= Lane(1) << squares[index];
+				turns[index] = (turns[index] + 1 == Geometry::NUM_PLAYERS) ? 0 : turns[index] + 1;
+			}
+		}
+	}
+
+
+#ifdef MTT_BATCH_AVX2
+	AVX2_TARGET inline __m256i loadLanes(const Lane* lanes)
+	{
+		return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lanes));
+	}
+
+
+	AVX2_TARGET inline void storeLanes(Lane* lanes, __m256i vector)
+	{
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), vector);
+	}
+
+
+	/*All ones in every lane of `tokens` holding a complete line, and zero elsewhere.
+	 *The same shifts as Geometry::hasLine(), on eight boards at once.*/
+	template <class Geometry>
+	AVX2_TARGET inline __m256i lineMask(__m256i tokens)
+	{
+		__m256i found = _mm256_setzero_si256();
+		for (s_t direction = 0; direction < 4; direction++)
+		{
+			__m256i run = _mm256_and_si256(tokens, _mm256_set1_epi32(int(Geometry::WIN_LINES.lineStarts[direction])));
+			for (s_t step = 1; step < Geometry::NUM_TO_WIN; step++)
+			{
+				__m128i shift = _mm_cvtsi32_si128(step * Geometry::WIN_LINES.lineSteps[direction]);
+				run = _mm256_and_si256(run, _mm256_srl_epi32(tokens, shift));
+			}
+			found = _mm256_or_si256(found, run);
+		}
+		return _mm256_xor_si256(_mm256_cmpeq_epi32(found, _mm256_setzero_si256()), _mm256_set1_epi32(-1));
+	}
+
+
+	/*The same shifts as Geometry::threatSquares(), on eight boards at once.
+	 *Lines starting near the edge can shift bits past the last square, so mask with the empty squares.*/
+	template <class Geometry>
+	AVX2_TARGET inline __m256i threatMask(__m256i tokens)
+	{
+		__m256i threats = _mm256_setzero_si256();
+		for (s_t direction = 0; direction < 4; direction++)
+		{
+			s_t step = Geometry::WIN_LINES.lineSteps[direction];
+			for (s_t missing = 0; missing < Geometry::NUM_TO_WIN; missing++)
+			{
+				__m256i run = _mm256_set1_epi32(int(Geometry::WIN_LINES.lineStarts[direction]));
+				for (s_t present = 0; present < Geometry::NUM_TO_WIN; present++)
+				{
+					if (present != missing)
+					{
+						run = _mm256_and_si256(run, _mm256_srl_epi32(tokens, _mm_cvtsi32_si128(present * step)));
+					}
+				}
+				threats = _mm256_or_si256(threats, _mm256_sll_epi32(run, _mm_cvtsi32_si128(missing * step)));
+			}
+		}
+		return threats;
+	}
+
+
+	/*The AVX2 kernels handle whole groups of eight boards, and return how many boards they handled.*/
+	template <class Geometry>
+	AVX2_TARGET std::size_t findWinnersAvx2(const Lane* const* tokens, std::size_t count, Lane* winners)
+	{
+		std::size_t index = 0;
+		for (; index + 8 <= count; index += 8)
+		{
+			__m256i found = _mm256_setzero_si256();
+			for (s_t player = 0; player < Geometry::NUM_PLAYERS; player++)
+			{
+				__m256i lines = lineMask<Geometry>(loadLanes(tokens[player] + index));
+				found = _mm256_or_si256(found, _mm256_and_si256(lines, _mm256_set1_epi32(1 << player)));
+			}
+			storeLanes(winners + index, found);
+		}
+		return index;
+	}
+
+
+	template <class Geometry>
+	AVX2_TARGET std::size_t legalMovesAvx2(const Lane* const* tokens, std::size_t count, Lane* moves)
+	{
+		std::size_t index = 0;
+		for (; index + 8 <= count; index += 8)
+		{
+			__m256i occupied = _mm256_setzero_si256();
+			__m256i won = _mm256_setzero_si256();
+			for (s_t player = 0; player < Geometry::NUM_PLAYERS; player++)
+			{
+				__m256i playerTokens = loadLanes(tokens[player] + index);
+				occupied = _mm256_or_si256(occupied, playerTokens);
+				won = _mm256_or_si256(won, lineMask<Geometry>(playerTokens));
+			}
+			__m256i empty = _mm256_andnot_si256(occupied, _mm256_set1_epi32(int(Geometry::ALL_SQUARES)));
+			storeLanes(moves + index, _mm256_andnot_si256(won, empty));
+		}
+		return index;
+	}
+
+
+	template <class Geometry>
+	AVX2_TARGET std::size_t threatsAvx2(const Lane* const* tokens, s_t player, std::size_t count, Lane* squares)
+	{
+		std::size_t index = 0;
+		for (; index + 8 <= count; index += 8)
+		{
+			__m256i occupied = _mm256_setzero_si256();
+			for (s_t other = 0; other < Geometry::NUM_PLAYERS; other++)
+			{
+				occupied = _mm256_or_si256(occupied, loadLanes(tokens[other] + index));
+			}
+			__m256i empty = _mm256_andnot_si256(occupied, _mm256_set1_epi32(int(Geometry::ALL_SQUARES)));
+			storeLanes(squares + index, _mm256_and_si256(threatMask<Geometry>(loadLanes(tokens[player] + index)), empty));
+		}
+		return index;
+	}
+
+
+	/*Shifting by SKIP, (or anything of 32 or more), gives zero, so skipped boards get no token,
+	 *and only boards which got one pass the turn on.*/
+	template <class Geometry>
+	AVX2_TARGET std::size_t applyMovesAvx2(Lane* const* tokens, Lane* turns, const uint8_t* squares, std::size_t count)
+	{
+		std::size_t index = 0;
+		for (; index + 8 <= count; index += 8)
+		{
+			__m256i square = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(squares + index)));
+			__m256i bit = _mm256_sllv_epi32(_mm256_set1_epi32(1), square);
+			__m256i turn = loadLanes(turns + index);
+
+			for (s_t player = 0; player < Geometry::NUM_PLAYERS; player++)
+			{
+				__m256i isTurn = _mm256_cmpeq_epi32(turn, _mm256_set1_epi32(player));
+				__m256i playerTokens = loadLanes(tokens[player] + index);
+				storeLanes(tokens[player] + index, _mm256_or_si256(playerTokens, _mm256_and_si256(bit, isTurn)));
+			}
+
+			__m256i next = _mm256_add_epi32(turn, _mm256_set1_epi32(1));
+			next = _mm256_andnot_si256(_mm256_cmpeq_epi32(next, _mm256_set1_epi32(Geometry::NUM_PLAYERS)), next);
+			__m256i moved = _mm256_xor_si256(_mm256_cmpeq_epi32(bit, _mm256_setzero_si256()), _mm256_set1_epi32(-1));
+			storeLanes(turns + index, _mm256_blendv_epi8(turn, next, moved));
+		}
+		return index;
+	}
+#endif
+}
+
+
+template <class Board>
+MTT_BoardBatch<Board>::MTT_BoardBatch()
+{
+	vectorized = true;
+}
+
+
+template <class Board>
+void MTT_BoardBatch<Board>::add(const Board& board)
+{
+	typename Board::PositionKey key = board.getKey();
+	for (s_t player = 0; player < NUM_PLAYERS; player++)
+	{
+		tokens[player].push_back(Lane(key >> (player * NUM_SQUARES)) & Lane(Geometry::ALL_SQUARES));
+	}
+	turns.push_back(Lane(key >> (NUM_PLAYERS * NUM_SQUARES)));
+}
+
+
+template <class Board>
+void MTT_BoardBatch<Board>::add(const MTT_BoardBatch& other, std::size_t index)
+{
+	for (s_t player = 0; player < NUM_PLAYERS; player++)
+	{
+		tokens[player].push_back(other.tokens[player][index]);
+	}
+	turns.push_back(other.turns[index]);
+}
+
+
+template <class Board>
+Board MTT_BoardBatch<Board>::board(std::size_t index) const
+{
+	typename Board::PositionKey key = typename Board::PositionKey(turns[index]) << (NUM_PLAYERS * NUM_SQUARES);
+	for (s_t player = 0; player < NUM_PLAYERS; player++)
+	{
+		key |= typename Board::PositionKey(tokens[player][index]) << (player * NUM_SQUARES);
+	}
+
+	Board board;
+	board.setKey(key);
+	return board;
+}
+
+
+template <class Board>
+void MTT_BoardBatch<Board>::clear()
+{
+	for (std::vector<Lane>& playerTokens : tokens)
+	{
+		playerTokens.clear();
+	}
+	turns.clear();
+}
+
+
+template <class Board>
+bool MTT_BoardBatch<Board>::avx2Supported()
+{
+#ifdef MTT_BATCH_AVX2
+	static const bool supported = __builtin_cpu_supports("avx2");
+	return supported;
+#else
+	return false;
+#endif
+}
+
+
+template <class Board>
+void MTT_BoardBatch<Board>::findWinners(Lane* winners) const
+{
+	const Lane* players[NUM_PLAYERS];
+	for (s_t player = 0; player < NUM_PLAYERS; player++)
+	{
+		players[player] = tokens[player].data();
+	}
+
+	std::size_t done = 0;
+#ifdef MTT_BATCH_AVX2
+	if (usesAvx2())
+	{
+		done = findWinnersAvx2<Geometry>(players, size(), winners);
+	}
+#endif
+	findWinnersScalar<Geometry>(players, done, size(), winners);
+}
+
+
+template <class Board>
+void MTT_BoardBatch<Board>::legalMoves(Lane* moves) const
+{
+	const Lane* players[NUM_PLAYERS];
+	for (s_t player = 0; player < NUM_PLAYERS; player++)
+	{
+		players[player] = tokens[player].data();
+	}
+
+	std::size_t done = 0;
+#ifdef MTT_BATCH_AVX2
+	if (usesAvx2())
+	{
+		done = legalMovesAvx2<Geometry>(players, size(), moves);
+	}
+#endif
+	legalMovesScalar<Geometry>(players, done, size(), moves);
+}
+
+
+template <class Board>
+void MTT_BoardBatch<Board>::threats(s_t player, Lane* squares) const
+{
+	const Lane* players[NUM_PLAYERS];
+	for (s_t index = 0; index < NUM_PLAYERS; index++)
+	{
+		players[index] = tokens[index].data();
+	}
+
+	std::size_t done = 0;
+#ifdef MTT_BATCH_AVX2
+	if (usesAvx2())
+	{
+		done = threatsAvx2<Geometry>(players, player, size(), squares);
+	}
+#endif
+	threatsScalar<Geometry>(players, player, done, size(), squares);
+}
+
+
+template <class Board>
+void MTT_BoardBatch<Board>::applyMoves(const uint8_t* squares)
+{
+	Lane* players[NUM_PLAYERS];
+	for (s_t player = 0; player < NUM_PLAYERS; player++)
+	{
+		players[player] = tokens[player].data();
+	}
+
+	std::size_t done = 0;
+#ifdef MTT_BATCH_AVX2
+	if (usesAvx2())
+	{
+		done = applyMovesAvx2<Geometry>(players, turns.data(), squares, size());
+	}
+#endif
+	applyMovesScalar<Geometry>(players, turns.data(), squares, done, size());
+}
+
+
+template class MTT_BoardBatch<MTT_Board3x5>;
+template class MTT_BoardBatch<MTT_Board4x4>;
+template class MTT_BoardBatch<MTT_Board5x5>;
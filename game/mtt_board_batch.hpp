@@ -0,0 +1,105 @@
+#ifndef MTT_BOARD_BATCH_HPP
+#define MTT_BOARD_BATCH_HPP
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "mtt_board.hpp"
+
+
+/*Many positions of one board variant at once, stored as a structure of arrays:
+ *one array of bitboards per player, and one of turn player indices, each with one 32-bit lane per board.
+ *The kernels below work on every board in the batch at once, and their outputs are arrays with a lane per board too.
+ *Where the CPU supports it, (checked once at runtime), they run on AVX2, eight boards per instruction,
+ *and otherwise fall back to looping over the same bit tricks MTT_Board uses.
+ *Nothing else about a board is kept, (no hashes, threats, or history), so adding and changing boards is cheap,
+ *but anything beyond the kernels means turning a lane back into an MTT_Board with board().
+ *`Board` is any MTT_Board variant of up to 32 squares; member functions are instantiated for each one in mtt_board_batch.cpp.*/
+template <class Board>
+class MTT_BoardBatch
+{
+	public:
+		typedef typename Board::Geometry Geometry;
+		typedef uint32_t Lane;
+
+		static constexpr s_t NUM_PLAYERS = Geometry::NUM_PLAYERS;
+		static constexpr s_t NUM_SQUARES = Geometry::NUM_SQUARES;
+		static_assert(NUM_SQUARES <= 32, "Batches hold each bitboard in a 32-bit lane.");
+
+
+		/*Move which leaves its board untouched in applyMoves().*/
+		static constexpr uint8_t SKIP = 0xFF;
+
+
+	private:
+		std::vector<Lane> tokens[NUM_PLAYERS];
+		std::vector<Lane> turns;
+		bool vectorized;
+
+
+	public:
+		MTT_BoardBatch();
+
+
+		/*Adds the board's position as the last lane of the batch.*/
+		void add(const Board& board);
+
+
+		/*Adds a copy of lane `index` of `other` as the last lane of this batch, without going through a board.*/
+		void add(const MTT_BoardBatch& other, std::size_t index);
+
+
+		/*Returns the position in lane `index` as a full board.
+		 *Throws std::invalid_argument if the lane doesn't hold a valid position,
+		 *(eg. applyMoves() was handed an occupied square).*/
+		Board board(std::size_t index) const;
+
+
+		std::size_t size() const { return turns.size(); }
+		void clear();
+
+
+		/*Each player's tokens, and the index of each board's turn player, (0 for X, 1 for O, and so on), one lane per board.*/
+		const Lane* playerSquares(s_t player) const { return tokens[player].data(); }
+		const Lane* turnIndices() const { return turns.data(); }
+
+
+		/*True iff the CPU running this supports AVX2. Only checked once.*/
+		static bool avx2Supported();
+
+
+		/*Kernels use AVX2 when both this is set and the CPU supports it, which is the default.
+		 *Turning it off gives the scalar fallback, (eg. to compare the two).*/
+		void setVectorized(bool enabled) { vectorized = enabled; }
+		bool usesAvx2() const { return vectorized && avx2Supported(); }
+
+
+		/*Every kernel writes one lane per board into its output, which needs room for size() lanes.*/
+
+
+		/*Sets bit `player` of each board's lane for every player with a complete line.*/
+		void findWinners(Lane* winners) const;
+
+
+		/*Sets each board's lane to its empty squares, or zero if the game is over.*/
+		void legalMoves(Lane* moves) const;
+
+
+		/*Sets each board's lane to every empty square on which `player`, (an index, as in turnIndices()),
+		 *would complete a line. Only meaningful for boards whose game isn't over.*/
+		void threats(s_t player, Lane* squares) const;
+
+
+		/*Places a token of each board's turn player on square `squares[index]`, (row * COLUMNS + col),
+		 *and passes the turn on, leaving the board alone if its square is SKIP.
+		 *Precondition: every square other than SKIP is empty, on a board whose game isn't over.*/
+		void applyMoves(const uint8_t* squares);
+};
+
+
+extern template class MTT_BoardBatch<MTT_Board3x5>;
+extern template class MTT_BoardBatch<MTT_Board4x4>;
+extern template class MTT_BoardBatch<MTT_Board5x5>;
+
+
+#endif
@@ -0,0 +1,112 @@
+#ifndef PACKED_POSITION_HPP
+#define PACKED_POSITION_HPP
+#include <compare>
+#include <functional>
+#include <type_traits>
+#include "mtt_board.hpp"
+
+
+/*A position of one board variant held by value in a single word: each player's tokens, then the turn player,
+ *packed the same way as MTT_Board::getKey(), (so 8 bytes for the 3x5 and 4x4 boards, and 16 for 5x5).
+ *Unlike a full MTT_Board, it has no hashes, threats, or move history, so it is trivially copyable,
+ *and arrays of them can be sorted, hashed, written to disk or memory mapped as they are.
+ *Equality and ordering compare the packed words, so positions sort the same way as their keys do.
+ *Turning one back into a board re-derives everything else, so keep the MTT_Board around while searching,
+ *and use this for storing positions, (in caches, frontiers and result files).*/
+template <class Board>
+class PackedPosition
+{
+	public:
+		typedef typename Board::PositionKey PositionKey;
+		typedef typename Board::Bitboard Bitboard;
+
+		static constexpr s_t NUM_PLAYERS = Board::Geometry::NUM_PLAYERS;
+		static constexpr s_t NUM_SQUARES = Board::Geometry::NUM_SQUARES;
+
+
+	private:
+		PositionKey key;
+
+		static constexpr PositionKey SQUARES_MASK = (PositionKey(1) << NUM_SQUARES) - 1;
+
+
+	public:
+		/*The empty board, with X to move.*/
+		constexpr PackedPosition() : key(0) {}
+
+		/*Packs the board's position, after applying `symmetry`.*/
+		explicit PackedPosition(const Board& board, Symmetry symmetry = IDENTITY) : key(board.getKey(symmetry)) {}
+
+
+		/*Wraps a key, as returned by MTT_Board::getKey(), without checking it.*/
+		static constexpr PackedPosition fromKey(PositionKey key)
+		{
+			PackedPosition position;
+			position.key = key;
+			return position;
+		}
+
+
+		/*Packs the canonical copy of the board's position, (see MTT_Board::canonical()).*/
+		static PackedPosition canonical(const Board& board) { return fromKey(board.canonical().key); }
+
+
+		constexpr PositionKey getKey() const { return key; }
+
+
+		/*Returns the board holding this position.
+		 *Throws std::invalid_argument if it isn't one, (see MTT_Board::setKey()).*/
+		Board toBoard() const
+		{
+			Board board;
+			board.setKey(key);
+			return board;
+		}
+
+
+		/*Sets up `board` with this position, reusing it rather than building a new one.*/
+		void unpack(Board& board) const { board.setKey(key); }
+
+
+		/*Tokens of the player with index `player`, (0 for X, 1 for O, and so on).*/
+		constexpr Bitboard playerSquares(s_t player) const { return Bitboard((key >> (player * NUM_SQUARES)) & SQUARES_MASK); }
+
+
+		constexpr Bitboard occupiedSquares() const
+		{
+			Bitboard occupied = 0;
+			for (s_t player = 0; player < NUM_PLAYERS; player++)
+			{
+				occupied |= playerSquares(player);
+			}
+			return occupied;
+		}
+
+
+		/*Index of the player to move, in the same order as playerSquares().*/
+		constexpr s_t turnIndex() const { return s_t(key >> (NUM_PLAYERS * NUM_SQUARES)); }
+
+		constexpr Token getTurnPlayer() const { return Board::players[turnIndex()]; }
+
+
+		friend constexpr bool operator==(const PackedPosition&, const PackedPosition&) = default;
+		friend constexpr auto operator<=>(const PackedPosition&, const PackedPosition&) = default;
+};
+
+
+template <class Board>
+struct std::hash<PackedPosition<Board>>
+{
+	std::size_t operator()(const PackedPosition<Board>& position) const noexcept
+	{
+		return hashPositionKey(position.getKey());
+	}
+};
+
+
+static_assert(std::is_trivially_copyable_v<PackedPosition<MTT_Board3x5>>);
+static_assert(sizeof(PackedPosition<MTT_Board3x5>) == 8 && sizeof(PackedPosition<MTT_Board4x4>) == 8);
+static_assert(sizeof(PackedPosition<MTT_Board5x5>) == sizeof(MTT_Board5x5::PositionKey));
+
+
+#endif
@@ -0,0 +1,65 @@
+#include "player_policy.hpp"
+
+
+const char* playerModelName(PlayerModel model)
+{
+	switch (model)
+	{
+		case PlayerModel::RANDOM:
+			return "random";
+		case PlayerModel::GREEDY:
+			return "greedy";
+		case PlayerModel::SEMI_COMPETENT:
+			return "semi-competent";
+	}
+	return "unknown";
+}
+
+
+bool parsePlayerModel(std::string_view name, PlayerModel& model)
+{
+	for (PlayerModel candidate : {PlayerModel::RANDOM, PlayerModel::GREEDY, PlayerModel::SEMI_COMPETENT})
+	{
+		if (name == playerModelName(candidate))
+		{
+			model = candidate;
+			return true;
+		}
+	}
+	return false;
+}
+
+
+bool parsePlayerModels(std::string_view names, PlayerModel models[], s_t numSeats)
+{
+	s_t seat = 0;
+	bool lastName = false;
+	while (seat < numSeats && !lastName)
+	{
+		s_t comma = names.find(',');
+		lastName = (comma == std::string_view::npos);
+		if (!parsePlayerModel(names.substr(0, comma), models[seat++]))
+		{
+			return false;
+		}
+		if (!lastName)
+		{
+			names.remove_prefix(comma + 1);
+		}
+	}
+
+	//Anything after the last seat's name, even an empty name, is one name too many.
+	if (!lastName)
+	{
+		return false;
+	}
+
+	if (seat == 1)
+	{
+		for (; seat < numSeats; seat++)
+		{
+			models[seat] = models[0];
+		}
+	}
+	return seat == numSeats;
+}
@@ -0,0 +1,203 @@
+#ifndef PLAYER_POLICY_HPP
+#define PLAYER_POLICY_HPP
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include "mtt_board.hpp"
+
+
+/*Models of how a player picks their moves.
+ *A policy is any type with a NAME, and a static allowedMoves(empty, wins, blocks) function, taking bitboards of
+ *the empty squares, the squares on which the turn player would win, and the squares on which the next player would win,
+ *and returning the squares the player may pick between, (which must be some of the empty ones, and at least one).
+ *The searches and playouts choosing between them are templates on the policies,
+ *so the calls are inlined into their inner loops, with nothing decided at runtime per position.
+ *Policies can't look any further ahead than that, which is all the models below need.*/
+
+
+/*Any empty square, with no regard for winning or blocking.*/
+struct RandomPolicy
+{
+	static constexpr const char* NAME = "random";
+
+	template <class Bitboard>
+	static constexpr Bitboard allowedMoves(Bitboard empty, Bitboard, Bitboard)
+	{
+		return empty;
+	}
+};
+
+
+/*A win if there is one, and otherwise any empty square, never minding the next player's threats.*/
+struct GreedyPolicy
+{
+	static constexpr const char* NAME = "greedy";
+
+	template <class Bitboard>
+	static constexpr Bitboard allowedMoves(Bitboard empty, Bitboard wins, Bitboard)
+	{
+		return wins ? wins : empty;
+	}
+};
+
+
+/*The README's semi-competent rule: a win if there is one,
+ *otherwise a block of the next player's win if there is one, otherwise any empty square.*/
+struct SemiCompetentPolicy
+{
+	static constexpr const char* NAME = "semi-competent";
+
+	template <class Bitboard>
+	static constexpr Bitboard allowedMoves(Bitboard empty, Bitboard wins, Bitboard blocks)
+	{
+		return wins ? wins : blocks ? blocks : empty;
+	}
+};
+
+
+/*One policy for each seat, in turn order, (so the first is X's).*/
+template <class... Policies>
+struct SeatPolicies
+{
+	static constexpr s_t NUM_SEATS = sizeof...(Policies);
+
+
+	/*Every seat's policy's name, separated by commas, (as read by parsePlayerModels()).*/
+	static std::string names()
+	{
+		std::string names;
+		((names += (names.empty() ? "" : ","), names += Policies::NAME), ...);
+		return names;
+	}
+
+
+	/*Squares the player in `seat`, (their index in turn order), may pick between.*/
+	template <class Bitboard>
+	static Bitboard allowedMoves(s_t seat, Bitboard empty, Bitboard wins, Bitboard blocks)
+	{
+		Bitboard allowed = 0;
+		s_t index = 0;
+		(void)((seat == index++ && (allowed = Policies::allowedMoves(empty, wins, blocks), true)) || ...);
+		return allowed;
+	}
+
+
+	/*Squares the board's turn player may pick between.
+	 *Only meaningful while the game is not over.*/
+	template <class Board>
+	static typename Board::Bitboard allowedMoves(const Board& board)
+	{
+		static_assert(NUM_SEATS == Board::Geometry::NUM_PLAYERS, "Every player needs a policy.");
+		Token turn = board.getTurnPlayer();
+		return allowedMoves(Board::tokenIndex(turn), board.emptySquares(), board.winningSquares(turn),
+			board.winningSquares(Board::nextPlayer(turn)));
+	}
+};
+
+
+//Adds `Policy` to the front of `Seats` until there are NUM_SEATS more of them.
+template <class Policy, s_t NUM_SEATS, class... Seats>
+struct UniformSeatsBuilder
+{
+	typedef typename UniformSeatsBuilder<Policy, NUM_SEATS - 1, Policy, Seats...>::type type;
+};
+
+template <class Policy, class... Seats>
+struct UniformSeatsBuilder<Policy, 0, Seats...>
+{
+	typedef SeatPolicies<Seats...> type;
+};
+
+
+/*The same policy in each of `NUM_SEATS` seats.*/
+template <class Policy, s_t NUM_SEATS>
+using UniformSeats = typename UniformSeatsBuilder<Policy, NUM_SEATS>::type;
+
+
+/*Every player following the semi-competent rule, which is what the searches assume unless told otherwise.*/
+template <class Board>
+using SemiCompetentSeats = UniformSeats<SemiCompetentPolicy, Board::Geometry::NUM_PLAYERS>;
+
+
+/*The policies above, for picking them at runtime, (eg. from the command line).*/
+enum class PlayerModel : uint8_t
+{
+	RANDOM,
+	GREEDY,
+	SEMI_COMPETENT
+};
+
+
+/*Returns the model's name, as read by parsePlayerModel().*/
+const char* playerModelName(PlayerModel model);
+
+
+/*Reads a model's name, ("random", "greedy", or "semi-competent"), into `model`, and returns false if it isn't one.*/
+bool parsePlayerModel(std::string_view name, PlayerModel& model);
+
+
+/*Reads a comma separated list of model names, one for each of `numSeats` seats in turn order,
+ *or a single name for every seat, into `models`, and returns false if it isn't one.*/
+bool parsePlayerModels(std::string_view names, PlayerModel models[], s_t numSeats);
+
+
+//Picks the policy for the seat after those in `Chosen`, until every seat has one.
+template <class... Chosen>
+struct SeatPolicyDispatch
+{
+	template <s_t NUM_SEATS, class Function>
+	static bool with(const PlayerModel models[], Function& function)
+	{
+		if constexpr (sizeof...(Chosen) == NUM_SEATS)
+		{
+			function(SeatPolicies<Chosen...>());
+			return true;
+		}
+		else
+		{
+			switch (models[sizeof...(Chosen)])
+			{
+				case PlayerModel::RANDOM:
+					return SeatPolicyDispatch<Chosen..., RandomPolicy>::template with<NUM_SEATS>(models, function);
+				case PlayerModel::GREEDY:
+					return SeatPolicyDispatch<Chosen..., GreedyPolicy>::template with<NUM_SEATS>(models, function);
+				case PlayerModel::SEMI_COMPETENT:
+					return SeatPolicyDispatch<Chosen..., SemiCompetentPolicy>::template with<NUM_SEATS>(models, function);
+			}
+			return false;
+		}
+	}
+};
+
+
+/*Calls `function` with a default constructed SeatPolicies holding the policy of each of `models`, in seat order,
+ *(so the function can read the type off its argument, like withBoardSize()'s does with the board).
+ *Every combination is compiled in, so the choice is only made once, here.
+ *Returns false without calling it if some model isn't one of the above.*/
+template <s_t NUM_SEATS, class Function>
+bool withSeatPolicies(const PlayerModel models[NUM_SEATS], Function function)
+{
+	return SeatPolicyDispatch<>::template with<NUM_SEATS>(models, function);
+}
+
+
+/*Explicitly instantiates, (or with `PREFIX` set to `extern template`, declares), `CLASS<BOARD, SeatPolicies<...>>`
+ *for every combination of the policies above on a three player board,
+ *so that withSeatPolicies() can pick any of them.*/
+#define MTT_SEATS_LAST(PREFIX, CLASS, BOARD, FIRST, SECOND) \
+	PREFIX class CLASS<BOARD, SeatPolicies<FIRST, SECOND, RandomPolicy>>; \
+	PREFIX class CLASS<BOARD, SeatPolicies<FIRST, SECOND, GreedyPolicy>>; \
+	PREFIX class CLASS<BOARD, SeatPolicies<FIRST, SECOND, SemiCompetentPolicy>>;
+
+#define MTT_SEATS_SECOND(PREFIX, CLASS, BOARD, FIRST) \
+	MTT_SEATS_LAST(PREFIX, CLASS, BOARD, FIRST, RandomPolicy) \
+	MTT_SEATS_LAST(PREFIX, CLASS, BOARD, FIRST, GreedyPolicy) \
+	MTT_SEATS_LAST(PREFIX, CLASS, BOARD, FIRST, SemiCompetentPolicy)
+
+#define MTT_INSTANTIATE_SEATS(PREFIX, CLASS, BOARD) \
+	MTT_SEATS_SECOND(PREFIX, CLASS, BOARD, RandomPolicy) \
+	MTT_SEATS_SECOND(PREFIX, CLASS, BOARD, GreedyPolicy) \
+	MTT_SEATS_SECOND(PREFIX, CLASS, BOARD, SemiCompetentPolicy)
+
+
+#endif
@@ -0,0 +1,70 @@
+#include "position_file.hpp"
+#include "mapped_file.hpp"
+#include <cstring>
+
+
+/*Finds each line with memchr(), which scans far faster than checking a character at a time.*/
+template <class Board>
+uint64_t readPositions(std::string_view text, std::vector<typename Board::PositionKey>& keys,
+	std::vector<PositionFileError>* errors, uint64_t firstLine)
+{
+	uint64_t numRead = 0;
+	uint64_t line = firstLine;
+	const char* next = text.data();
+	const char* end = text.data() + text.size();
+
+	while (next < end)
+	{
+		const char* newline = static_cast<const char*>(std::memchr(next, '\n', end - next));
+		const char* lineEnd = newline ? newline : end;
+		std::string_view position(next, lineEnd - next);
+		next = newline ? newline + 1 : end;
+
+		if (!position.empty() && position.back() == '\r')
+		{
+			position.remove_suffix(1);
+		}
+
+		if (!position.empty())
+		{
+			typename Board::PositionKey key;
+			ParseError error = Board::parseKey(position, key);
+			if (error == ParseError::OK)
+			{
+				keys.push_back(key);
+				numRead++;
+			}
+			else if (errors)
+			{
+				errors->push_back({line, error});
+			}
+		}
+		line++;
+	}
+
+	return numRead;
+}
+
+
+template <class Board>
+uint64_t loadPositionFile(const std::string& path, std::vector<typename Board::PositionKey>& keys,
+	std::vector<PositionFileError>* errors)
+{
+	MappedFile file(path);
+	std::string_view text(reinterpret_cast<const char*>(file.data()), file.size());
+
+	//Lines are never much longer than a position, so this reserves roughly enough room for every key.
+	keys.reserve(keys.size() + file.size() / (Board::MAX_POSITION_LENGTH / 2 + 1));
+
+	return readPositions<Board>(text, keys, errors);
+}
+
+
+//Every board variant the project uses. See the typedefs at the bottom of mtt_board.hpp.
+template uint64_t readPositions<MTT_Board3x5>(std::string_view, std::vector<MTT_Board3x5::PositionKey>&, std::vector<PositionFileError>*, uint64_t);
+template uint64_t readPositions<MTT_Board4x4>(std::string_view, std::vector<MTT_Board4x4::PositionKey>&, std::vector<PositionFileError>*, uint64_t);
+template uint64_t readPositions<MTT_Board5x5>(std::string_view, std::vector<MTT_Board5x5::PositionKey>&, std::vector<PositionFileError>*, uint64_t);
+
+template uint64_t loadPositionFile<MTT_Board3x5>(const std::string&, std::vector<MTT_Board3x5::PositionKey>&, std::vector<PositionFileError>*);
+template uint64_t loadPositionFile<MTT_Board4x4>(const std::string&, std::vector<MTT_Board4x4::PositionKey>&, std::vector<PositionFileError>*);
+template uint64_t loadPositionFile<MTT_Board5x5>(const std::string&, std::vector<MTT_Board5x5::PositionKey>&, std::vector<PositionFileError>*);
@@ -0,0 +1,39 @@
+#ifndef POSITION_FILE_HPP
+#define POSITION_FILE_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include "mtt_board.hpp"
+
+
+/*A line of a position file which couldn't be read, and why.*/
+struct PositionFileError
+{
+	uint64_t line;		//Counting from 1.
+	ParseError error;
+};
+
+
+/*Reads newline separated positions, (in the notation of MTT_Board's string constructor),
+ *appending each one's key to `keys` in the order they appear.
+ *Blank lines are skipped, and lines may end with "\r\n" as well as "\n".
+ *Lines which can't be read are skipped too, and recorded in `errors` if it is given,
+ *numbered from `firstLine` onwards.
+ *Returns how many positions were read.
+ *Every line is parsed where it sits, so the only allocations are the ones growing `keys` and `errors`.*/
+template <class Board>
+uint64_t readPositions(std::string_view text, std::vector<typename Board::PositionKey>& keys,
+	std::vector<PositionFileError>* errors = nullptr, uint64_t firstLine = 1);
+
+
+/*Runs readPositions() over the whole file at `path`, which is memory-mapped where possible,
+ *so a file of any size is read straight from the page cache.
+ *Throws std::runtime_error if the file can't be opened.*/
+template <class Board>
+uint64_t loadPositionFile(const std::string& path, std::vector<typename Board::PositionKey>& keys,
+	std::vector<PositionFileError>* errors = nullptr);
+
+
+#endif
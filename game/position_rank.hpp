@@ -0,0 +1,220 @@
+#ifndef POSITION_RANK_HPP
+#define POSITION_RANK_HPP
+#include <cstdint>
+#include <cassert>
+#include "board_geometry.hpp"
+
+
+/*Numbers every legal position of a board variant densely, from zero up to SIZE - 1.
+ *A position is legal if its token counts could come from players taking turns, starting with X,
+ *(ie. each player has as many tokens as the next player, or one more, and X has at most one more than the last player),
+ *with the turn player being whoever those counts say moves next.
+ *Legal positions may still be unreachable, (eg. if a player kept moving after somebody won).
+ *
+ *A position with `moves` tokens is made of three choices, each numbered with the combinatorial number system:
+ *which `moves` squares are occupied, which of those hold an X, and which of the rest hold an O.
+ *Ys fill whatever is left. Positions are numbered by token count first, then by those three choices in that order.
+ *Each choice is numbered by walking the bits it picks from, and reading a table of binomial coefficients
+ *generated at compile time.*/
+template <class Geometry>
+class PositionRank
+{
+	private:
+		static constexpr s_t NUM_SQUARES = Geometry::NUM_SQUARES;
+		static constexpr s_t NUM_PLAYERS = Geometry::NUM_PLAYERS;
+
+		static_assert(NUM_SQUARES <= 31, "Every legal position has to be numbered inside 64 bits.");
+
+		typedef typename Geometry::PositionKey PositionKey;
+		typedef typename Geometry::Bitboard Bitboard;
+
+
+		/*Number of tokens each player has after `moves` moves.*/
+		static constexpr s_t tokensAfter(s_t moves, s_t player)
+		{
+			return (moves + NUM_PLAYERS - 1 - player) / NUM_PLAYERS;
+		}
+
+
+		/*`choose[n][k]` is the number of ways to pick k things out of n, (zero if k > n).
+		 *`layerStart[moves]` is the number of the first position with that many tokens.*/
+		struct Tables
+		{
+			uint64_t choose[NUM_SQUARES + 1][NUM_SQUARES + 2];
+			uint64_t layerStart[NUM_SQUARES + 2];
+		};
+
+
+		static constexpr Tables buildTables()
+		{
+			Tables tables{};
+
+			for (s_t n = 0; n <= NUM_SQUARES; n++)
+			{
+				tables.choose[n][0] = 1;
+				for (s_t k = 1; k <= n; k++)
+				{
+					tables.choose[n][k] = tables.choose[n - 1][k - 1] + tables.choose[n - 1][k];
+				}
+			}
+
+			for (s_t moves = 0; moves <= NUM_SQUARES; moves++)
+			{
+				s_t xs = tokensAfter(moves, 0);
+				s_t os = tokensAfter(moves, 1);
+				uint64_t layerSize = tables.choose[NUM_SQUARES][moves] * tables.choose[moves][xs] * tables.choose[moves - xs][os];
+				tables.layerStart[moves + 1] = tables.layerStart[moves] + layerSize;
+			}
+
+			return tables;
+		}
+
+
+		static constexpr Tables TABLES = buildTables();
+
+
+		/*Numbers the set bits of `subset` among the set bits of `within`,
+		 *as the sum of choose(i, j) for the j-th set bit of `subset`, (counting from 1),
+		 *where i is how many set bits of `within` come before it.
+		 *Precondition: `subset` is a subset of `within`.*/
+		static uint64_t rankSubset(Bitboard subset, Bitboard within)
+		{
+			uint64_t number = 0;
+			for (s_t picked = 1; subset; picked++)
+			{
+				Bitboard below = Bitboard((subset & Bitboard(~subset + 1)) - 1);
+				number += TABLES.choose[popCount(Bitboard(within & below))][picked];
+				subset &= subset - 1;
+			}
+			return number;
+		}
+
+
+		/*rankSubset() for subsets of the whole board, where each square's index is the square itself.*/
+		static uint64_t rankSquares(Bitboard subset)
+		{
+			uint64_t number = 0;
+			for (s_t picked = 1; subset; picked++)
+			{
+				number += TABLES.choose[lowestBit(subset)][picked];
+				subset &= subset - 1;
+			}
+			return number;
+		}
+
+
+		/*Undoes rankSubset(), returning which `count` of the `size` set bits of `within` were picked.*/
+		static Bitboard unrankSubset(uint64_t number, s_t count, Bitboard within, s_t size)
+		{
+			Bitboard subset = 0;
+			for (s_t index = size; count > 0 && index-- > 0;)
+			{
+				Bitboard bit = Geometry::squareBit(highestBit(within));
+				if (TABLES.choose[index][count] <= number)
+				{
+					number -= TABLES.choose[index][count];
+					subset |= bit;
+					count--;
+				}
+				within ^= bit;
+			}
+			return subset;
+		}
+
+
+	public:
+		/*Total number of legal positions.*/
+		static constexpr uint64_t SIZE = TABLES.layerStart[NUM_SQUARES + 1];
+
+
+		/*Number of the first legal position with `moves` tokens on the board.
+		 *Positions with `moves` tokens are numbered from layerStart(moves) up to layerStart(moves + 1) - 1.*/
+		static constexpr uint64_t layerStart(s_t moves) { return TABLES.layerStart[moves]; }
+
+
+		/*Returns true iff the position packed into `key` is legal, and so has a number.*/
+		static bool isLegal(PositionKey key)
+		{
+			s_t moves = 0;
+			s_t counts[3] = {};
+			for (s_t player = 0; player < NUM_PLAYERS; player++)
+			{
+				counts[player] = popCount(Bitboard(key >> (player * NUM_SQUARES)) & Geometry::ALL_SQUARES);
+				moves += counts[player];
+			}
+
+			for (s_t player = 0; player < NUM_PLAYERS; player++)
+			{
+				if (counts[player] != tokensAfter(moves, player))
+				{
+					return false;
+				}
+			}
+			return s_t(key >> (NUM_PLAYERS * NUM_SQUARES)) == moves % NUM_PLAYERS;
+		}
+
+
+		/*Returns the number of the position packed into `key`, (as returned by MTT_Board::getKey()).
+		 *Precondition: the position is legal.*/
+		static uint64_t rank(PositionKey key)
+		{
+			Bitboard xs = Bitboard(key) & Geometry::ALL_SQUARES;
+			Bitboard os = Bitboard(key >> NUM_SQUARES) & Geometry::ALL_SQUARES;
+			Bitboard occupied = xs | os;
+			if constexpr (NUM_PLAYERS > 2)
+			{
+				occupied |= Bitboard(key >> (2 * NUM_SQUARES)) & Geometry::ALL_SQUARES;
+			}
+
+			s_t moves = popCount(occupied);
+			s_t numXs = popCount(xs);
+			assert(numXs == tokensAfter(moves, 0) && s_t(popCount(os)) == tokensAfter(moves, 1));
+			assert(s_t(key >> (NUM_PLAYERS * NUM_SQUARES)) == moves % NUM_PLAYERS);
+
+			uint64_t number = rankSquares(occupied);
+			number = number * TABLES.choose[moves][numXs] + rankSubset(xs, occupied);
+			number = number * TABLES.choose[moves - numXs][popCount(os)] + rankSubset(os, Bitboard(occupied & ~xs));
+
+			return TABLES.layerStart[moves] + number;
+		}
+
+
+		/*Returns the key of the position with the given number.
+		 *Precondition: number < SIZE.*/
+		static PositionKey unrank(uint64_t number)
+		{
+			assert(number < SIZE);
+
+			s_t moves = 0;
+			while (TABLES.layerStart[moves + 1] <= number)
+			{
+				moves++;
+			}
+			number -= TABLES.layerStart[moves];
+
+			s_t numXs = tokensAfter(moves, 0);
+			s_t numOs = tokensAfter(moves, 1);
+			uint64_t osWays = TABLES.choose[moves - numXs][numOs];
+			uint64_t xsWays = TABLES.choose[moves][numXs];
+
+			uint64_t osNumber = number % osWays;
+			number /= osWays;
+			uint64_t xsNumber = number % xsWays;
+			number /= xsWays;
+
+			Bitboard occupied = unrankSubset(number, moves, Geometry::ALL_SQUARES, NUM_SQUARES);
+			Bitboard xs = unrankSubset(xsNumber, numXs, occupied, moves);
+			Bitboard os = unrankSubset(osNumber, numOs, Bitboard(occupied & ~xs), moves - numXs);
+
+			PositionKey key = PositionKey(moves % NUM_PLAYERS) << (NUM_PLAYERS * NUM_SQUARES);
+			key |= PositionKey(xs) | (PositionKey(os) << NUM_SQUARES);
+			if constexpr (NUM_PLAYERS > 2)
+			{
+				key |= PositionKey(Bitboard(occupied & ~xs & ~os)) << (2 * NUM_SQUARES);
+			}
+			return key;
+		}
+};
+
+
+#endif
@@ -0,0 +1,175 @@
+#include "search_stats.hpp"
+
+
+namespace
+{
+	const char* COUNTER_NAMES[NUM_STAT_COUNTERS] = {"nodes", "make_moves", "undo_moves", "win_checks",
+		"tt_probes", "tt_hits", "tt_stores", "tt_collisions", "cutoffs"};
+
+	std::atomic<std::chrono::steady_clock::rep> startTime(std::chrono::steady_clock::now().time_since_epoch().count());
+
+#ifdef MTT_STATS
+	ThreadStats blocks[SearchStats::MAX_THREADS];
+
+	/*The first `numBlocks` blocks have been handed out, and `numHolders` counts the threads holding each one,
+	 *(only ever more than one for the last block). Blocks given back are stacked in `freeBlocks`, to be handed out first.*/
+	std::mutex blocksMutex;
+	std::size_t numBlocks = 0;
+	std::size_t numHolders[SearchStats::MAX_THREADS];
+	std::size_t freeBlocks[SearchStats::MAX_THREADS];
+	std::size_t numFree = 0;
+#endif
+}
+
+
+SearchStats::BlockHolder::BlockHolder()
+{
+#ifdef MTT_STATS
+	std::lock_guard<std::mutex> lock(blocksMutex);
+	std::size_t index = MAX_THREADS - 1;
+	if (numFree > 0)
+	{
+		index = freeBlocks[--numFree];
+	}
+	else if (numBlocks < MAX_THREADS)
+	{
+		index = numBlocks++;
+	}
+	numHolders[index]++;
+	block = &blocks[index];
+#else
+	//Nothing counts without MTT_STATS, so no thread ever asks for a block.
+	static ThreadStats unused;
+	block = &unused;
+#endif
+}
+
+
+SearchStats::BlockHolder::~BlockHolder()
+{
+#ifdef MTT_STATS
+	//The lock also makes sure the next thread to take the block sees everything counted in it so far.
+	std::lock_guard<std::mutex> lock(blocksMutex);
+	std::size_t index = block - blocks;
+	if (--numHolders[index] == 0)
+	{
+		freeBlocks[numFree++] = index;
+	}
+#endif
+}
+
+
+StatsSnapshot SearchStats::snapshot()
+{
+	StatsSnapshot snapshot {};
+
+#ifdef MTT_STATS
+	std::lock_guard<std::mutex> lock(blocksMutex);
+	for (std::size_t index = 0; index < numBlocks; index++)
+	{
+		const ThreadStats& block = blocks[index];
+		for (std::size_t counter = 0; counter < NUM_STAT_COUNTERS; counter++)
+		{
+			snapshot.counters[counter] += block.counters[counter].load(std::memory_order_relaxed);
+		}
+		for (std::size_t depth = 0; depth < MAX_STAT_DEPTH; depth++)
+		{
+			snapshot.depthNodes[depth] += block.depthNodes[depth].load(std::memory_order_relaxed);
+		}
+		snapshot.threadNodes.push_back(block.counters[STAT_NODES].load(std::memory_order_relaxed));
+	}
+#endif
+
+	std::chrono::steady_clock::duration elapsed = std::chrono::steady_clock::now().time_since_epoch()
+		- std::chrono::steady_clock::duration(startTime.load(std::memory_order_relaxed));
+	snapshot.seconds = std::chrono::duration<double>(elapsed).count();
+	return snapshot;
+}
+
+
+void SearchStats::reset()
+{
+#ifdef MTT_STATS
+	std::lock_guard<std::mutex> lock(blocksMutex);
+	for (std::size_t index = 0; index < numBlocks; index++)
+	{
+		for (std::atomic<uint64_t>& counter : blocks[index].counters)
+		{
+			counter.store(0, std::memory_order_relaxed);
+		}
+		for (std::atomic<uint64_t>& depth : blocks[index].depthNodes)
+		{
+			depth.store(0, std::memory_order_relaxed);
+		}
+	}
+#endif
+
+	startTime.store(std::chrono::steady_clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+}
+
+
+void StatsSnapshot::writeJson(std::ostream& output) const
+{
+	output << "{\"enabled\":" << (SearchStats::ENABLED ? "true" : "false") << ",\"seconds\":" << seconds;
+	for (std::size_t counter = 0; counter < NUM_STAT_COUNTERS; counter++)
+	{
+		output << ",\"" << COUNTER_NAMES[counter] << "\":" << counters[counter];
+	}
+
+	std::size_t maxDepth = MAX_STAT_DEPTH;
+	while (maxDepth > 0 && depthNodes[maxDepth - 1] == 0)
+	{
+		maxDepth--;
+	}
+
+	output << ",\"nodes_by_depth\":[";
+	for (std::size_t depth = 0; depth < maxDepth; depth++)
+	{
+		output << (depth ? "," : "") << depthNodes[depth];
+	}
+
+	output << "],\"nodes_by_thread\":[";
+	for (std::size_t thread = 0; thread < threadNodes.size(); thread++)
+	{
+		output << (thread ? "," : "") << threadNodes[thread];
+	}
+	output << "]}\n";
+}
+
+
+StatsReporter::StatsReporter(std::ostream& output, double interval)
+	: output(output), interval(interval), stopping(false)
+{
+	SearchStats::reset();
+	if (interval <= 0)
+	{
+		return;
+	}
+
+	thread = std::thread([this]()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		while (!wakeUp.wait_for(lock, std::chrono::duration<double>(this->interval), [this]() { return stopping; }))
+		{
+			SearchStats::snapshot().writeJson(this->output);
+			this->output.flush();
+		}
+	});
+}
+
+
+StatsReporter::~StatsReporter()
+{
+	if (thread.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		wakeUp.notify_all();
+		thread.join();
+	}
+
+	SearchStats::snapshot().writeJson(output);
+	output.flush();
+}
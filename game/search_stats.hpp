@@ -0,0 +1,160 @@
+#ifndef SEARCH_STATS_HPP
+#define SEARCH_STATS_HPP
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <ostream>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+
+/*Everything counted while searching, when statistics are compiled in, (the MTT_STATS CMake option).
+ *Without it, the MTT_COUNT macros below expand to nothing, so the counting costs nothing at all.*/
+enum StatCounter : uint8_t
+{
+	STAT_NODES,			//Positions visited by Solver::search().
+	STAT_MAKE_MOVES,	//Successful MTT_Board::makeMove() calls.
+	STAT_UNDO_MOVES,	//Moves taken back by undoLastMove() or undoMove().
+	STAT_WIN_CHECKS,	//Checks of whether a move or position wins.
+	STAT_TT_PROBES,		//Transposition table lookups.
+	STAT_TT_HITS,		//Lookups which found their position.
+	STAT_TT_STORES,		//Entries written to the transposition table.
+	STAT_TT_COLLISIONS,	//Writes which overwrote a different position, or were dropped because its bucket was full.
+	STAT_CUTOFFS,		//Searches which stopped early, because every wanted outcome had been found.
+	NUM_STAT_COUNTERS
+};
+
+
+/*Nodes are also counted by the number of tokens on the board, up to the biggest board a Bitboard holds.*/
+const std::size_t MAX_STAT_DEPTH = 129;
+
+
+/*Totals of every counter at one moment, summed over every thread.*/
+struct StatsSnapshot
+{
+	uint64_t counters[NUM_STAT_COUNTERS];
+	uint64_t depthNodes[MAX_STAT_DEPTH];
+
+	/*STAT_NODES for each block of counters. Each thread counting at the same time has a block of its own,
+	 *and a thread which exits leaves its block, and its counts, to the next thread to start counting.*/
+	std::vector<uint64_t> threadNodes;
+
+	/*Time since the counters were last reset.*/
+	double seconds;
+
+	/*Writes the snapshot as a single line of JSON: "enabled", (false if statistics weren't compiled in),
+	 *"seconds", one field per counter, (eg. "tt_hits"), then "nodes_by_depth", (trimmed after the deepest level reached), and "nodes_by_thread".*/
+	void writeJson(std::ostream& output) const;
+};
+
+
+/*Counters of a single thread. Only the thread which owns a block writes to it,
+ *so it can count with a plain load and store, rather than a locked instruction,
+ *while still being safe for other threads to read at any time.*/
+struct alignas(64) ThreadStats
+{
+	std::atomic<uint64_t> counters[NUM_STAT_COUNTERS];
+	std::atomic<uint64_t> depthNodes[MAX_STAT_DEPTH];
+
+	void add(StatCounter counter)
+	{
+		counters[counter].store(counters[counter].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	}
+
+	void addDepth(std::size_t depth)
+	{
+		depth = (depth < MAX_STAT_DEPTH) ? depth : MAX_STAT_DEPTH - 1;
+		depthNodes[depth].store(depthNodes[depth].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	}
+};
+
+
+/*Process-wide statistics. Every thread gets its own block of counters from a fixed pool the first time it counts something,
+ *and gives it back when it exits, so only taking and giving back a block takes a lock, and counting never does.
+ *A block keeps its counts when it is given back, so nothing counted is lost, and the next thread adds to them.
+ *Past MAX_THREADS threads at once, the extra threads share the last block, and may lose a few counts to each other.*/
+class SearchStats
+{
+	private:
+		/*Holds a thread's block for as long as the thread runs.*/
+		struct BlockHolder
+		{
+			ThreadStats* block;
+
+			BlockHolder();
+			~BlockHolder();
+
+			BlockHolder(const BlockHolder&) = delete;
+			BlockHolder& operator=(const BlockHolder&) = delete;
+		};
+
+
+	public:
+		static const std::size_t MAX_THREADS = 1024;
+
+
+		/*True iff statistics are compiled in.*/
+		static constexpr bool ENABLED =
+#ifdef MTT_STATS
+			true;
+#else
+			false;
+#endif
+
+
+		/*Returns the calling thread's counters.*/
+		static ThreadStats& local()
+		{
+			thread_local BlockHolder holder;
+			return *holder.block;
+		}
+
+
+		/*Sums every thread's counters. Safe to call while other threads are counting.*/
+		static StatsSnapshot snapshot();
+
+
+		/*Zeroes every counter, and restarts the clock.
+		 *Counts made by other threads while this runs may survive it.*/
+		static void reset();
+};
+
+
+#ifdef MTT_STATS
+#define MTT_COUNT(counter) SearchStats::local().add(counter)
+#define MTT_COUNT_DEPTH(depth) SearchStats::local().addDepth(depth)
+#else
+#define MTT_COUNT(counter) ((void)0)
+#define MTT_COUNT_DEPTH(depth) ((void)0)
+#endif
+
+
+/*Resets the statistics, then writes a snapshot of them as a line of JSON every `interval` seconds,
+ *(if `interval` is above zero), from a thread of its own, and a final one when destroyed,
+ *so a long run can be watched while it goes, and still ends with its totals.*/
+class StatsReporter
+{
+	private:
+		std::ostream& output;
+		double interval;
+
+		std::mutex mutex;
+		std::condition_variable wakeUp;
+		bool stopping;
+		std::thread thread;
+
+
+	public:
+		StatsReporter(std::ostream& output, double interval);
+		~StatsReporter();
+
+		StatsReporter(const StatsReporter&) = delete;
+		StatsReporter& operator=(const StatsReporter&) = delete;
+};
+
+
+#endif
@@ -0,0 +1,90 @@
+#ifndef BOUNDED_QUEUE_HPP
+#define BOUNDED_QUEUE_HPP
+
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+#include <cstddef>
+
+
+/*Queue holding at most `capacity` items, for passing work from one stage of a pipeline to the next.
+ *push() blocks while the queue is full, and pop() blocks while it is empty,
+ *so a fast stage can never run arbitrarily far ahead of a slow one.
+ *Once close() has been called, pushes are refused, and pops hand out whatever is left before failing.
+ *Any number of threads may push and pop at once.*/
+template <class T>
+class BoundedQueue
+{
+	private:
+		std::deque<T> items;
+		std::size_t capacity;
+		bool closed;
+
+		std::mutex mutex;
+		std::condition_variable notFull;
+		std::condition_variable notEmpty;
+
+
+	public:
+		explicit BoundedQueue(std::size_t capacity)
+			: capacity(std::max<std::size_t>(capacity, 1)), closed(false)
+		{
+		}
+
+
+		BoundedQueue(const BoundedQueue&) = delete;
+		BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+
+		/*Adds `item` to the back of the queue, waiting for room if the queue is full.
+		 *Returns false, dropping the item, if the queue has been closed.*/
+		bool push(T item)
+		{
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				notFull.wait(lock, [this]() { return closed || items.size() < capacity; });
+				if (closed)
+				{
+					return false;
+				}
+				items.push_back(std::move(item));
+			}
+			notEmpty.notify_one();
+			return true;
+		}
+
+
+		/*Takes the item at the front of the queue, waiting for one if the queue is empty.
+		 *Returns false once the queue has been closed and emptied.*/
+		bool pop(T& item)
+		{
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				notEmpty.wait(lock, [this]() { return closed || !items.empty(); });
+				if (items.empty())
+				{
+					return false;
+				}
+				item = std::move(items.front());
+				items.pop_front();
+			}
+			notFull.notify_one();
+			return true;
+		}
+
+
+		/*Marks the end of the input. Wakes every thread waiting to push or pop.*/
+		void close()
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				closed = true;
+			}
+			notFull.notify_all();
+			notEmpty.notify_all();
+		}
+};
+
+
+#endif
@@ -0,0 +1,290 @@
+#include "census.hpp"
+#include <algorithm>
+#include <queue>
+#include <memory>
+#include <chrono>
+#include <bit>
+#include <stdexcept>
+
+
+//Keys read from or written to a run file at once.
+const std::size_t BLOCK_KEYS = 1 << 16;
+
+
+template <class Board>
+PositionCensus<Board>::PositionCensus(std::size_t memoryMegabytes, const std::filesystem::path& tempDirectory, CensusMoves moves)
+	: tempDirectory(tempDirectory), moves(moves)
+{
+	bufferKeys = std::max<std::size_t>(memoryMegabytes * 1024 * 1024 / sizeof(PositionKey), BLOCK_KEYS);
+	filePrefix = "mtt_census_" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()) + "_";
+	nextFileId = 0;
+}
+
+
+template <class Board>
+PositionCensus<Board>::RunReader::RunReader(const KeyRun& run)
+	: run(run)
+{
+	index = 0;
+	filled = 0;
+	read = 0;
+
+	if (!run.file.empty())
+	{
+		input.open(run.file, std::ios::binary);
+		if (!input)
+		{
+			throw std::runtime_error("Could not read \"" + run.file.string() + "\".");
+		}
+		block.resize(BLOCK_KEYS);
+	}
+}
+
+
+template <class Board>
+bool PositionCensus<Board>::RunReader::next(PositionKey& key)
+{
+	if (read == run.size)
+	{
+		return false;
+	}
+
+	if (run.file.empty())
+	{
+		key = run.keys[read++];
+		return true;
+	}
+
+	if (index == filled)
+	{
+		filled = std::min<uint64_t>(BLOCK_KEYS, run.size - read);
+		input.read(reinterpret_cast<char*>(block.data()), filled * sizeof(PositionKey));
+		if (!input)
+		{
+			throw std::runtime_error("Could not read \"" + run.file.string() + "\".");
+		}
+		index = 0;
+	}
+
+	key = block[index++];
+	read++;
+	return true;
+}
+
+
+template <class Board>
+std::filesystem::path PositionCensus<Board>::tempFile()
+{
+	return tempDirectory / (filePrefix + std::to_string(nextFileId++) + ".keys");
+}
+
+
+template <class Board>
+auto PositionCensus<Board>::spill(std::vector<PositionKey>& buffer) -> KeyRun
+{
+	std::sort(buffer.begin(), buffer.end());
+	buffer.erase(std::unique(buffer.begin(), buffer.end()), buffer.end());
+
+	KeyRun run {{}, tempFile(), buffer.size()};
+	std::ofstream output(run.file, std::ios::binary);
+	output.write(reinterpret_cast<const char*>(buffer.data()), buffer.size() * sizeof(PositionKey));
+	if (!output)
+	{
+		throw std::runtime_error("Could not write \"" + run.file.string() + "\".");
+	}
+
+	buffer.clear();
+	return run;
+}
+
+
+template <class Board>
+auto PositionCensus<Board>::merge(std::vector<KeyRun>& runs) -> KeyRun
+{
+	//Smallest key first, along with the run it came from.
+	typedef std::pair<PositionKey, std::size_t> Head;
+	std::priority_queue<Head, std::vector<Head>, std::greater<Head>> heads;
+
+	std::vector<std::unique_ptr<RunReader>> readers;
+	for (std::size_t index = 0; index < runs.size(); index++)
+	{
+		readers.push_back(std::make_unique<RunReader>(runs[index]));
+		PositionKey key;
+		if (readers[index]->next(key))
+		{
+			heads.push({key, index});
+		}
+	}
+
+	KeyRun merged {{}, tempFile(), 0};
+	std::ofstream output(merged.file, std::ios::binary);
+	std::vector<PositionKey> block;
+	block.reserve(BLOCK_KEYS);
+	PositionKey last = 0;
+
+	while (!heads.empty())
+	{
+		auto [key, index] = heads.top();
+		heads.pop();
+
+		//Keys come out in order, so any duplicate is the key written just before.
+		if (merged.size == 0 || key != last)
+		{
+			if (block.size() == BLOCK_KEYS)
+			{
+				output.write(reinterpret_cast<const char*>(block.data()), block.size() * sizeof(PositionKey));
+				block.clear();
+			}
+			block.push_back(key);
+			last = key;
+			merged.size++;
+		}
+
+		PositionKey next;
+		if (readers[index]->next(next))
+		{
+			heads.push({next, index});
+		}
+	}
+
+	output.write(reinterpret_cast<const char*>(block.data()), block.size() * sizeof(PositionKey));
+	if (!output)
+	{
+		throw std::runtime_error("Could not write \"" + merged.file.string() + "\".");
+	}
+
+	readers.clear();
+	for (const KeyRun& run : runs)
+	{
+		std::filesystem::remove(run.file);
+	}
+	runs.clear();
+	return merged;
+}
+
+
+template <class Board>
+std::vector<CensusLayer> PositionCensus<Board>::run(const Board& start, std::ostream* log)
+{
+	/*Only symmetries which leave the starting position as it is map reachable positions onto reachable positions,
+	 *(a copy of a position under any other may not be reachable at all), so positions are only reduced by those.*/
+	Symmetry symmetries[Board::NUM_SYMMETRIES];
+	s_t numSymmetries = 0;
+	for (uint8_t symmetry = 0; symmetry < Board::NUM_SYMMETRIES; symmetry++)
+	{
+		if (start.getKey(static_cast<Symmetry>(symmetry)) == start.getKey())
+		{
+			symmetries[numSymmetries++] = static_cast<Symmetry>(symmetry);
+		}
+	}
+
+	//The smallest key of any copy of the board's position under those symmetries.
+	auto canonicalKey = [&](const Board& board)
+	{
+		PositionKey key = board.getKey();
+		for (s_t index = 1; index < numSymmetries; index++)
+		{
+			key = std::min(key, board.getKey(symmetries[index]));
+		}
+		return key;
+	};
+
+	std::vector<CensusLayer> layers;
+	KeyRun frontier {{canonicalKey(start)}, {}, 1};
+	uint64_t frontierRuns = 0;
+	std::vector<PositionKey> buffer;
+	Board board;
+
+	for (s_t tokens = start.getNumMoves(); frontier.size > 0; tokens++)
+	{
+		CensusLayer layer {0, frontier.size, {0, 0, 0, 0}, frontierRuns};
+		std::vector<KeyRun> runs;
+		buffer.reserve(std::min<uint64_t>(bufferKeys, 8 * frontier.size + 64));
+
+		{
+			RunReader reader(frontier);
+			PositionKey key;
+			while (reader.next(key))
+			{
+				board.setKey(key);
+
+				//Every distinct symmetric copy of the position is a position of its own, (and just as reachable).
+				PositionKey copies[Board::NUM_SYMMETRIES];
+				s_t numCopies = 0;
+				for (s_t index = 0; index < numSymmetries; index++)
+				{
+					PositionKey copy = board.getKey(symmetries[index]);
+					if (std::find(copies, copies + numCopies, copy) == copies + numCopies)
+					{
+						copies[numCopies++] = copy;
+					}
+				}
+				layer.positions += numCopies;
+
+				if (board.isOver())
+				{
+					layer.finished[std::countr_zero(unsigned(outcomeOf(board.getWinner())))] += numCopies;
+					continue;
+				}
+
+				typename Board::Bitboard allowed = (moves == CensusMoves::ALL) ? board.emptySquares() : board.semiCompetentMoves();
+				while (allowed)
+				{
+					Position move = Board::squarePosition(lowestBit(allowed));
+					allowed &= allowed - 1;
+
+					board.makeMove(move.row, move.col);
+					buffer.push_back(canonicalKey(board));
+					board.undoLastMove();
+
+					//Only spill once clearing out duplicates doesn't free up at least half the buffer.
+					if (buffer.size() == bufferKeys)
+					{
+						std::sort(buffer.begin(), buffer.end());
+						buffer.erase(std::unique(buffer.begin(), buffer.end()), buffer.end());
+						if (buffer.size() > bufferKeys / 2)
+						{
+							runs.push_back(spill(buffer));
+						}
+					}
+				}
+			}
+		}
+
+		if (!frontier.file.empty())
+		{
+			std::filesystem::remove(frontier.file);
+		}
+
+		//Keep the next layer in memory if it never overflowed the buffer, otherwise merge everything spilled.
+		if (runs.empty())
+		{
+			std::sort(buffer.begin(), buffer.end());
+			buffer.erase(std::unique(buffer.begin(), buffer.end()), buffer.end());
+			uint64_t size = buffer.size();
+			frontier = {std::move(buffer), {}, size};
+			frontierRuns = 0;
+			buffer = {};
+		}
+		else
+		{
+			runs.push_back(spill(buffer));
+			frontierRuns = runs.size();
+			frontier = merge(runs);
+		}
+
+		layers.push_back(layer);
+		if (log)
+		{
+			*log << "Tokens " << int(tokens) << ": " << layer.positions << " positions, " << layer.classes << " up to symmetry";
+			*log << (layer.spilledRuns ? ", (spilled to " + std::to_string(layer.spilledRuns) + " runs)" : "") << "\n";
+		}
+	}
+
+	return layers;
+}
+
+
+template class PositionCensus<MTT_Board3x5>;
+template class PositionCensus<MTT_Board4x4>;
+template class PositionCensus<MTT_Board5x5>;
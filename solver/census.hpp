@@ -0,0 +1,132 @@
+#ifndef CENSUS_HPP
+#define CENSUS_HPP
+
+#include "mtt_board.hpp"
+#include "outcome.hpp"
+#include <string>
+#include <vector>
+#include <ostream>
+#include <fstream>
+#include <filesystem>
+#include <cstdint>
+
+
+/*Which moves the census follows out of each position.*/
+enum class CensusMoves
+{
+	ALL,				//Every empty square, so every position that can come up in a real game is counted.
+	SEMI_COMPETENT		//Only the moves the semi-competent rule allows.
+};
+
+
+/*Counts of the distinct positions with one number of tokens on the board.*/
+struct CensusLayer
+{
+	/*Distinct positions, counting symmetric copies separately.*/
+	uint64_t positions;
+
+	/*Distinct positions up to the symmetries of the starting position, (one per set of symmetric copies),
+	 *which are all of them for the empty board.*/
+	uint64_t classes;
+
+	/*Positions, (counting symmetric copies separately), in which the game is over,
+	 *indexed in the order X, O, Y, draw, (the same order as the Outcome flags).*/
+	uint64_t finished[4];
+
+	/*Number of sorted runs the layer's positions were spilled to disk in, (zero if it fitted in memory).*/
+	uint64_t spilledRuns;
+};
+
+
+/*Counts every distinct position reachable from a starting position, one layer of token counts at a time.
+ *
+ *Each layer is a sorted array of PositionKeys without duplicates, each the smallest key of any copy of its position
+ *under the symmetries which leave the starting position as it is,
+ *so a position reached through many move orders, or as a symmetric copy of another, is only expanded once,
+ *unlike a depth-first walk, which meets it again along every path leading to it.
+ *The next layer is built by collecting the keys of every position one move away into a buffer,
+ *which is sorted and cleared of duplicates whenever it fills up, (and only spilled if that frees less than half of it).
+ *While a layer fits in the memory budget, it never leaves memory.
+ *Otherwise each full buffer is written to a temporary file as a sorted run,
+ *and the runs are merged into a single sorted file for the layer, dropping duplicates on the way,
+ *which the next layer is then read back from a block at a time.
+ *That keeps memory use to roughly twice the budget, (a buffer, plus a layer read back from memory or the merge buffers),
+ *however big the layers get, and only needs disk space for about two layers at once.
+ *`Board` is any MTT_Board variant; member functions are instantiated for each one in census.cpp.*/
+template <class Board>
+class PositionCensus
+{
+	private:
+		typedef typename Board::PositionKey PositionKey;
+
+
+		/*A layer's sorted keys, in memory, or in `file` if it has a path.*/
+		struct KeyRun
+		{
+			std::vector<PositionKey> keys;
+			std::filesystem::path file;
+			uint64_t size;
+		};
+
+
+		/*Reads a run's keys in order, a block at a time if it is on disk.*/
+		class RunReader
+		{
+			private:
+				const KeyRun& run;
+				std::ifstream input;
+				std::vector<PositionKey> block;
+				std::size_t index;
+				std::size_t filled;
+				uint64_t read;
+
+			public:
+				explicit RunReader(const KeyRun& run);
+
+				/*Sets `key` to the next key and returns true, or returns false once every key has been read.*/
+				bool next(PositionKey& key);
+		};
+
+
+		std::size_t bufferKeys;
+		std::filesystem::path tempDirectory;
+		CensusMoves moves;
+
+		//Temporary files are named after the census, (so two running at once don't collide), and numbered.
+		std::string filePrefix;
+		uint64_t nextFileId;
+
+
+		/*Returns the path of a new temporary file, unique to this census.*/
+		std::filesystem::path tempFile();
+
+
+		/*Sorts `buffer` and removes duplicates from it, then writes it to a new run file and clears it.*/
+		KeyRun spill(std::vector<PositionKey>& buffer);
+
+
+		/*Merges sorted runs into a single run file without duplicates, deleting the runs as it goes.*/
+		KeyRun merge(std::vector<KeyRun>& runs);
+
+
+	public:
+		/*`memoryMegabytes` bounds the buffer collecting each new layer,
+		 *and how big a layer can get before it is kept on disk instead of in memory.
+		 *Spilled runs are written under `tempDirectory`.*/
+		PositionCensus(std::size_t memoryMegabytes, const std::filesystem::path& tempDirectory, CensusMoves moves = CensusMoves::ALL);
+
+
+		/*Counts every distinct position reachable from `start`, layer by layer,
+		 *returning the counts for each number of tokens from `start`'s own onwards.
+		 *Each layer's counts are also written to `log` as they are finished, if one is given.
+		 *Throws std::runtime_error if a temporary file can't be written or read back.*/
+		std::vector<CensusLayer> run(const Board& start, std::ostream* log = nullptr);
+};
+
+
+extern template class PositionCensus<MTT_Board3x5>;
+extern template class PositionCensus<MTT_Board4x4>;
+extern template class PositionCensus<MTT_Board5x5>;
+
+
+#endif
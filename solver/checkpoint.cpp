@@ -0,0 +1,212 @@
+#include "checkpoint.hpp"
+#include <fstream>
+#include <filesystem>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define CHECKPOINT_FSYNC
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+
+static constexpr char MAGIC[4] = {'M', 'T', 'T', 'K'};
+static constexpr uint32_t VERSION = 2;
+
+
+static std::string tablePath(const std::string& path)
+{
+	return path + ".table";
+}
+
+
+/*Waits for everything written to the file or directory at `path` to reach the disk.
+ *Does nothing where that isn't supported.*/
+static void syncPath(const std::filesystem::path& path)
+{
+#ifdef CHECKPOINT_FSYNC
+	int descriptor = open(path.c_str(), O_RDONLY);
+	bool synced = descriptor >= 0 && fsync(descriptor) == 0;
+	if (descriptor >= 0)
+	{
+		close(descriptor);
+	}
+	if (!synced)
+	{
+		throw std::runtime_error("Could not sync \"" + path.string() + "\" to disk.");
+	}
+#else
+	(void)path;
+#endif
+}
+
+
+//Strings are written as their length, then their characters.
+static void writeString(std::ofstream& output, const std::string& text)
+{
+	uint32_t length = text.size();
+	output.write(reinterpret_cast<const char*>(&length), sizeof(length));
+	output.write(text.data(), length);
+}
+
+
+static bool readString(std::ifstream& input, std::string& text)
+{
+	uint32_t length = 0;
+	if (!input.read(reinterpret_cast<char*>(&length), sizeof(length)) || length > 4096)
+	{
+		return false;
+	}
+	text.resize(length);
+	return bool(input.read(text.data(), length));
+}
+
+
+/*The table file holds the table as TranspositionTable::saveChanges() writes it.
+ *The checkpoint file holds MAGIC and VERSION, then the position, the players, the target, the split depth,
+ *the node count, the number of tasks, each task's finished flag, and each task's result.*/
+void saveCheckpoint(const std::string& path, const SolveCheckpoint& checkpoint, TranspositionTable& table)
+{
+	//Only the changed blocks need writing over a table of the same size. Anything else gets a whole new table,
+	//written beside it first, so there is always a whole table in place.
+	std::string tableFile = tablePath(path);
+	{
+		uint64_t numSlots = 0;
+		std::fstream output(tableFile, std::ios::binary | std::ios::in | std::ios::out);
+		bool everything = !output.read(reinterpret_cast<char*>(&numSlots), sizeof(numSlots)) || numSlots != table.capacity();
+		std::string written = everything ? tableFile + ".tmp" : tableFile;
+		if (everything)
+		{
+			output.close();
+			output.open(written, std::ios::binary | std::ios::out | std::ios::trunc);
+		}
+
+		output.clear();
+		output.seekp(0);
+		table.saveChanges(output, everything);
+		output.flush();
+		if (!output)
+		{
+			throw std::runtime_error("Could not write \"" + written + "\".");
+		}
+		output.close();
+		syncPath(written);
+
+		std::error_code error;
+		if (everything)
+		{
+			std::filesystem::rename(written, tableFile, error);
+		}
+		if (error)
+		{
+			throw std::runtime_error("Could not replace \"" + tableFile + "\": " + error.message());
+		}
+	}
+
+	std::string temporary = path + ".tmp";
+	{
+		std::ofstream output(temporary, std::ios::binary);
+		output.write(MAGIC, sizeof(MAGIC));
+		output.write(reinterpret_cast<const char*>(&VERSION), sizeof(VERSION));
+		writeString(output, checkpoint.position);
+		writeString(output, checkpoint.players);
+		output.write(reinterpret_cast<const char*>(&checkpoint.target), sizeof(checkpoint.target));
+		output.write(reinterpret_cast<const char*>(&checkpoint.splitDepth), sizeof(checkpoint.splitDepth));
+		output.write(reinterpret_cast<const char*>(&checkpoint.nodes), sizeof(checkpoint.nodes));
+
+		uint64_t numTasks = checkpoint.finished.size();
+		output.write(reinterpret_cast<const char*>(&numTasks), sizeof(numTasks));
+		output.write(reinterpret_cast<const char*>(checkpoint.finished.data()), numTasks);
+		output.write(reinterpret_cast<const char*>(checkpoint.results.data()), numTasks * sizeof(OutcomeSet));
+
+		output.flush();
+		if (!output)
+		{
+			throw std::runtime_error("Could not write \"" + temporary + "\".");
+		}
+	}
+	syncPath(temporary);
+
+	std::error_code error;
+	std::filesystem::rename(temporary, path, error);
+	if (error)
+	{
+		throw std::runtime_error("Could not replace \"" + path + "\": " + error.message());
+	}
+
+	//The renames only last once the directory holding the files is synced too.
+	std::filesystem::path directory = std::filesystem::absolute(path).parent_path();
+	syncPath(directory);
+}
+
+
+SolveCheckpoint readCheckpoint(const std::string& path)
+{
+	std::ifstream input(path, std::ios::binary);
+	if (!input)
+	{
+		throw std::runtime_error("Could not read \"" + path + "\".");
+	}
+
+	char magic[sizeof(MAGIC)] = {};
+	uint32_t version = 0;
+	input.read(magic, sizeof(magic));
+	input.read(reinterpret_cast<char*>(&version), sizeof(version));
+	if (!input || std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0 || version != VERSION)
+	{
+		throw std::runtime_error("\"" + path + "\" is not a checkpoint, (or was written by an older version).");
+	}
+
+	SolveCheckpoint checkpoint;
+	uint64_t numTasks = 0;
+	bool complete = readString(input, checkpoint.position) && readString(input, checkpoint.players)
+		&& input.read(reinterpret_cast<char*>(&checkpoint.target), sizeof(checkpoint.target))
+		&& input.read(reinterpret_cast<char*>(&checkpoint.splitDepth), sizeof(checkpoint.splitDepth))
+		&& input.read(reinterpret_cast<char*>(&checkpoint.nodes), sizeof(checkpoint.nodes))
+		&& input.read(reinterpret_cast<char*>(&numTasks), sizeof(numTasks))
+		&& numTasks <= (1 << 24);
+
+	if (complete)
+	{
+		checkpoint.finished.resize(numTasks);
+		checkpoint.results.resize(numTasks);
+		complete = input.read(reinterpret_cast<char*>(checkpoint.finished.data()), numTasks)
+			&& input.read(reinterpret_cast<char*>(checkpoint.results.data()), numTasks * sizeof(OutcomeSet));
+	}
+
+	if (!complete)
+	{
+		throw std::runtime_error("\"" + path + "\" is truncated.");
+	}
+
+	return checkpoint;
+}
+
+
+void readCheckpointTable(const std::string& path, TranspositionTable& table)
+{
+	std::string tableFile = tablePath(path);
+	std::ifstream input(tableFile, std::ios::binary);
+	if (!input)
+	{
+		throw std::runtime_error("Could not read \"" + tableFile + "\".");
+	}
+
+	try
+	{
+		table.load(input);
+	}
+	catch (const std::runtime_error&)
+	{
+		throw std::runtime_error("\"" + tableFile + "\" is truncated.");
+	}
+}
+
+
+void removeCheckpoint(const std::string& path)
+{
+	std::error_code error;
+	std::filesystem::remove(path, error);
+	std::filesystem::remove(tablePath(path), error);
+}
@@ -0,0 +1,61 @@
+#ifndef CHECKPOINT_HPP
+#define CHECKPOINT_HPP
+
+#include "outcome.hpp"
+#include "transposition_table.hpp"
+#include <string>
+#include <vector>
+#include <cstdint>
+
+
+/*How far a parallel solve has got, as kept in a checkpoint, (see Solver::setCheckpoint()).
+ *A checkpoint is two files: this, at the checkpoint's path, and the solver's transposition table, next to it,
+ *at the same path with ".table" on the end.*/
+struct SolveCheckpoint
+{
+	/*What is being solved: the position, (as getBoardPosition() writes it), each seat's policy, (as SeatPolicies::names()),
+	 *and the outcomes asked for. A checkpoint is only resumed by a search for exactly the same thing.*/
+	std::string position;
+	std::string players;
+	OutcomeSet target;
+
+	/*Number of moves below the position at which the search was split into tasks.
+	 *Splitting again at the same depth gives the same tasks, in the same order.*/
+	uint8_t splitDepth;
+
+	/*Whether each task has finished, and if so, the outcomes reachable from it.*/
+	std::vector<uint8_t> finished;
+	std::vector<OutcomeSet> results;
+
+	/*Positions visited by the finished tasks, and while splitting the search.*/
+	uint64_t nodes;
+};
+
+
+/*Saves `checkpoint`, and the blocks of `table` changed since the last save, (see TranspositionTable::saveChanges()),
+ *or all of it, to a new file which then replaces the old one, if the table file doesn't hold a table of the same size yet.
+ *The table is updated in place first, and synced to disk. Each of its slots checks itself, and holds a result that is
+ *true of the search whenever it was written, so a crash part way through leaves a table which is still safe to resume from,
+ *even alongside the previous checkpoint.
+ *`checkpoint` is then written to a temporary file, which is synced and renamed over the last one, and the directory synced,
+ *so the file at `path` is always a complete checkpoint, even after a crash or power loss.
+ *Other threads can carry on using the table meanwhile.
+ *Throws std::runtime_error if a file can't be written.*/
+void saveCheckpoint(const std::string& path, const SolveCheckpoint& checkpoint, TranspositionTable& table);
+
+
+/*Reads a checkpoint written by saveCheckpoint(), apart from its table.
+ *Throws std::runtime_error if the file can't be read, or isn't a checkpoint.*/
+SolveCheckpoint readCheckpoint(const std::string& path);
+
+
+/*Loads the table saved with the checkpoint at `path` into `table`.
+ *Throws std::runtime_error if the file can't be read, or is cut short.*/
+void readCheckpointTable(const std::string& path, TranspositionTable& table);
+
+
+/*Deletes the checkpoint at `path`, and its table, if there is one.*/
+void removeCheckpoint(const std::string& path);
+
+
+#endif
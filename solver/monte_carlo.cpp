@@ -0,0 +1,308 @@
+#include "monte_carlo.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cassert>
+
+
+template <class Board>
+MonteCarloSearch<Board>::MonteCarloSearch(std::size_t megabytes, s_t threads, double exploration, uint64_t seed)
+	: exploration(exploration), seed(seed)
+{
+	//The root always needs a node, and its children need one each.
+	capacity = std::max<std::size_t>(megabytes * 1024 * 1024 / sizeof(Node), NUM_SQUARES + 1);
+	arena = std::make_unique<Node[]>(capacity);
+	used = 0;
+	hasTree = false;
+	numPlayouts = 0;
+	playoutLimit = 0;
+	hasDeadline = false;
+	stopping = false;
+	numThreads = std::max<s_t>(threads, 1);
+}
+
+
+template <class Board>
+auto MonteCarloSearch<Board>::allocate(s_t count) -> Node*
+{
+	std::size_t start = used.fetch_add(count, std::memory_order_relaxed);
+	return (start + count <= capacity) ? &arena[start] : nullptr;
+}
+
+
+template <class Board>
+void MonteCarloSearch<Board>::resetTree()
+{
+	for (std::size_t index = 0; index < treeSize(); index++)
+	{
+		Node& node = arena[index];
+		node.visits.store(0, std::memory_order_relaxed);
+		node.virtualLoss.store(0, std::memory_order_relaxed);
+		for (std::atomic<uint32_t>& count : node.outcomes)
+		{
+			count.store(0, std::memory_order_relaxed);
+		}
+		node.children = nullptr;
+		node.numChildren = 0;
+		node.state.store(UNEXPANDED, std::memory_order_relaxed);
+	}
+
+	used = 0;
+	allocate(1);
+	numPlayouts = 0;
+}
+
+
+template <class Board>
+void MonteCarloSearch<Board>::search(const Board& board, const SearchBudget& budget)
+{
+	assert(!board.isOver() && (budget.seconds > 0 || budget.playouts > 0));
+
+	if (!hasTree || board.getKey() != rootBoard.getKey())
+	{
+		rootBoard = board;
+		resetTree();
+		hasTree = true;
+	}
+
+	playoutLimit = std::min((budget.playouts > 0) ? numPlayouts + budget.playouts : UINT64_MAX, MAX_PLAYOUTS);
+	hasDeadline = (budget.seconds > 0);
+	deadline = std::chrono::steady_clock::now()
+		+ std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(budget.seconds));
+	stopping = false;
+
+	//Every call gets fresh random numbers, so that searching the same position again doesn't replay the same playouts.
+	uint64_t firstSeed = seed + numPlayouts * numThreads;
+	if (numThreads == 1)
+	{
+		runThread(firstSeed);
+		return;
+	}
+
+	if (!pool)
+	{
+		pool = std::make_unique<ThreadPool>(numThreads);
+	}
+	for (s_t thread = 0; thread < numThreads; thread++)
+	{
+		pool->submit([this, firstSeed, thread]() { runThread(firstSeed + thread); });
+	}
+	pool->wait();
+}
+
+
+template <class Board>
+void MonteCarloSearch<Board>::runThread(uint64_t threadSeed)
+{
+	std::mt19937_64 random(threadSeed);
+	Board board = rootBoard;
+
+	for (uint64_t iteration = 1; !stopping.load(std::memory_order_relaxed); iteration++)
+	{
+		iterate(board, random);
+
+		if (numPlayouts.fetch_add(1, std::memory_order_relaxed) + 1 >= playoutLimit
+			|| (hasDeadline && iteration % CLOCK_INTERVAL == 0 && std::chrono::steady_clock::now() >= deadline))
+		{
+			stopping.store(true, std::memory_order_relaxed);
+		}
+	}
+}
+
+
+template <class Board>
+void MonteCarloSearch<Board>::iterate(Board& board, std::mt19937_64& random)
+{
+	Node* path[NUM_SQUARES + 1];
+	s_t depth = 0;
+	Node* node = &arena[0];
+	path[0] = node;
+	node->virtualLoss.fetch_add(1, std::memory_order_relaxed);
+
+	/*Walk down the tree until reaching a child nobody has played out yet.
+	 *Nodes are expanded the second time they are reached, so the tree grows by about one node per playout.*/
+	while (!board.isOver())
+	{
+		if (node->state.load(std::memory_order_acquire) != EXPANDED && !expand(*node, board))
+		{
+			break;
+		}
+
+		node = &selectChild(*node, board);
+		bool unvisited = (node->visits.load(std::memory_order_relaxed) == 0);
+		Position move = Board::squarePosition(node->square);
+		board.makeMove(move.row, move.col);
+		node->virtualLoss.fetch_add(1, std::memory_order_relaxed);
+		path[++depth] = node;
+
+		if (unvisited)
+		{
+			break;
+		}
+	}
+
+	s_t outcome = board.isOver() ? outcomeIndex(board.getWinner()) : playout(board, random);
+
+	for (s_t index = 0; index <= depth; index++)
+	{
+		path[index]->outcomes[outcome].fetch_add(1, std::memory_order_relaxed);
+		path[index]->visits.fetch_add(1, std::memory_order_relaxed);
+		path[index]->virtualLoss.fetch_sub(1, std::memory_order_relaxed);
+	}
+
+	for (s_t index = 0; index < depth; index++)
+	{
+		board.undoLastMove();
+	}
+}
+
+
+template <class Board>
+bool MonteCarloSearch<Board>::expand(Node& node, const Board& board)
+{
+	uint8_t expected = UNEXPANDED;
+	if (!node.state.compare_exchange_strong(expected, EXPANDING, std::memory_order_acquire))
+	{
+		return false;
+	}
+
+	typename Board::Bitboard allowed = board.semiCompetentMoves();
+	s_t numChildren = popCount(allowed);
+	Node* children = allocate(numChildren);
+	if (!children)
+	{
+		//The arena is full, so the node stays a leaf for good.
+		return false;
+	}
+
+	for (s_t index = 0; index < numChildren; index++)
+	{
+		children[index].square = lowestBit(allowed);
+		allowed &= allowed - 1;
+	}
+
+	node.children = children;
+	node.numChildren = numChildren;
+	node.state.store(EXPANDED, std::memory_order_release);
+	return true;
+}
+
+
+/*A win counts 1 towards the mover's score, and a draw 1/NUM_PLAYERS.
+ *Children nobody has visited yet are tried first, in order.*/
+template <class Board>
+auto MonteCarloSearch<Board>::selectChild(const Node& node, const Board& board) const -> Node&
+{
+	s_t mover = Board::tokenIndex(board.getTurnPlayer());
+	double parentVisits = node.visits.load(std::memory_order_relaxed) + node.virtualLoss.load(std::memory_order_relaxed);
+	double logParent = std::log(std::max(parentVisits, 1.0));
+
+	Node* best = &node.children[0];
+	double bestScore = -1;
+	for (s_t index = 0; index < node.numChildren; index++)
+	{
+		Node& child = node.children[index];
+		double visits = child.visits.load(std::memory_order_relaxed) + child.virtualLoss.load(std::memory_order_relaxed);
+		if (visits == 0)
+		{
+			return child;
+		}
+
+		double score = child.outcomes[mover].load(std::memory_order_relaxed)
+			+ child.outcomes[NUM_PLAYERS].load(std::memory_order_relaxed) / double(NUM_PLAYERS);
+		score = score / visits + exploration * std::sqrt(logParent / visits);
+		if (score > bestScore)
+		{
+			bestScore = score;
+			best = &child;
+		}
+	}
+	return *best;
+}
+
+
+template <class Board>
+s_t MonteCarloSearch<Board>::playout(Board& board, std::mt19937_64& random)
+{
+	s_t numMoves = 0;
+	while (!board.isOver())
+	{
+		//Pick a uniformly random allowed move by clearing a random number of the lowest set bits.
+		typename Board::Bitboard allowed = board.semiCompetentMoves();
+		for (s_t skip = random() % popCount(allowed); skip > 0; skip--)
+		{
+			allowed &= allowed - 1;
+		}
+
+		Position move = Board::squarePosition(lowestBit(allowed));
+		board.makeMove(move.row, move.col);
+		numMoves++;
+	}
+
+	s_t outcome = outcomeIndex(board.getWinner());
+	for (; numMoves > 0; numMoves--)
+	{
+		board.undoLastMove();
+	}
+	return outcome;
+}
+
+
+template <class Board>
+Position MonteCarloSearch<Board>::bestMove() const
+{
+	std::vector<MoveStats<NUM_PLAYERS>> stats = moveStats();
+	return stats.empty() ? Position {0, 0} : stats[0].move;
+}
+
+
+template <class Board>
+auto MonteCarloSearch<Board>::winRates() const -> std::array<double, NUM_PLAYERS + 1>
+{
+	std::array<double, NUM_PLAYERS + 1> rates {};
+	if (!hasTree)
+	{
+		return rates;
+	}
+
+	const Node& root = arena[0];
+	double visits = std::max<uint32_t>(root.visits.load(std::memory_order_relaxed), 1);
+	for (s_t outcome = 0; outcome <= NUM_PLAYERS; outcome++)
+	{
+		rates[outcome] = root.outcomes[outcome].load(std::memory_order_relaxed) / visits;
+	}
+	return rates;
+}
+
+
+template <class Board>
+auto MonteCarloSearch<Board>::moveStats() const -> std::vector<MoveStats<NUM_PLAYERS>>
+{
+	std::vector<MoveStats<NUM_PLAYERS>> stats;
+	if (!hasTree || arena[0].state.load(std::memory_order_acquire) != EXPANDED)
+	{
+		return stats;
+	}
+
+	const Node& root = arena[0];
+	for (s_t index = 0; index < root.numChildren; index++)
+	{
+		const Node& child = root.children[index];
+		MoveStats<NUM_PLAYERS> move {Board::squarePosition(child.square), child.visits.load(std::memory_order_relaxed), {}};
+		for (s_t outcome = 0; outcome <= NUM_PLAYERS; outcome++)
+		{
+			move.rates[outcome] = child.outcomes[outcome].load(std::memory_order_relaxed) / std::max<double>(move.visits, 1);
+		}
+		stats.push_back(move);
+	}
+
+	std::stable_sort(stats.begin(), stats.end(), [](const MoveStats<NUM_PLAYERS>& first, const MoveStats<NUM_PLAYERS>& second)
+	{
+		return first.visits > second.visits;
+	});
+	return stats;
+}
+
+
+template class MonteCarloSearch<MTT_Board3x5>;
+template class MonteCarloSearch<MTT_Board4x4>;
+template class MonteCarloSearch<MTT_Board5x5>;
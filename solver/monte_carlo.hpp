@@ -0,0 +1,203 @@
+#ifndef MONTE_CARLO_HPP
+#define MONTE_CARLO_HPP
+
+#include "mtt_board.hpp"
+#include "thread_pool.hpp"
+#include <array>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <cstdint>
+
+
+/*How long a Monte Carlo search may run. It stops at whichever limit it reaches first.
+ *A limit of 0 means no limit of that kind, and at least one of them has to be set.*/
+struct SearchBudget
+{
+	double seconds = 0;
+	uint64_t playouts = 0;
+};
+
+
+/*What the search has seen of one move from the searched position.
+ *`rates` is the fraction of playouts through the move ending in each outcome:
+ *a win for each player in turn order, (X, O, then Y), followed by draws.*/
+template <s_t NUM_PLAYERS>
+struct MoveStats
+{
+	Position move;
+	uint64_t visits;
+	std::array<double, NUM_PLAYERS + 1> rates;
+};
+
+
+/*Monte Carlo tree search for boards too big to solve exactly.
+ *Every player picks moves in the tree with UCT, each trying to maximize their own share of the results,
+ *(a win is worth 1 to the winner, and a draw 1/NUM_PLAYERS to everybody),
+ *so the search needs no assumption about who plays against whom.
+ *Both the tree and the random playouts below it only use moves the semi-competent rule allows,
+ *so the statistics describe games between the README's players.
+ *Tree nodes are carved out of one preallocated arena with a bump pointer, so the search never allocates while running.
+ *Once the arena is used up, the tree stops growing, and the search carries on with playouts from its leaves.
+ *Several threads can grow the same tree at once: a thread passing through a node adds a "virtual loss" to it until
+ *its playout's result is in, which steers the other threads onto different lines.
+ *Results can be read at any time, including while another thread is searching.
+ *`Board` is any MTT_Board variant; member functions are instantiated for each one in monte_carlo.cpp.*/
+template <class Board>
+class MonteCarloSearch
+{
+	public:
+		static constexpr s_t NUM_PLAYERS = Board::players.size() - 1;
+
+
+	private:
+		static constexpr uint8_t NUM_SQUARES = Board::NUM_SQUARES;
+
+
+		/*How often, in playouts, each thread looks at the clock.*/
+		static constexpr uint64_t CLOCK_INTERVAL = 64;
+
+
+		/*Node counters are 32 bits, so a tree stops taking playouts a little short of overflowing them.*/
+		static constexpr uint64_t MAX_PLAYOUTS = UINT32_MAX - (1 << 16);
+
+
+		enum ExpandState : uint8_t {UNEXPANDED, EXPANDING, EXPANDED};
+
+
+		/*One position in the tree, reached by playing `square` from its parent.
+		 *`outcomes` counts playouts through the node ending in each outcome, indexed like MoveStats::rates.
+		 *`children` is only safe to read once `state` is EXPANDED.*/
+		struct Node
+		{
+			std::atomic<uint32_t> visits;
+			std::atomic<uint32_t> virtualLoss;
+			std::atomic<uint32_t> outcomes[NUM_PLAYERS + 1];
+			Node* children;
+			uint8_t numChildren;
+			uint8_t square;
+			std::atomic<uint8_t> state;
+		};
+
+
+		/*Every node of the tree, the root first. `used` is the bump pointer, and can run past the end,
+		 *in which case allocations fail.*/
+		std::unique_ptr<Node[]> arena;
+		std::size_t capacity;
+		std::atomic<std::size_t> used;
+
+
+		/*Position at the root, so a search of the same position carries on growing the existing tree.*/
+		Board rootBoard;
+		bool hasTree;
+
+
+		double exploration;
+		uint64_t seed;
+
+
+		/*Settings of the running search, and how far it has got.*/
+		std::atomic<uint64_t> numPlayouts;
+		uint64_t playoutLimit;
+		std::chrono::steady_clock::time_point deadline;
+		bool hasDeadline;
+		std::atomic<bool> stopping;
+
+
+		/*Number of threads search() uses, and the pool running them, (created on first use).*/
+		s_t numThreads;
+		std::unique_ptr<ThreadPool> pool;
+
+
+		/*Hands out `count` consecutive fresh nodes, or nullptr if the arena doesn't have room for them.*/
+		Node* allocate(s_t count);
+
+
+		/*Clears the tree, leaving only a fresh root.*/
+		void resetTree();
+
+
+		/*Gives the node children for every move the semi-competent rule allows on `board`.
+		 *Returns false if another thread is already doing so, or the arena is full.*/
+		bool expand(Node& node, const Board& board);
+
+
+		/*Picks the child with the best UCT score for the board's turn player, counting virtual losses as visits.*/
+		Node& selectChild(const Node& node, const Board& board) const;
+
+
+		/*Plays random semi-competent moves until the game ends, returns the outcome's index, (as in MoveStats::rates),
+		 *and takes the moves back.*/
+		static s_t playout(Board& board, std::mt19937_64& random);
+
+
+		/*Runs one selection, expansion, playout, and backup from the root.
+		 *The board must hold the root position, and is left holding it.*/
+		void iterate(Board& board, std::mt19937_64& random);
+
+
+		/*Runs iterations, with random numbers seeded from `threadSeed`, until the budget runs out or stop() is called.*/
+		void runThread(uint64_t threadSeed);
+
+
+		static s_t outcomeIndex(Token winner)
+		{
+			return (winner == NONE) ? NUM_PLAYERS : Board::tokenIndex(winner);
+		}
+
+
+	public:
+		/*Creates a search whose tree takes at most `megabytes` of memory, running on `threads` threads.
+		 *`exploration` is UCT's exploration constant; higher values try more moves before settling on the best ones.
+		 *A single thread with a playout budget gives the same result every time for the same `seed`.*/
+		explicit MonteCarloSearch(std::size_t megabytes = 256, s_t threads = 1, double exploration = 1.4,
+			uint64_t seed = 0);
+
+
+		/*Searches the board's position within `budget`, and returns once the budget runs out or stop() is called.
+		 *Searching the same position as the last call carries on with the tree built so far, (up to about four billion playouts),
+		 *so results keep improving over repeated calls; any other position starts a new tree.
+		 *Precondition: the game is not over.*/
+		void search(const Board& board, const SearchBudget& budget);
+
+
+		/*Makes a running search return as soon as its threads finish their current playouts.
+		 *Safe to call from any thread.*/
+		void stop() { stopping.store(true, std::memory_order_relaxed); }
+
+
+		/*The rest of the queries describe the tree as it stands,
+		 *and may be called while search() is running on another thread, but not while a new search is starting.*/
+
+
+		/*Returns the move from the root with the most playouts, which is the most trustworthy choice,
+		 *or {0, 0} if the search hasn't expanded the root yet.*/
+		Position bestMove() const;
+
+
+		/*Returns the fraction of all playouts so far ending in each outcome, indexed like MoveStats::rates.*/
+		std::array<double, NUM_PLAYERS + 1> winRates() const;
+
+
+		/*Returns the statistics of every move from the root, most visited first.*/
+		std::vector<MoveStats<NUM_PLAYERS>> moveStats() const;
+
+
+		/*Returns the number of playouts run on the current tree.*/
+		uint64_t playouts() const { return numPlayouts.load(std::memory_order_relaxed); }
+
+
+		/*Returns the number of arena nodes the tree is using, out of treeCapacity().*/
+		std::size_t treeSize() const { return std::min(used.load(std::memory_order_relaxed), capacity); }
+		std::size_t treeCapacity() const { return capacity; }
+};
+
+
+extern template class MonteCarloSearch<MTT_Board3x5>;
+extern template class MonteCarloSearch<MTT_Board4x4>;
+extern template class MonteCarloSearch<MTT_Board5x5>;
+
+
+#endif
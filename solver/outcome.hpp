@@ -0,0 +1,35 @@
+#ifndef OUTCOME_HPP
+#define OUTCOME_HPP
+
+#include "mtt_board.hpp"
+#include <cstdint>
+
+
+/*Each way a game can end, stored as a bit flag,
+ *so that any combination of outcomes fits inside a single OutcomeSet.*/
+enum Outcome : uint8_t
+{
+	X_WINS = 1,
+	O_WINS = 2,
+	Y_WINS = 4,
+	DRAW = 8
+};
+typedef uint8_t OutcomeSet;
+const OutcomeSet ALL_OUTCOMES = X_WINS | O_WINS | Y_WINS | DRAW;
+
+
+/*Returns the outcome flag matching the winner of a finished game,
+ *where "NONE" represents a draw.*/
+inline Outcome outcomeOf(Token winner)
+{
+	switch (winner)
+	{
+		case X: return X_WINS;
+		case O: return O_WINS;
+		case Y: return Y_WINS;
+		default: return DRAW;
+	}
+}
+
+
+#endif
@@ -0,0 +1,123 @@
+#include "outcome_odds.hpp"
+
+
+//Starting size of the table, in slots.
+const std::size_t INITIAL_SLOTS = 1 << 16;
+
+
+template <class Board>
+OddsSolver<Board>::OddsSolver()
+{
+	clear();
+}
+
+
+template <class Board>
+void OddsSolver<Board>::clear()
+{
+	slots = std::vector<Slot>(INITIAL_SLOTS);
+	numUsed = 0;
+}
+
+
+template <class Board>
+OutcomeOdds OddsSolver<Board>::solve(Board& board)
+{
+	return search(board);
+}
+
+
+template <class Board>
+auto OddsSolver<Board>::findSlot(PositionKey key) -> Slot&
+{
+	std::size_t mask = slots.size() - 1;
+	std::size_t index = hashPositionKey(key) & mask;
+	while (slots[index].storedKey != 0 && slots[index].storedKey != key + 1)
+	{
+		index = (index + 1) & mask;
+	}
+	return slots[index];
+}
+
+
+template <class Board>
+void OddsSolver<Board>::grow()
+{
+	std::vector<Slot> old(slots.size() * 2);
+	old.swap(slots);
+	for (const Slot& slot : old)
+	{
+		if (slot.storedKey != 0)
+		{
+			findSlot(slot.storedKey - 1) = slot;
+		}
+	}
+}
+
+
+template <class Board>
+OutcomeOdds OddsSolver<Board>::search(Board& board)
+{
+	OutcomeOdds odds {};
+
+	if (board.isOver())
+	{
+		odds.chance[std::countr_zero(unsigned(outcomeOf(board.getWinner())))] = 1;
+		return odds;
+	}
+
+	//The turn player's winning squares all end the game the same way, so there is no need to remember these.
+	Token turn = board.getTurnPlayer();
+	if (board.winningSquares(turn))
+	{
+		odds.chance[std::countr_zero(unsigned(outcomeOf(turn)))] = 1;
+		return odds;
+	}
+
+	/*Symmetric copies share the same smallest hash, and the key of the copy with that hash is exact,
+	 *so the table never mixes up two different positions, even if their hashes collide.*/
+	Symmetry symmetry;
+	board.getSymmetricHash(symmetry);
+	PositionKey key = board.getKey(symmetry);
+
+	if (Slot& slot = findSlot(key); slot.storedKey != 0)
+	{
+		return slot.odds;
+	}
+
+	typename Board::Bitboard allowed = board.semiCompetentMoves();
+	int numMoves = popCount(allowed);
+	while (allowed)
+	{
+		Position move = Board::squarePosition(lowestBit(allowed));
+		allowed &= allowed - 1;
+
+		board.makeMove(move.row, move.col);
+		OutcomeOdds child = search(board);
+		board.undoLastMove();
+
+		for (s_t outcome = 0; outcome < 4; outcome++)
+		{
+			odds.chance[outcome] += child.chance[outcome];
+		}
+	}
+
+	for (double& chance : odds.chance)
+	{
+		chance /= numMoves;
+	}
+
+	//The slot found before searching the moves may have been moved since, by the table growing.
+	if (8 * (numUsed + 1) > 7 * slots.size())
+	{
+		grow();
+	}
+	findSlot(key) = {PositionKey(key + 1), odds};
+	numUsed++;
+	return odds;
+}
+
+
+template class OddsSolver<MTT_Board3x5>;
+template class OddsSolver<MTT_Board4x4>;
+template class OddsSolver<MTT_Board5x5>;
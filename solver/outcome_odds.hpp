@@ -0,0 +1,87 @@
+#ifndef OUTCOME_ODDS_HPP
+#define OUTCOME_ODDS_HPP
+
+#include "mtt_board.hpp"
+#include "outcome.hpp"
+#include <vector>
+#include <bit>
+#include <cstdint>
+
+
+/*Chance of each way a game can end, indexed in the order X, O, Y, draw,
+ *(the same order as the Outcome flags).*/
+struct OutcomeOdds
+{
+	double chance[4];
+
+	double of(Outcome outcome) const { return chance[std::countr_zero(unsigned(outcome))]; }
+};
+
+
+/*Works out the exact chance of each outcome when every player picks uniformly at random
+ *between the moves the semi-competent rule allows them.
+ *A position's odds are the average of the odds after each allowed move, so they are worked out depth-first,
+ *and remembered for every position met, under the key of its canonical symmetric copy,
+ *so each distinct position is only worked out once, however many move orders lead to it.
+ *That keeps the cost down to the number of distinct positions rather than the number of games,
+ *which makes every position of the 3x5 and 4x4 boards cheap, but is still far too much for the 5x5 board from the start.
+ *An outcome has a chance above zero exactly when the exhaustive solver finds it reachable,
+ *since every game that can happen has a chance of at least 1 / NUM_SQUARES!.
+ *`Board` is any MTT_Board variant; member functions are instantiated for each one in outcome_odds.cpp.*/
+template <class Board>
+class OddsSolver
+{
+	private:
+		typedef typename Board::PositionKey PositionKey;
+
+
+		/*Remembered positions, in an open-addressed table with linear probing,
+		 *which doubles in size whenever it gets seven eighths full.
+		 *Keys are stored plus one, so that a zero key marks an empty slot, (the empty board's own key is zero).
+		 *That never overflows, since the turn player's index, (at the top of the key), is at most 2.*/
+		struct Slot
+		{
+			PositionKey storedKey;
+			OutcomeOdds odds;
+		};
+
+		std::vector<Slot> slots;
+		std::size_t numUsed;
+
+
+		/*Returns the slot holding `key`, or the empty slot where it belongs.*/
+		Slot& findSlot(PositionKey key);
+
+
+		void grow();
+
+
+		/*Recursive step. The board is left in the same position it was handed in.*/
+		OutcomeOdds search(Board& board);
+
+
+	public:
+		OddsSolver();
+
+
+		/*Returns the odds of each outcome from the board's position.
+		 *Positions worked out by earlier calls are remembered, so later calls on related positions are cheaper.
+		 *The board is back in its original position when this returns.*/
+		OutcomeOdds solve(Board& board);
+
+
+		/*Number of distinct positions remembered so far.*/
+		std::size_t numPositions() const { return numUsed; }
+
+
+		/*Forgets every remembered position, freeing their memory.*/
+		void clear();
+};
+
+
+extern template class OddsSolver<MTT_Board3x5>;
+extern template class OddsSolver<MTT_Board4x4>;
+extern template class OddsSolver<MTT_Board5x5>;
+
+
+#endif
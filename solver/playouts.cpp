@@ -0,0 +1,151 @@
+#include "playouts.hpp"
+#include "thread_pool.hpp"
+#include <vector>
+#include <algorithm>
+
+
+template <class Board, class Seats>
+PlayoutGenerator<Board, Seats>::PlayoutGenerator(const Board& start)
+{
+	for (s_t player = 0; player < NUM_PLAYERS; player++)
+	{
+		startBoards[player] = start.playerSquares(Board::players[player]);
+		startThreats[player] = start.winningSquares(Board::players[player]);
+	}
+	startTurn = Board::tokenIndex(start.getTurnPlayer());
+
+	startEmpty = start.emptySquares();
+	startNumEmpty = 0;
+	for (s_t square = 0; square < Board::NUM_SQUARES; square++)
+	{
+		if (startEmpty & Geometry::squareBit(square))
+		{
+			startListIndex[square] = startNumEmpty;
+			startEmptyList[startNumEmpty++] = square;
+		}
+	}
+
+	startOver = start.isOver();
+	Token winner = start.getWinner();
+	finalResult.outcome = uint8_t((winner == NONE) ? NUM_PLAYERS : Board::tokenIndex(winner));
+	finalResult.length = uint8_t(Board::NUM_SQUARES - startNumEmpty);
+}
+
+
+/*The empty squares are also kept in a list, (with each square's place in it), so a uniformly random empty square
+ *is a single lookup, and taking one out just moves the last square of the list into its place.
+ *The rarer restricted choices, (eg. blocking a square), select a bit of the few squares allowed instead.*/
+template <class Board, class Seats>
+PlayoutResult PlayoutGenerator<Board, Seats>::play(Xoshiro256& random) const
+{
+	if (startOver)
+	{
+		return finalResult;
+	}
+
+	Bitboard boards[NUM_PLAYERS];
+	Bitboard threats[NUM_PLAYERS];
+	for (s_t player = 0; player < NUM_PLAYERS; player++)
+	{
+		boards[player] = startBoards[player];
+		threats[player] = startThreats[player];
+	}
+
+	uint8_t emptyList[Board::NUM_SQUARES];
+	uint8_t listIndex[Board::NUM_SQUARES];
+	std::copy(startEmptyList, startEmptyList + Board::NUM_SQUARES, emptyList);
+	std::copy(startListIndex, startListIndex + Board::NUM_SQUARES, listIndex);
+	s_t numEmpty = startNumEmpty;
+	Bitboard empty = startEmpty;
+	s_t turn = startTurn;
+
+	while (true)
+	{
+		if (numEmpty == 0)
+		{
+			return {uint8_t(NUM_PLAYERS), Board::NUM_SQUARES};
+		}
+
+		s_t next = (turn + 1 == NUM_PLAYERS) ? 0 : turn + 1;
+		Bitboard allowed = Seats::allowedMoves(turn, empty, threats[turn], threats[next]);
+
+		//Any winning square ends the game the same way, so there is no need to pick one if every allowed square wins.
+		if ((allowed & Bitboard(~threats[turn])) == 0)
+		{
+			return {uint8_t(turn), uint8_t(Board::NUM_SQUARES - numEmpty + 1)};
+		}
+
+		s_t square = (allowed == empty) ? emptyList[random.below(numEmpty)] : selectBit(allowed, random.below(popCount(allowed)));
+		if (threats[turn] & Geometry::squareBit(square))
+		{
+			return {uint8_t(turn), uint8_t(Board::NUM_SQUARES - numEmpty + 1)};
+		}
+
+		uint8_t last = emptyList[--numEmpty];
+		emptyList[listIndex[square]] = last;
+		listIndex[last] = listIndex[square];
+
+		Bitboard bit = Geometry::squareBit(square);
+		boards[turn] |= bit;
+		empty &= Bitboard(~bit);
+		for (s_t player = 0; player < NUM_PLAYERS; player++)
+		{
+			threats[player] &= empty;
+		}
+		threats[turn] = Geometry::threatSquares(boards[turn]) & empty;
+		turn = next;
+	}
+}
+
+
+template <class Board, class Seats>
+PlayoutStats<Board> PlayoutGenerator<Board, Seats>::run(uint64_t numGames, s_t threads, uint64_t seed) const
+{
+	threads = std::max<s_t>(threads, 1);
+	std::vector<PlayoutStats<Board>> threadStats(threads);
+
+	auto runThread = [&](s_t thread)
+	{
+		Xoshiro256 random(seed);
+		for (s_t jump = 0; jump < thread; jump++)
+		{
+			random.jump();
+		}
+
+		//The first threads take one extra game each when the games don't divide evenly.
+		//Tallies are kept locally until the end, so threads never write to the same cache lines.
+		uint64_t share = numGames / threads + (thread < numGames % threads);
+		PlayoutStats<Board> stats;
+		for (uint64_t game = 0; game < share; game++)
+		{
+			stats.add(play(random));
+		}
+		threadStats[thread] = stats;
+	};
+
+	if (threads == 1)
+	{
+		runThread(0);
+	}
+	else
+	{
+		ThreadPool pool(threads);
+		for (s_t thread = 0; thread < threads; thread++)
+		{
+			pool.submit([&, thread]() { runThread(thread); });
+		}
+		pool.wait();
+	}
+
+	PlayoutStats<Board> stats;
+	for (const PlayoutStats<Board>& partial : threadStats)
+	{
+		stats.merge(partial);
+	}
+	return stats;
+}
+
+
+MTT_INSTANTIATE_SEATS(template, PlayoutGenerator, MTT_Board3x5)
+MTT_INSTANTIATE_SEATS(template, PlayoutGenerator, MTT_Board4x4)
+MTT_INSTANTIATE_SEATS(template, PlayoutGenerator, MTT_Board5x5)
@@ -0,0 +1,142 @@
+#ifndef PLAYOUTS_HPP
+#define PLAYOUTS_HPP
+
+#include "mtt_board.hpp"
+#include "player_policy.hpp"
+#include "xoshiro.hpp"
+#include <array>
+#include <cstdint>
+
+
+/*How a single playout ended. `outcome` is the winner's index in turn order, (0 for X),
+ *or NUM_PLAYERS for a draw, and `length` is the total number of moves in the finished game.*/
+struct PlayoutResult
+{
+	uint8_t outcome;
+	uint8_t length;
+};
+
+
+/*Tallies of many playouts.
+ *`games[outcome][length]` counts games ending in `outcome`, (indexed like PlayoutResult::outcome),
+ *after `length` moves in total.*/
+template <class Board>
+struct PlayoutStats
+{
+	static constexpr s_t NUM_PLAYERS = Board::players.size() - 1;
+
+	std::array<std::array<uint64_t, Board::NUM_SQUARES + 1>, NUM_PLAYERS + 1> games {};
+
+
+	void add(PlayoutResult result) { games[result.outcome][result.length]++; }
+
+
+	void merge(const PlayoutStats& other)
+	{
+		for (s_t outcome = 0; outcome <= NUM_PLAYERS; outcome++)
+		{
+			for (s_t length = 0; length <= Board::NUM_SQUARES; length++)
+			{
+				games[outcome][length] += other.games[outcome][length];
+			}
+		}
+	}
+
+
+	/*Games ending in `outcome`, whatever their length.*/
+	uint64_t outcomeCount(s_t outcome) const
+	{
+		uint64_t count = 0;
+		for (uint64_t games : games[outcome])
+		{
+			count += games;
+		}
+		return count;
+	}
+
+
+	/*Games of `length` moves, whatever their outcome.*/
+	uint64_t lengthCount(s_t length) const
+	{
+		uint64_t count = 0;
+		for (s_t outcome = 0; outcome <= NUM_PLAYERS; outcome++)
+		{
+			count += games[outcome][length];
+		}
+		return count;
+	}
+
+
+	uint64_t total() const
+	{
+		uint64_t count = 0;
+		for (s_t outcome = 0; outcome <= NUM_PLAYERS; outcome++)
+		{
+			count += outcomeCount(outcome);
+		}
+		return count;
+	}
+};
+
+
+/*Plays random games from a fixed starting position as fast as possible, to estimate how often each outcome comes up.
+ *Games are played on bare bitboards rather than on an MTT_Board: there is no validation, history, or hashing,
+ *every player's winning squares are recomputed with a few shifts after each move,
+ *and moves are picked with xoshiro256** from a list of the empty squares, without looping over squares.
+ *Each player picks uniformly at random between the squares their policy in `Seats` allows, (see player_policy.hpp),
+ *which is the semi-competent rule for everyone by default.
+ *`Board` is any MTT_Board variant; member functions are instantiated for each one,
+ *with every combination of the built-in policies, in playouts.cpp.*/
+template <class Board, class Seats = SemiCompetentSeats<Board>>
+class PlayoutGenerator
+{
+	public:
+		static constexpr s_t NUM_PLAYERS = Board::players.size() - 1;
+
+
+	private:
+		typedef typename Board::Bitboard Bitboard;
+		typedef typename Board::Geometry Geometry;
+
+
+		/*The starting position, and the index of its turn player.*/
+		Bitboard startBoards[NUM_PLAYERS];
+		Bitboard startThreats[NUM_PLAYERS];
+		s_t startTurn;
+
+
+		/*The starting position's empty squares, as a bitboard and as a list,
+		 *with `startListIndex[square]` being where each empty square sits in the list.*/
+		Bitboard startEmpty;
+		uint8_t startEmptyList[Board::NUM_SQUARES];
+		uint8_t startListIndex[Board::NUM_SQUARES];
+		s_t startNumEmpty;
+
+
+		/*Set if the starting position is already over, in which case every playout just returns `finalResult`.*/
+		bool startOver;
+		PlayoutResult finalResult;
+
+
+	public:
+		/*Sets up playouts from the board's current position.*/
+		explicit PlayoutGenerator(const Board& start);
+
+
+		/*Plays one game to the end with random numbers from `random`, and returns how it ended.*/
+		PlayoutResult play(Xoshiro256& random) const;
+
+
+		/*Plays `numGames` games spread over `threads` threads, and returns their tallies.
+		 *Every thread draws from its own stream of the generator seeded with `seed`, and plays a fixed share of the games,
+		 *so the same seed and thread count always give the same tallies.*/
+		PlayoutStats<Board> run(uint64_t numGames, s_t threads = 1, uint64_t seed = 0) const;
+};
+
+
+MTT_INSTANTIATE_SEATS(extern template, PlayoutGenerator, MTT_Board3x5)
+MTT_INSTANTIATE_SEATS(extern template, PlayoutGenerator, MTT_Board4x4)
+MTT_INSTANTIATE_SEATS(extern template, PlayoutGenerator, MTT_Board5x5)
+
+
+#endif
@@ -0,0 +1,293 @@
+#include "proof_search.hpp"
+#include <algorithm>
+#include <cassert>
+
+
+template <class Board>
+ProofSearch<Board>::ProofSearch(std::size_t megabytes)
+{
+	//Find the largest power of two number of buckets which fits in the budget, (at least one).
+	std::size_t budget = megabytes * 1024 * 1024 / (sizeof(Entry) * ENTRIES_PER_BUCKET);
+	std::size_t numBuckets = 1;
+	while (numBuckets * 2 <= budget)
+	{
+		numBuckets *= 2;
+	}
+
+	table = std::make_unique<Entry[]>(numBuckets * ENTRIES_PER_BUCKET);
+	bucketMask = numBuckets - 1;
+	goal = ProofGoal::X_CAN_WIN;
+	nodes = 0;
+	maxNodes = UINT64_MAX;
+}
+
+
+template <class Board>
+ProofResult ProofSearch<Board>::prove(Board& board, ProofGoal goal, uint64_t maxNodes)
+{
+	std::fill(table.get(), table.get() + (bucketMask + 1) * ENTRIES_PER_BUCKET, Entry {0, {0, 0}, 0});
+	this->goal = goal;
+	this->maxNodes = maxNodes;
+	nodes = 0;
+
+	ProofNumbers numbers = search(board, INFINITE, INFINITE);
+
+	ProofResult result;
+	result.resolved = (numbers.proof == 0 || numbers.disproof == 0);
+	result.proven = (numbers.proof == 0);
+	result.treeComplete = true;
+
+	if (result.proven)
+	{
+		//The answer is already known, so rebuilding lost parts of the proof mustn't run out of budget.
+		this->maxNodes = UINT64_MAX;
+		collectProof(board, 1, result.proofTree, result.treeComplete);
+	}
+
+	result.nodes = nodes;
+	return result;
+}
+
+
+template <class Board>
+bool ProofSearch<Board>::lookup(uint64_t key, ProofNumbers& numbers) const
+{
+	const Entry* bucket = &table[(key & bucketMask) * ENTRIES_PER_BUCKET];
+	for (std::size_t slot = 0; slot < ENTRIES_PER_BUCKET; slot++)
+	{
+		if (bucket[slot].work != 0 && bucket[slot].key == key)
+		{
+			numbers = bucket[slot].numbers;
+			return true;
+		}
+	}
+	return false;
+}
+
+
+/*Overwrites the same position if it is already there, then an empty entry,
+ *then whichever entry took the least work to find.*/
+template <class Board>
+void ProofSearch<Board>::store(uint64_t key, ProofNumbers numbers, uint64_t work)
+{
+	Entry* bucket = &table[(key & bucketMask) * ENTRIES_PER_BUCKET];
+	Entry* victim = &bucket[0];
+
+	for (std::size_t slot = 0; slot < ENTRIES_PER_BUCKET; slot++)
+	{
+		if (bucket[slot].work == 0 || bucket[slot].key == key)
+		{
+			victim = &bucket[slot];
+			break;
+		}
+		if (bucket[slot].work < victim->work)
+		{
+			victim = &bucket[slot];
+		}
+	}
+
+	*victim = {key, numbers, work};
+}
+
+
+template <class Board>
+auto ProofSearch<Board>::evaluate(const Board& board) const -> ProofNumbers
+{
+	const ProofNumbers PROVEN {0, INFINITE};
+	const ProofNumbers DISPROVEN {INFINITE, 0};
+
+	if (board.isOver())
+	{
+		return (board.getWinner() == X) ? PROVEN : DISPROVEN;
+	}
+
+	//The semi-competent rule makes the turn player take a win, so the game is as good as over.
+	Token turn = board.getTurnPlayer();
+	if (board.winningSquares(turn))
+	{
+		return (turn == X) ? PROVEN : DISPROVEN;
+	}
+
+	ProofNumbers numbers;
+	Symmetry symmetry;
+	if (lookup(board.getSymmetricHash(symmetry), numbers))
+	{
+		return numbers;
+	}
+
+	//A choice is easy to prove and hard to disprove the more moves it has, and the other way around for a forced reply.
+	uint32_t numMoves = popCount(board.semiCompetentMoves());
+	return isOrNode(board) ? ProofNumbers {1, numMoves} : ProofNumbers {numMoves, 1};
+}
+
+
+template <class Board>
+uint32_t ProofSearch<Board>::addNumbers(uint32_t first, uint32_t second)
+{
+	if (first == INFINITE || second == INFINITE)
+	{
+		return INFINITE;
+	}
+	return uint32_t(std::min<uint64_t>(uint64_t(first) + second, INFINITE - 1));
+}
+
+
+/*Goes a quarter past the second most promising child, (the "1 + epsilon" trick).*/
+template <class Board>
+uint32_t ProofSearch<Board>::growLimit(uint32_t second)
+{
+	if (second == INFINITE)
+	{
+		return INFINITE;
+	}
+	return uint32_t(std::min<uint64_t>(uint64_t(second) + second / 4 + 1, INFINITE - 1));
+}
+
+
+/*Children are evaluated once up front, and each one searched keeps the numbers its search returned,
+ *so a child whose entry has dropped out of the table isn't mistaken for a fresh one.*/
+template <class Board>
+auto ProofSearch<Board>::search(Board& board, uint32_t proofLimit, uint32_t disproofLimit) -> ProofNumbers
+{
+	ProofNumbers numbers = evaluate(board);
+	if (numbers.proof == 0 || numbers.disproof == 0 || numbers.proof >= proofLimit || numbers.disproof >= disproofLimit)
+	{
+		return numbers;
+	}
+
+	nodes++;
+	uint64_t startNodes = nodes;
+	bool orNode = isOrNode(board);
+
+	Position moves[NUM_SQUARES];
+	ProofNumbers children[NUM_SQUARES];
+	uint8_t numMoves = 0;
+	typename Board::Bitboard allowed = board.semiCompetentMoves();
+	while (allowed)
+	{
+		moves[numMoves] = Board::squarePosition(lowestBit(allowed));
+		allowed &= allowed - 1;
+
+		board.makeMove(moves[numMoves].row, moves[numMoves].col);
+		children[numMoves] = evaluate(board);
+		board.undoLastMove();
+		numMoves++;
+	}
+
+	while (true)
+	{
+		/*An OR node needs one child proven, and all of them disproven.
+		 *An AND node is the other way around.
+		 *`value` is whichever number the node is trying to bring down through its best child.*/
+		uint32_t minimum = INFINITE;
+		uint32_t sum = 0;
+		uint32_t second = INFINITE;
+		uint8_t best = 0;
+
+		for (uint8_t index = 0; index < numMoves; index++)
+		{
+			uint32_t value = orNode ? children[index].proof : children[index].disproof;
+			uint32_t other = orNode ? children[index].disproof : children[index].proof;
+			sum = addNumbers(sum, other);
+
+			if (value < minimum)
+			{
+				second = minimum;
+				minimum = value;
+				best = index;
+			}
+			else if (value < second)
+			{
+				second = value;
+			}
+		}
+
+		numbers = orNode ? ProofNumbers {minimum, sum} : ProofNumbers {sum, minimum};
+		if (numbers.proof >= proofLimit || numbers.disproof >= disproofLimit || nodes >= maxNodes)
+		{
+			break;
+		}
+
+		uint32_t childProofLimit;
+		uint32_t childDisproofLimit;
+		if (orNode)
+		{
+			childProofLimit = std::min(proofLimit, growLimit(second));
+			childDisproofLimit = disproofLimit - numbers.disproof + children[best].disproof;
+		}
+		else
+		{
+			childProofLimit = proofLimit - numbers.proof + children[best].proof;
+			childDisproofLimit = std::min(disproofLimit, growLimit(second));
+		}
+
+		board.makeMove(moves[best].row, moves[best].col);
+		children[best] = search(board, childProofLimit, childDisproofLimit);
+		board.undoLastMove();
+	}
+
+	Symmetry symmetry;
+	store(board.getSymmetricHash(symmetry), numbers, nodes - startNodes + 1);
+	return numbers;
+}
+
+
+template <class Board>
+void ProofSearch<Board>::collectProof(Board& board, uint8_t depth, std::vector<ProofStep>& tree, bool& complete)
+{
+	if (board.isOver())
+	{
+		return;
+	}
+
+	if (tree.size() >= MAX_TREE_STEPS)
+	{
+		complete = false;
+		return;
+	}
+
+	//Proven positions where somebody can win on the spot are X's wins, and end with the winning move.
+	typename Board::Bitboard wins = board.winningSquares(board.getTurnPlayer());
+	if (wins)
+	{
+		assert(board.getTurnPlayer() == X);
+		tree.push_back({depth, Board::squarePosition(lowestBit(wins))});
+		return;
+	}
+
+	bool orNode = isOrNode(board);
+	typename Board::Bitboard allowed = board.semiCompetentMoves();
+	bool chosen = false;
+
+	//Of a choice, take a child the table already shows to be proven, and only search again if none is.
+	for (s_t pass = 0; pass < 2 && !chosen; pass++)
+	{
+		typename Board::Bitboard remaining = allowed;
+		while (remaining && !(orNode && chosen))
+		{
+			Position move = Board::squarePosition(lowestBit(remaining));
+			remaining &= remaining - 1;
+
+			board.makeMove(move.row, move.col);
+			bool proven = evaluate(board).proof == 0;
+			if (!proven && (pass == 1 || !orNode))
+			{
+				proven = search(board, INFINITE, INFINITE).proof == 0;
+			}
+
+			if (proven)
+			{
+				tree.push_back({depth, move});
+				collectProof(board, depth + 1, tree, complete);
+				chosen = true;
+			}
+			assert(proven || orNode);
+			board.undoLastMove();
+		}
+	}
+}
+
+
+template class ProofSearch<MTT_Board3x5>;
+template class ProofSearch<MTT_Board4x4>;
+template class ProofSearch<MTT_Board5x5>;
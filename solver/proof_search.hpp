@@ -0,0 +1,161 @@
+#ifndef PROOF_SEARCH_HPP
+#define PROOF_SEARCH_HPP
+
+#include "mtt_board.hpp"
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+
+/*The question a proof search answers about the position it is given.*/
+enum class ProofGoal
+{
+	/*Is there ANY sequence of semi-competent moves ending in an X victory? (The README's question.)
+	 *Every player's choice helps, so every node only needs one proven child.*/
+	X_CAN_WIN,
+
+	/*Can X always win, however O and Y pick between the moves the semi-competent rule leaves them?
+	 *X's choices need one proven child, while O's and Y's need every child proven.*/
+	X_FORCES_WIN
+};
+
+
+/*One move of a proof tree, listed in depth-first order.
+ *`depth` counts moves from the searched position, starting at 1,
+ *so a move's replies are the moves right after it with a depth one higher.*/
+struct ProofStep
+{
+	uint8_t depth;
+	Position move;
+};
+
+
+/*What a proof search found.*/
+struct ProofResult
+{
+	/*False if the node budget ran out before the question was answered.*/
+	bool resolved;
+
+	/*The answer, (only meaningful if `resolved`).*/
+	bool proven;
+
+	/*If proven, every move the proof relies on: one move for each position where the proof gets to choose,
+	 *and every allowed move for each position where it doesn't.
+	 *Each branch ends with X's winning move.
+	 *Left incomplete, (with `treeComplete` false), if it would grow past ProofSearch's tree limit.*/
+	std::vector<ProofStep> proofTree;
+	bool treeComplete;
+
+	/*Number of times a position was expanded, (re-expansions included).*/
+	uint64_t nodes;
+};
+
+
+/*Depth-first proof-number search, (df-pn), over the semi-competent game tree.
+ *Every position holds a proof number and a disproof number: the fewest positions below it which still have to be
+ *proven, (or disproven), to settle it. The search always expands the position that is cheapest to settle,
+ *working depth-first within thresholds handed down from its parent,
+ *so it goes straight for the most promising lines, rather than enumerating every continuation in order.
+ *Numbers are kept in a fixed-size table, keyed on the smallest hash of each position's symmetric copies,
+ *so the memory used is bounded however big the tree is.
+ *Positions where the turn player can win on the spot are settled without expanding them,
+ *since the semi-competent rule makes them take the win.
+ *`Board` is any MTT_Board variant; member functions are instantiated for each one in proof_search.cpp.*/
+template <class Board>
+class ProofSearch
+{
+	private:
+		static constexpr uint8_t NUM_SQUARES = Board::NUM_SQUARES;
+
+
+		/*Proof and disproof numbers of settled positions: (0, INFINITE) is proven, and (INFINITE, 0) disproven.*/
+		static constexpr uint32_t INFINITE = UINT32_MAX;
+
+
+		/*Proof trees stop growing at this many steps.*/
+		static constexpr std::size_t MAX_TREE_STEPS = 1 << 20;
+
+
+		struct ProofNumbers
+		{
+			uint32_t proof;
+			uint32_t disproof;
+		};
+
+
+		/*Fixed-size hash table of proof numbers. Buckets of a few entries;
+		 *when a bucket is full, the entry whose subtree took the least work to search is overwritten.*/
+		struct Entry
+		{
+			uint64_t key;
+			ProofNumbers numbers;
+			uint64_t work;
+		};
+
+		static const std::size_t ENTRIES_PER_BUCKET = 4;
+
+		std::unique_ptr<Entry[]> table;
+		uint64_t bucketMask;
+
+
+		ProofGoal goal;
+		uint64_t nodes;
+		uint64_t maxNodes;
+
+
+		/*Adds two proof, (or disproof), numbers. Anything plus INFINITE stays INFINITE,
+		 *while finite sums stop just short of it, so that they never look settled.*/
+		static uint32_t addNumbers(uint32_t first, uint32_t second);
+
+
+		/*Threshold handed to the most promising child: a little past the number of the second most promising one,
+		 *so the search doesn't keep switching back and forth between two close children.*/
+		static uint32_t growLimit(uint32_t second);
+
+
+		bool lookup(uint64_t key, ProofNumbers& numbers) const;
+		void store(uint64_t key, ProofNumbers numbers, uint64_t work);
+
+
+		/*Returns true iff the proof only needs one of the position's children proven.*/
+		bool isOrNode(const Board& board) const
+		{
+			return goal == ProofGoal::X_CAN_WIN || board.getTurnPlayer() == X;
+		}
+
+
+		/*Returns the numbers of the board's position without expanding it:
+		 *exact ones if the game is over or the turn player is about to win,
+		 *the table's if it has them, and otherwise an estimate from the number of moves allowed.*/
+		ProofNumbers evaluate(const Board& board) const;
+
+
+		/*Expands the board's position until its proof number reaches `proofLimit` or its disproof number reaches `disproofLimit`,
+		 *(or the node budget runs out), and returns its numbers at that point.
+		 *The board is left in the same position it was handed in.*/
+		ProofNumbers search(Board& board, uint32_t proofLimit, uint32_t disproofLimit);
+
+
+		/*Appends the proof tree of the board's position, (which must be proven), to `tree`.
+		 *Positions which have dropped out of the table are searched again.*/
+		void collectProof(Board& board, uint8_t depth, std::vector<ProofStep>& tree, bool& complete);
+
+
+	public:
+		/*Creates a search with a table using at most `megabytes` of memory.*/
+		explicit ProofSearch(std::size_t megabytes = 64);
+
+
+		/*Answers `goal` for the board's position, expanding at most `maxNodes` positions, (no limit by default).
+		 *The table is emptied first, so every call is independent of the ones before it.
+		 *The board is back in its original position when this returns.*/
+		ProofResult prove(Board& board, ProofGoal goal, uint64_t maxNodes = UINT64_MAX);
+};
+
+
+extern template class ProofSearch<MTT_Board3x5>;
+extern template class ProofSearch<MTT_Board4x4>;
+extern template class ProofSearch<MTT_Board5x5>;
+
+
+#endif
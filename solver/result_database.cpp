@@ -0,0 +1,227 @@
+#include "result_database.hpp"
+#include <fstream>
+#include <filesystem>
+#include <cstring>
+#include <stdexcept>
+
+
+template <class Board>
+ResultDatabase<Board>::ResultDatabase(const std::string& path)
+	: file(path)
+{
+	const Header* header = reinterpret_cast<const Header*>(file.data());
+	if (file.size() < sizeof(Header) || std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0
+		|| header->version != VERSION)
+	{
+		throw std::runtime_error("\"" + path + "\" is not a result database, (or was written by an older version).");
+	}
+
+	if (header->rows != Board::Geometry::ROWS || header->columns != Board::Geometry::COLUMNS
+		|| header->numToWin != Board::Geometry::NUM_TO_WIN || header->numPlayers != Board::Geometry::NUM_PLAYERS
+		|| header->recordSize != sizeof(Record))
+	{
+		throw std::runtime_error("\"" + path + "\" was written for a different board.");
+	}
+
+	if (header->numSlots == 0 || (header->numSlots & (header->numSlots - 1)) != 0
+		|| file.size() != sizeof(Header) + header->numSlots * sizeof(Record))
+	{
+		throw std::runtime_error("\"" + path + "\" is truncated.");
+	}
+
+	slots = reinterpret_cast<const Record*>(file.data() + sizeof(Header));
+	slotMask = header->numSlots - 1;
+	numRecords = header->numRecords;
+}
+
+
+template <class Board>
+auto ResultDatabase<Board>::find(PositionKey key) const -> const Record*
+{
+	//The table is never full, so every probe ends at the position, or at an empty slot.
+	for (uint64_t index = hashPositionKey(key) & slotMask;; index = (index + 1) & slotMask)
+	{
+		if (slots[index].storedKey == PositionKey(key + 1))
+		{
+			return &slots[index];
+		}
+		if (slots[index].storedKey == 0)
+		{
+			return nullptr;
+		}
+	}
+}
+
+
+template <class Board>
+auto ResultDatabase<Board>::lookup(const Board& board, Symmetry& symmetry) const -> const Record*
+{
+	typename Board::CanonicalPosition canonical = board.canonical();
+	symmetry = canonical.symmetry;
+	return find(canonical.key);
+}
+
+
+template <class Board>
+auto ResultDatabase<Board>::lookup(const Board& board) const -> const Record*
+{
+	return find(board.canonical().key);
+}
+
+
+template <class Board>
+bool ResultDatabase<Board>::answer(const Board& board, OutcomeSet target, SolveResult& result) const
+{
+	const Record* record = lookup(board);
+	if (record == nullptr)
+	{
+		return false;
+	}
+
+	//The same test the solver puts transposition table entries to.
+	const TTEntry& entry = record->entry;
+	if ((target & ~entry.known) != 0 && (entry.reachable & target) != target)
+	{
+		return false;
+	}
+
+	result.reachable = entry.reachable;
+	result.witness.clear();
+	result.nodes = 0;
+
+	//Follow the best moves to an X victory, giving up if the records run out before getting there.
+	Board line = board;
+	while (result.xCanWin() && !line.isOver())
+	{
+		Symmetry symmetry;
+		record = lookup(line, symmetry);
+		if (record == nullptr || record->entry.bestMove == NO_MOVE)
+		{
+			return false;
+		}
+
+		Position move = Board::transformSquare(Board::squarePosition(record->entry.bestMove), inverseSymmetry(symmetry));
+		line.makeMove(move.row, move.col);
+		result.witness.push_back(move);
+	}
+
+	return !result.xCanWin() || line.getWinner() == X;
+}
+
+
+template <class Board>
+void ResultDatabase<Board>::addResult(Board board, OutcomeSet target, const SolveResult& result, std::vector<Record>& records)
+{
+	/*The search only stops early once it has found every outcome asked for,
+	 *so if it didn't find them all, it was exhaustive, and knows every outcome.*/
+	TTEntry entry;
+	entry.reachable = result.reachable;
+	entry.known = ((result.reachable & target) == target) ? result.reachable : ALL_OUTCOMES;
+	entry.depth = Board::NUM_SQUARES - board.getNumMoves();
+
+	//Every position along the witness line can still lead to X winning, but nothing more is known about it.
+	for (Position move : result.witness)
+	{
+		typename Board::CanonicalPosition canonical = board.canonical();
+		Position bestMove = Board::transformSquare(move, canonical.symmetry);
+		entry.bestMove = bestMove.row * Board::Geometry::COLUMNS + bestMove.col;
+		records.push_back({PositionKey(canonical.key + 1), entry});
+
+		board.makeMove(move.row, move.col);
+		entry = {X_WINS, X_WINS, NO_MOVE, uint8_t(Board::NUM_SQUARES - board.getNumMoves())};
+	}
+
+	if (result.witness.empty())
+	{
+		entry.bestMove = NO_MOVE;
+		records.push_back({PositionKey(board.canonical().key + 1), entry});
+	}
+}
+
+
+template <class Board>
+void ResultDatabase<Board>::save(const std::string& path, std::vector<Record> records)
+{
+	if (std::filesystem::exists(path))
+	{
+		ResultDatabase old(path);
+		for (const Record& record : old)
+		{
+			if (record.storedKey != 0)
+			{
+				records.push_back(record);
+			}
+		}
+	}
+
+	//At most half full, so probes stay short, and there is always an empty slot to end them.
+	uint64_t numSlots = 16;
+	while (numSlots < 2 * records.size())
+	{
+		numSlots *= 2;
+	}
+
+	std::vector<Record> table(numSlots, Record {0, {0, 0, NO_MOVE, 0}});
+	uint64_t numStored = 0;
+	for (const Record& record : records)
+	{
+		uint64_t index = hashPositionKey(PositionKey(record.storedKey - 1)) & (numSlots - 1);
+		while (table[index].storedKey != 0 && table[index].storedKey != record.storedKey)
+		{
+			index = (index + 1) & (numSlots - 1);
+		}
+
+		//Records read back from older files may hold anything in their padding, so only the fields are copied.
+		Record& slot = table[index];
+		if (slot.storedKey == 0)
+		{
+			slot.storedKey = record.storedKey;
+			slot.entry = record.entry;
+			numStored++;
+			continue;
+		}
+
+		//Both records are true of the position, so together they know everything either one does.
+		slot.entry.reachable |= record.entry.reachable;
+		slot.entry.known |= record.entry.known;
+		if (slot.entry.bestMove == NO_MOVE)
+		{
+			slot.entry.bestMove = record.entry.bestMove;
+		}
+	}
+
+	Header header {};
+	std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+	header.version = VERSION;
+	header.rows = Board::Geometry::ROWS;
+	header.columns = Board::Geometry::COLUMNS;
+	header.numToWin = Board::Geometry::NUM_TO_WIN;
+	header.numPlayers = Board::Geometry::NUM_PLAYERS;
+	header.recordSize = sizeof(Record);
+	header.numSlots = numSlots;
+	header.numRecords = numStored;
+
+	std::string temporary = path + ".tmp";
+	{
+		std::ofstream output(temporary, std::ios::binary);
+		output.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+		output.write(reinterpret_cast<const char*>(table.data()), table.size() * sizeof(Record));
+
+		if (!output)
+		{
+			throw std::runtime_error("Could not write \"" + temporary + "\".");
+		}
+	}
+
+	std::error_code error;
+	std::filesystem::rename(temporary, path, error);
+	if (error)
+	{
+		throw std::runtime_error("Could not replace \"" + path + "\": " + error.message());
+	}
+}
+
+
+template class ResultDatabase<MTT_Board3x5>;
+template class ResultDatabase<MTT_Board4x4>;
+template class ResultDatabase<MTT_Board5x5>;
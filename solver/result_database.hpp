@@ -0,0 +1,127 @@
+#ifndef RESULT_DATABASE_HPP
+#define RESULT_DATABASE_HPP
+
+#include "mtt_board.hpp"
+#include "mapped_file.hpp"
+#include "outcome.hpp"
+#include "transposition_table.hpp"
+#include "solver.hpp"
+#include <string>
+#include <vector>
+#include <type_traits>
+#include <cstdint>
+
+
+/*Solver results kept in a file between runs, so a position solved once never has to be searched again.
+ *
+ *Unlike the tablebase, which holds every position of a small board, this only holds the positions
+ *which have actually been solved, (and the positions along their witness lines), so it works on any board.
+ *The file is an open-addressed hash table of fixed-size records, keyed on the exact key of each position's
+ *canonical symmetric copy, at most half full, so a lookup is one canonical() call and a probe or two.
+ *Opening the file just maps it, and lookups hand back pointers straight into the mapping,
+ *so nothing is read or rebuilt up front, and queries are answered from the page cache.
+ *Files are only ever replaced whole by save(), so a file is never changed while it is open.
+ *`Board` is any MTT_Board variant; member functions are instantiated for each one in result_database.cpp.*/
+template <class Board>
+class ResultDatabase
+{
+	public:
+		typedef typename Board::PositionKey PositionKey;
+
+
+		/*One position's record, as it sits in the file.
+		 *`storedKey` is the canonical copy's key plus one, so that zero marks an empty slot,
+		 *(the empty board's own key is zero). That never overflows, since the turn player's index,
+		 *(at the top of the key), is at most 2.
+		 *`entry` means the same as it does in the transposition table,
+		 *with `bestMove` played on the canonical copy.
+		 *`padding` fills the record out to the key's alignment, and is always zero,
+		 *so every byte written to the file is set, and the same records always give the same file.*/
+		struct Record
+		{
+			PositionKey storedKey;
+			TTEntry entry;
+			uint8_t padding[sizeof(PositionKey) - sizeof(TTEntry)] = {};
+		};
+		static_assert(std::has_unique_object_representations_v<Record>, "A Record has padding the file would hold garbage in.");
+
+
+	private:
+		/*Start of every file, followed by `numSlots` records, (a power of two).*/
+		struct alignas(16) Header
+		{
+			char magic[4];
+			uint32_t version;
+			uint8_t rows;
+			uint8_t columns;
+			uint8_t numToWin;
+			uint8_t numPlayers;
+			uint32_t recordSize;
+			uint64_t numSlots;
+			uint64_t numRecords;
+		};
+
+		static constexpr char MAGIC[4] = {'M', 'T', 'T', 'R'};
+		static constexpr uint32_t VERSION = 1;
+
+
+		MappedFile file;
+		const Record* slots;
+		uint64_t slotMask;
+		uint64_t numRecords;
+
+
+	public:
+		/*Opens the database file at `path`.
+		 *Throws std::runtime_error if it can't be read, or wasn't written for this board variant.*/
+		explicit ResultDatabase(const std::string& path);
+
+
+		/*Returns the record of the position whose canonical copy has the key `key`, or nullptr if there is none.
+		 *The record points into the mapped file, so it lives as long as the database does.*/
+		const Record* find(PositionKey key) const;
+
+
+		/*Returns the record of the board's position, or nullptr if there is none.
+		 *`symmetry` is set to the symmetry which maps the board onto the canonical copy the record describes,
+		 *so the record's best move maps back onto the board with inverseSymmetry(symmetry).*/
+		const Record* lookup(const Board& board, Symmetry& symmetry) const;
+		const Record* lookup(const Board& board) const;
+
+
+		/*Answers Solver::solve(board, target) from the database, if the records are enough to.
+		 *Returns true and fills `result`, (with zero nodes), iff the board's record settles every outcome in `target`,
+		 *and, if X can win, the records lead all the way along a line of moves to an X victory.*/
+		bool answer(const Board& board, OutcomeSet target, SolveResult& result) const;
+
+
+		/*Number of positions in the file.*/
+		uint64_t size() const { return numRecords; }
+
+
+		/*Every slot of the table, including the empty ones, (whose `storedKey` is zero).*/
+		const Record* begin() const { return slots; }
+		const Record* end() const { return slots + slotMask + 1; }
+
+
+		/*Appends records of everything `result` says about `board`,
+		 *(as returned by Solver::solve(board, target)), to `records`:
+		 *one for the board itself, and one for each position along the witness line.*/
+		static void addResult(Board board, OutcomeSet target, const SolveResult& result, std::vector<Record>& records);
+
+
+		/*Writes `records` to the database file at `path`, along with every record already in it, if it exists.
+		 *Records of the same position are combined, keeping everything either one knows.
+		 *The new file is written next to the old one, then renamed over it,
+		 *so anything which still has the old file open keeps reading the old contents.
+		 *Throws std::runtime_error if the old file isn't a database for this board variant, or the new one can't be written.*/
+		static void save(const std::string& path, std::vector<Record> records);
+};
+
+
+extern template class ResultDatabase<MTT_Board3x5>;
+extern template class ResultDatabase<MTT_Board4x4>;
+extern template class ResultDatabase<MTT_Board5x5>;
+
+
+#endif
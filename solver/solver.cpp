@@ -1 +1,635 @@
-#include "solver.hpp"
\ No newline at end of file
+#include "solver.hpp"
+#include "search_stats.hpp"
+#include "checkpoint.hpp"
+#include <unordered_map>
+#include <mutex>
+#include <condition_variable>
+#include <filesystem>
+#include <stdexcept>
+#include "packed_position.hpp"
+
+
+template <class Board, class Seats>
+Solver<Board, Seats>::Solver(s_t threads)
+	: ownTable(std::make_unique<TranspositionTable>())
+{
+	table = ownTable.get();
+	nodes = 0;
+	wanted = X_WINS;
+	numThreads = std::max<s_t>(threads, 1);
+	cutoff = nullptr;
+	taskIndex = 0;
+	aborted = false;
+	limits = nullptr;
+	cancelled = nullptr;
+	stopped = false;
+	stopReason = SolveStatus::COMPLETE;
+	rootMoves = 0;
+	truncations = 0;
+	found = 0;
+	nodesUntilCheck = 0;
+	checkpointInterval = 0;
+	resume = false;
+}
+
+
+template <class Board, class Seats>
+Solver<Board, Seats>::Solver(TranspositionTable& sharedTable, s_t threads)
+{
+	table = &sharedTable;
+	nodes = 0;
+	wanted = X_WINS;
+	numThreads = std::max<s_t>(threads, 1);
+	cutoff = nullptr;
+	taskIndex = 0;
+	aborted = false;
+	limits = nullptr;
+	cancelled = nullptr;
+	stopped = false;
+	stopReason = SolveStatus::COMPLETE;
+	rootMoves = 0;
+	truncations = 0;
+	found = 0;
+	nodesUntilCheck = 0;
+	checkpointInterval = 0;
+	resume = false;
+}
+
+
+template <class Board, class Seats>
+SolveResult Solver<Board, Seats>::solve(Board& board, OutcomeSet target)
+{
+	nodes = 0;
+	wanted = target;
+
+	if ((numThreads > 1 || !checkpointPath.empty()) && !board.isOver())
+	{
+		return solveParallel(board);
+	}
+
+	SolveResult result;
+	result.reachable = search(board);
+	if (result.xCanWin())
+	{
+		result.witness = findWitness(board);
+	}
+	result.nodes = nodes;
+
+	return result;
+}
+
+
+/*Depth-first search over every move the seats' policies allow.
+ *Each move is made on the board, searched, then undone before the next one is tried.*/
+template <class Board, class Seats>
+OutcomeSet Solver<Board, Seats>::search(Board& board)
+{
+	/*Every position counts towards the next check of the limits, finished games and table hits included.
+	 *Once a limit is hit, positions are left unexplored without being counted, so the node budget is never overrun.*/
+	if (limits && (stopped || (--nodesUntilCheck == 0 && checkLimits(board.getNumMoves()))))
+	{
+		truncations++;
+		return 0;
+	}
+
+	nodes++;
+	MTT_COUNT(STAT_NODES);
+	MTT_COUNT_DEPTH(board.getNumMoves());
+
+	if (board.isOver())
+	{
+		OutcomeSet outcome = outcomeOf(board.getWinner());
+		found |= outcome;
+		return outcome;
+	}
+
+	if (cutoff && cutoff->load(std::memory_order_relaxed) < taskIndex)
+	{
+		aborted = true;
+		return 0;
+	}
+
+	/*Reflections and rotations of a position share the same entry.
+	 *An earlier result is only good enough if it already settles every wanted outcome,
+	 *either by having found all of them, or by having been an exhaustive search.*/
+	Symmetry symmetry;
+	uint64_t key = board.getSymmetricHash(symmetry);
+	TTEntry entry;
+	if (table->probe(key, entry)
+		&& ((wanted & ~entry.known) == 0 || (entry.reachable & wanted) == wanted))
+	{
+		found |= entry.reachable;
+		return entry.reachable;
+	}
+
+	Position moves[NUM_SQUARES];
+	uint8_t numMoves = candidateMoves(board, moves);
+	uint64_t truncationsBefore = truncations;
+
+	entry.reachable = 0;
+	entry.known = ALL_OUTCOMES;
+	entry.bestMove = NO_MOVE;
+	entry.depth = NUM_SQUARES - board.getNumMoves();
+
+	for (uint8_t index = 0; index < numMoves; index++)
+	{
+		board.makeMove(moves[index].row, moves[index].col);
+		OutcomeSet childReachable = search(board);
+		board.undoLastMove();
+
+		//Best moves are stored as they would be played on the symmetric copy the hash belongs to.
+		if (entry.bestMove == NO_MOVE && (childReachable & X_WINS))
+		{
+			Position bestMove = Board::transformSquare(moves[index], symmetry);
+			entry.bestMove = bestMove.row * COLUMNS + bestMove.col;
+		}
+		entry.reachable |= childReachable;
+
+		/*No need to look any further once everything asked for has been found,
+		 *but then nothing can be said about the outcomes that weren't found.*/
+		if ((entry.reachable & wanted) == wanted)
+		{
+			entry.known = entry.reachable;
+			MTT_COUNT(STAT_CUTOFFS);
+			break;
+		}
+	}
+
+	if (aborted)
+	{
+		return entry.reachable;
+	}
+
+	//Anything found is still reachable if a stop left some of the tree unexplored, but nothing is known about the rest.
+	if (truncations != truncationsBefore)
+	{
+		entry.known = entry.reachable;
+	}
+
+	table->store(key, entry);
+	return entry.reachable;
+}
+
+
+template <class Board, class Seats>
+std::vector<Position> Solver<Board, Seats>::findWitness(Board& board)
+{
+	std::vector<Position> witness;
+	wanted = X_WINS;
+
+	while (!board.isOver())
+	{
+		Position moves[NUM_SQUARES];
+		uint8_t numMoves = candidateMoves(board, moves);
+		uint8_t chosen = numMoves;
+
+		/*Trust the table's best move, as long as it is one of the allowed moves.
+		 *It has to be mapped back from the symmetric copy it was stored for.*/
+		Symmetry symmetry;
+		TTEntry entry;
+		if (table->probe(board.getSymmetricHash(symmetry), entry) && entry.bestMove != NO_MOVE)
+		{
+			Position stored {uint8_t(entry.bestMove / COLUMNS), uint8_t(entry.bestMove % COLUMNS)};
+			Position bestMove = Board::transformSquare(stored, inverseSymmetry(symmetry));
+			for (uint8_t index = 0; index < numMoves; index++)
+			{
+				if (moves[index].row == bestMove.row && moves[index].col == bestMove.col)
+				{
+					chosen = index;
+					break;
+				}
+			}
+		}
+
+		//Otherwise search each move again until one reaches an X victory.
+		for (uint8_t index = 0; chosen == numMoves && index < numMoves; index++)
+		{
+			board.makeMove(moves[index].row, moves[index].col);
+			if (search(board) & X_WINS)
+			{
+				chosen = index;
+			}
+			board.undoLastMove();
+		}
+
+		//Only a search with limits can fail to find the move, once it has hit one. The witness then stops here.
+		assert(chosen < numMoves || limits);
+		if (chosen == numMoves)
+		{
+			break;
+		}
+		board.makeMove(moves[chosen].row, moves[chosen].col);
+		witness.push_back(moves[chosen]);
+	}
+
+	//Put the board back the way it was handed in.
+	for (s_t move = 0; move < witness.size(); move++)
+	{
+		board.undoLastMove();
+	}
+
+	return witness;
+}
+
+
+template <class Board, class Seats>
+uint8_t Solver<Board, Seats>::candidateMoves(const Board& board, Position moves[NUM_SQUARES])
+{
+	typename Board::Bitboard allowed = Seats::allowedMoves(board);
+
+	//Every winning move ends the game the same way, so only one of them needs searching.
+	typename Board::Bitboard wins = allowed & board.winningSquares(board.getTurnPlayer());
+	if (wins)
+	{
+		allowed = (allowed & ~wins) | (wins & (~wins + 1));
+	}
+
+	uint8_t numMoves = 0;
+	while (allowed)
+	{
+		moves[numMoves++] = Board::squarePosition(lowestBit(allowed));
+		allowed &= allowed - 1;
+	}
+
+	return numMoves;
+}
+
+
+template <class Board, class Seats>
+uint64_t Solver<Board, Seats>::buildFrontier(Board& board, std::vector<Position>& moves, s_t depth,
+	std::vector<FrontierNode>& frontier)
+{
+	if (depth == 0 || board.isOver())
+	{
+		frontier.push_back({board, moves, frontier.size()});
+		return 0;
+	}
+
+	Position candidates[NUM_SQUARES];
+	uint8_t numCandidates = candidateMoves(board, candidates);
+	uint64_t passed = 1;
+
+	for (uint8_t index = 0; index < numCandidates; index++)
+	{
+		board.makeMove(candidates[index].row, candidates[index].col);
+		moves.push_back(candidates[index]);
+		passed += buildFrontier(board, moves, depth - 1, frontier);
+		moves.pop_back();
+		board.undoLastMove();
+	}
+
+	return passed;
+}
+
+
+/*Splits the tree into tasks at a shallow depth, searches them on the pool, then merges their results in task order.
+ *The outcomes reachable from the solved position are just every outcome reachable from any task.
+ *Tasks after the first one to find every wanted outcome are cancelled, while the ones before it still finish,
+ *so whichever tasks' results get merged, (and so the answer), doesn't depend on how the threads were scheduled.*/
+template <class Board, class Seats>
+SolveResult Solver<Board, Seats>::solveParallel(Board& board)
+{
+	if (!pool)
+	{
+		pool = std::make_unique<ThreadPool>(numThreads);
+	}
+
+	SolveCheckpoint saved;
+	bool resuming = !checkpointPath.empty() && resume && std::filesystem::exists(checkpointPath);
+	if (resuming)
+	{
+		saved = readCheckpoint(checkpointPath);
+		if (saved.position != board.getBoardPosition() || saved.players != Seats::names() || saved.target != wanted)
+		{
+			throw std::runtime_error("\"" + checkpointPath + "\" is a checkpoint of a different search.");
+		}
+	}
+
+	//A resumed search splits at the saved depth, so that its tasks line up with the saved ones.
+	std::vector<FrontierNode> frontier;
+	std::vector<Position> moves;
+	s_t splitDepth = 0;
+	while (resuming ? splitDepth < saved.splitDepth : splitDepth < MAX_SPLIT_DEPTH && frontier.size() < TASKS_PER_THREAD * numThreads)
+	{
+		frontier.clear();
+		nodes = buildFrontier(board, moves, ++splitDepth, frontier);
+	}
+
+	if (resuming)
+	{
+		if (frontier.size() != saved.finished.size())
+		{
+			throw std::runtime_error("\"" + checkpointPath + "\" is a checkpoint of a different search.");
+		}
+		readCheckpointTable(checkpointPath, *table);
+		nodes = saved.nodes;
+	}
+	else if (!checkpointPath.empty())
+	{
+		//Starting over, so nothing of an older search's checkpoint may be mixed into the new one.
+		removeCheckpoint(checkpointPath);
+	}
+
+	//Later checkpoints only write the parts of the table which have changed since the last one.
+	if (!checkpointPath.empty())
+	{
+		table->trackChanges(true);
+	}
+
+	//Only the first copy of each position, (up to symmetry), is searched.
+	std::unordered_map<PackedPosition<Board>, s_t> firstCopy(2 * frontier.size());
+	for (FrontierNode& node : frontier)
+	{
+		node.sameAs = firstCopy.try_emplace(PackedPosition<Board>::canonical(node.board), node.sameAs).first->second;
+	}
+
+	//A task's result is written before it is marked finished, so checkpoints can read finished tasks' results as they run.
+	std::vector<OutcomeSet> results(frontier.size(), 0);
+	std::unique_ptr<std::atomic<bool>[]> finished = std::make_unique<std::atomic<bool>[]>(frontier.size());
+	std::atomic<s_t> firstComplete = frontier.size();
+	std::atomic<uint64_t> taskNodes = 0;
+
+	for (s_t index = 0; resuming && index < frontier.size(); index++)
+	{
+		if (saved.finished[index])
+		{
+			results[index] = saved.results[index];
+			finished[index].store(true, std::memory_order_relaxed);
+			if ((results[index] & wanted) == wanted && index < firstComplete)
+			{
+				firstComplete = index;
+			}
+		}
+	}
+
+	auto saveProgress = [&]()
+	{
+		SolveCheckpoint checkpoint;
+		checkpoint.position = board.getBoardPosition();
+		checkpoint.players = Seats::names();
+		checkpoint.target = wanted;
+		checkpoint.splitDepth = splitDepth;
+		checkpoint.nodes = nodes + taskNodes.load(std::memory_order_relaxed);
+		for (s_t index = 0; index < frontier.size(); index++)
+		{
+			bool done = finished[index].load(std::memory_order_acquire);
+			checkpoint.finished.push_back(done);
+			checkpoint.results.push_back(done ? results[index] : 0);
+		}
+		saveCheckpoint(checkpointPath, checkpoint, *table);
+	};
+
+	std::vector<s_t> tasks;
+	for (s_t index = 0; index < frontier.size(); index++)
+	{
+		if (frontier[index].sameAs == index && !finished[index].load(std::memory_order_relaxed))
+		{
+			tasks.push_back(index);
+		}
+	}
+
+	//Counts the tasks still to run, so that checkpoints can be saved while waiting for them.
+	std::mutex taskMutex;
+	std::condition_variable taskDone;
+	s_t pendingTasks = tasks.size();
+
+	for (s_t index : tasks)
+	{
+		pool->submit([&, index]()
+		{
+			if (firstComplete.load(std::memory_order_relaxed) >= index)
+			{
+				Solver worker(*table);
+				worker.wanted = wanted;
+				worker.cutoff = &firstComplete;
+				worker.taskIndex = index;
+
+				Board taskBoard = frontier[index].board;
+				results[index] = worker.search(taskBoard);
+				taskNodes.fetch_add(worker.nodes, std::memory_order_relaxed);
+
+				if (!worker.aborted)
+				{
+					finished[index].store(true, std::memory_order_release);
+				}
+
+				//Lower the cutoff to this task, unless an earlier task has lowered it already.
+				if (!worker.aborted && (results[index] & wanted) == wanted)
+				{
+					s_t current = firstComplete.load();
+					while (index < current && !firstComplete.compare_exchange_weak(current, index));
+				}
+			}
+
+			std::lock_guard<std::mutex> lock(taskMutex);
+			if (--pendingTasks == 0)
+			{
+				taskDone.notify_all();
+			}
+		});
+	}
+
+	//The tasks refer to this function's locals, so they have to finish before an error is passed on.
+	if (!checkpointPath.empty() && checkpointInterval > 0)
+	{
+		std::unique_lock<std::mutex> lock(taskMutex);
+		std::chrono::duration<double> interval(checkpointInterval);
+		while (!taskDone.wait_for(lock, interval, [&]() { return pendingTasks == 0; }))
+		{
+			lock.unlock();
+			try
+			{
+				saveProgress();
+			}
+			catch (...)
+			{
+				pool->wait();
+				table->trackChanges(false);
+				throw;
+			}
+			lock.lock();
+		}
+	}
+	pool->wait();
+
+	if (!checkpointPath.empty())
+	{
+		try
+		{
+			saveProgress();
+		}
+		catch (...)
+		{
+			table->trackChanges(false);
+			throw;
+		}
+		table->trackChanges(false);
+	}
+
+	SolveResult result;
+	result.reachable = 0;
+	s_t witnessTask = frontier.size();
+
+	for (s_t index = 0; index <= firstComplete && index < frontier.size(); index++)
+	{
+		results[index] = results[frontier[index].sameAs];
+		result.reachable |= results[index];
+		if (witnessTask == frontier.size() && (results[index] & X_WINS))
+		{
+			witnessTask = index;
+		}
+	}
+	nodes += taskNodes;
+
+	//The witness runs through the moves leading to the first task X can win from.
+	if (result.xCanWin())
+	{
+		Board taskBoard = frontier[witnessTask].board;
+		result.witness = frontier[witnessTask].moves;
+		std::vector<Position> rest = findWitness(taskBoard);
+		result.witness.insert(result.witness.end(), rest.begin(), rest.end());
+	}
+	result.nodes = nodes;
+
+	return result;
+}
+
+
+template <class Board, class Seats>
+void Solver<Board, Seats>::setCheckpoint(const std::string& path, double intervalSeconds, bool resumeFrom)
+{
+	checkpointPath = path;
+	checkpointInterval = intervalSeconds;
+	resume = resumeFrom;
+}
+
+
+template <class Board, class Seats>
+SolveHandle Solver<Board, Seats>::solveAsync(const Board& board, const SolveLimits& limits, OutcomeSet target,
+	ThreadPool* sharedPool)
+{
+	if (!sharedPool)
+	{
+		if (!pool)
+		{
+			pool = std::make_unique<ThreadPool>(numThreads);
+		}
+		sharedPool = pool.get();
+	}
+
+	auto cancel = std::make_shared<std::atomic<bool>>(false);
+	auto promise = std::make_shared<std::promise<SolveResult>>();
+	SolveHandle handle(cancel, promise->get_future().share());
+
+	sharedPool->submit([this, searchBoard = board, limits, target, cancel, promise]() mutable
+	{
+		try
+		{
+			promise->set_value(solveLimited(searchBoard, target, limits, *cancel));
+		}
+		catch (...)
+		{
+			promise->set_exception(std::current_exception());
+		}
+	});
+
+	return handle;
+}
+
+
+/*The same depth-first search as solve(), which is already an anytime search:
+ *every outcome it comes across is reachable, so whatever it has found when it stops is a safe answer, if not always a full one.
+ *Positions above a stop are still stored, but only vouch for the outcomes they found, (like positions cut off early),
+ *so a later search, and the witness, can build on them.*/
+template <class Board, class Seats>
+SolveResult Solver<Board, Seats>::solveLimited(Board& board, OutcomeSet target, const SolveLimits& searchLimits,
+	const std::atomic<bool>& cancel)
+{
+	nodes = 0;
+	wanted = target;
+	limits = &searchLimits;
+	cancelled = &cancel;
+	stopped = false;
+	stopReason = SolveStatus::COMPLETE;
+	found = 0;
+	truncations = 0;
+	nodesUntilCheck = 1;
+	rootMoves = board.getNumMoves();
+
+	started = std::chrono::steady_clock::now();
+	deadline = (searchLimits.seconds > 0)
+		? started + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(searchLimits.seconds))
+		: std::chrono::steady_clock::time_point::max();
+	nextProgress = started + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+		std::chrono::duration<double>(searchLimits.progressInterval));
+
+	//The witness is followed within the same limits, mostly through the best moves the search stored on the way,
+	//so it can stop short too, and the status covers both.
+	SolveResult result;
+	result.reachable = search(board);
+	if (result.xCanWin())
+	{
+		result.witness = findWitness(board);
+	}
+	result.status = stopReason;
+	result.nodes = nodes;
+
+	found |= result.reachable;
+	if (searchLimits.onProgress)
+	{
+		reportProgress(std::chrono::steady_clock::now(), rootMoves);
+	}
+	limits = nullptr;
+	cancelled = nullptr;
+
+	return result;
+}
+
+
+template <class Board, class Seats>
+bool Solver<Board, Seats>::checkLimits(s_t moves)
+{
+	auto now = std::chrono::steady_clock::now();
+	if (cancelled->load(std::memory_order_relaxed))
+	{
+		stopReason = SolveStatus::CANCELLED;
+	}
+	else if (nodes >= limits->maxNodes)
+	{
+		stopReason = SolveStatus::OUT_OF_NODES;
+	}
+	else if (now >= deadline)
+	{
+		stopReason = SolveStatus::OUT_OF_TIME;
+	}
+	stopped = (stopReason != SolveStatus::COMPLETE);
+
+	//Check again no later than the position that would go over the node budget.
+	nodesUntilCheck = std::min(LIMIT_CHECK_NODES, limits->maxNodes - std::min(nodes, limits->maxNodes));
+
+	if (limits->onProgress && now >= nextProgress)
+	{
+		reportProgress(now, moves);
+		nextProgress = now + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+			std::chrono::duration<double>(limits->progressInterval));
+	}
+
+	return stopped;
+}
+
+
+template <class Board, class Seats>
+void Solver<Board, Seats>::reportProgress(std::chrono::steady_clock::time_point now, s_t moves)
+{
+	SolveProgress progress;
+	progress.nodes = nodes;
+	progress.depth = moves - rootMoves;
+	progress.reachable = found;
+	progress.seconds = std::chrono::duration<double>(now - started).count();
+	limits->onProgress(progress);
+}
+
+
+MTT_INSTANTIATE_SEATS(template, Solver, MTT_Board3x5)
+MTT_INSTANTIATE_SEATS(template, Solver, MTT_Board4x4)
+MTT_INSTANTIATE_SEATS(template, Solver, MTT_Board5x5)
@@ -2,19 +2,325 @@
 #define SOLVER_HPP
 
 #include "mtt_board.hpp"
-#include <unordered_set>
-#include <stack>
+#include "player_policy.hpp"
+#include "outcome.hpp"
+#include "transposition_table.hpp"
+#include "thread_pool.hpp"
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <future>
+#include <functional>
+#include <chrono>
+#include <string>
+#include <cstdint>
 
+
+/*Whether a search ran to the end, or why it stopped before then.*/
+enum class SolveStatus : uint8_t
+{
+	COMPLETE,
+	CANCELLED,
+	OUT_OF_TIME,
+	OUT_OF_NODES
+};
+
+
+/*Everything the solver learned about a single position.*/
+struct SolveResult
+{
+	/*Every outcome some sequence of moves the solver allows can reach, (semi-competent ones by default).
+	 *Only outcomes which were asked for are guaranteed to be accurate;
+	 *see Solver::solve().*/
+	OutcomeSet reachable;
+
+	/*Moves, starting from the solved position, which lead to an X victory
+	 *while every player follows their policy.
+	 *Empty iff X cannot win, unless the search was stopped, (see `status`).*/
+	std::vector<Position> witness;
+
+	/*Number of positions visited during the search.*/
+	uint64_t nodes;
+
+	/*Anything but COMPLETE means the search was stopped early, (see Solver::solveAsync()),
+	 *in which case `reachable` only holds the outcomes found by then, which are all reachable,
+	 *but there may be more. The witness of an X victory is followed within the same limits,
+	 *so it may stop before the end of the game, or not start at all.*/
+	SolveStatus status = SolveStatus::COMPLETE;
+
+	bool xCanWin() const { return reachable & X_WINS; }
+	bool complete() const { return status == SolveStatus::COMPLETE; }
+};
+
+
+/*How far a search with limits has got, as handed to SolveLimits::onProgress.*/
+struct SolveProgress
+{
+	/*Positions visited so far.*/
+	uint64_t nodes;
+
+	/*Moves below the solved position the search was at, (zero once it has finished).*/
+	s_t depth;
+
+	/*Outcomes found to be reachable so far.*/
+	OutcomeSet reachable;
+
+	double seconds;
+
+	bool xCanWin() const { return reachable & X_WINS; }
+};
+
+
+/*Bounds on a search started with Solver::solveAsync().*/
+struct SolveLimits
+{
+	/*Wall clock time the search may take, in seconds from when it starts running. Zero means no limit.*/
+	double seconds = 0;
+
+	uint64_t maxNodes = UINT64_MAX;
+
+	/*Called from the searching thread with the search's progress, at most once every `progressInterval` seconds,
+	 *and once more when it finishes. Must be quick, since the search waits for it.*/
+	std::function<void(const SolveProgress&)> onProgress;
+	double progressInterval = 0.1;
+};
+
+
+/*A search started by Solver::solveAsync(), to wait on, or cancel.
+ *Copies share the same search.*/
+class SolveHandle
+{
+	private:
+		std::shared_ptr<std::atomic<bool>> cancelled;
+		std::shared_future<SolveResult> result;
+
+
+	public:
+		SolveHandle(std::shared_ptr<std::atomic<bool>> cancelled, std::shared_future<SolveResult> result)
+			: cancelled(std::move(cancelled)), result(std::move(result)) {}
+
+
+		/*Asks the search to stop the next time it checks its limits,
+		 *after which it finishes with its best answer so far, and the CANCELLED status.*/
+		void cancel() { cancelled->store(true, std::memory_order_relaxed); }
+
+
+		bool ready() const { return result.wait_for(std::chrono::seconds(0)) == std::future_status::ready; }
+
+
+		/*Waits up to `seconds` for the search to finish, and returns whether it has.*/
+		bool waitFor(double seconds) const
+		{
+			return result.wait_for(std::chrono::duration<double>(seconds)) == std::future_status::ready;
+		}
+
+
+		/*Waits for the search to finish, and returns its result.
+		 *Rethrows anything the search threw, (eg. std::bad_alloc).*/
+		const SolveResult& get() const { return result.get(); }
+};
+
+
+/*Searches the game tree under the README's "semi-competent" rule:
+ *the turn player always takes an immediate win if one exists,
+ *otherwise always blocks a square on which the next player would immediately win,
+ *and is otherwise free to play anywhere.
+ *Every choice left open by that rule is explored, so the solver answers whether
+ *an outcome is EVER possible, rather than what perfect play leads to.
+ *`Seats` swaps the rule for another policy per player, (see player_policy.hpp),
+ *eg. SeatPolicies<GreedyPolicy, SemiCompetentPolicy, SemiCompetentPolicy> for an X who never blocks.
+ *Policies are compiled into the search, and every combination of the built-in ones is instantiated in solver.cpp.
+ *The search plays moves on the caller's board in place and undoes them on the way back out.
+ *With more than one thread, the first few moves are played out ahead of time,
+ *and the positions they lead to are searched as separate tasks on a work-stealing thread pool,
+ *each on its own copy of the board, all sharing one transposition table.
+ *`Board` is any MTT_Board variant; member functions are instantiated for each one in solver.cpp.*/
+template <class Board, class Seats = SemiCompetentSeats<Board>>
 class Solver
 {
 	private:
-		std::unordered_set<Position> possibleMoves;
-	
+		static constexpr uint8_t ROWS = Board::Geometry::ROWS;
+		static constexpr uint8_t COLUMNS = Board::Geometry::COLUMNS;
+		static constexpr uint8_t NUM_SQUARES = Board::NUM_SQUARES;
+
+
+		/*The parallel search keeps splitting the tree one move deeper
+		 *until there are at least this many tasks per thread, so that there is enough work to steal.*/
+		static constexpr s_t TASKS_PER_THREAD = 16;
+		static constexpr s_t MAX_SPLIT_DEPTH = 6;
+
+
+		/*A position the parallel search hands out as a task,
+		 *along with the moves leading to it from the solved position.
+		 *`sameAs` is the index of the first task holding the same position up to symmetry,
+		 *which is the task's own index unless it is a duplicate that needn't be searched.*/
+		struct FrontierNode
+		{
+			Board board;
+			std::vector<Position> moves;
+			s_t sameAs;
+		};
+
+
+		/*Table used when the solver was not handed one to share.*/
+		std::unique_ptr<TranspositionTable> ownTable;
+
+
+		/*Results of previously searched positions,
+		 *so that positions reached through different move orders are only searched once.*/
+		TranspositionTable* table;
+
+
+		/*Positions visited by the current search.*/
+		uint64_t nodes;
+
+
+		/*Outcomes the current search is looking for.
+		 *A node stops exploring moves once all of them have been found.*/
+		OutcomeSet wanted;
+
+
+		/*Number of threads solve() uses, and the pool running them, (created on first use).*/
+		s_t numThreads;
+		std::unique_ptr<ThreadPool> pool;
+
+
+		/*Set on solvers searching a single task of a parallel search.
+		 *Once some task with a lower index than `taskIndex` has found every wanted outcome,
+		 *`cutoff` drops below `taskIndex`, and this task's result no longer matters.
+		 *The search then gives up, setting `aborted`, and stops writing to the table,
+		 *since its results are incomplete.*/
+		const std::atomic<s_t>* cutoff;
+		s_t taskIndex;
+		bool aborted;
+
+
+		/*Set while a search with limits runs, (see solveLimited()).
+		 *Every position visited counts `nodesUntilCheck` down, and the limits are checked when it runs out:
+		 *on the first position, then every LIMIT_CHECK_NODES, or as soon as the node budget is used up, if that comes sooner.
+		 *Once one is hit, `stopped` is set, and every position still to be visited is left unexplored and uncounted,
+		 *counting each in `truncations` instead.
+		 *`found` gathers every outcome the search has come across, for reporting progress.*/
+		static constexpr uint64_t LIMIT_CHECK_NODES = 1024;
+		uint64_t nodesUntilCheck;
+		const SolveLimits* limits;
+		const std::atomic<bool>* cancelled;
+		std::chrono::steady_clock::time_point started;
+		std::chrono::steady_clock::time_point deadline;
+		std::chrono::steady_clock::time_point nextProgress;
+		bool stopped;
+		SolveStatus stopReason;
+
+		s_t rootMoves;
+		uint64_t truncations;
+		OutcomeSet found;
+
+
+		/*File the parallel search saves its progress to, every `checkpointInterval` seconds and once it is done,
+		 *and whether it picks up from the file if there is one already, (see setCheckpoint()).*/
+		std::string checkpointPath;
+		double checkpointInterval;
+		bool resume;
+
+
+		/*Recursive step of the search.
+		 *Returns the outcomes reachable from the board's current position.
+		 *The board is left in the same position it was handed in.*/
+		OutcomeSet search(Board& board);
+
+
+		/*Follows moves leading to an X victory from the board's current position,
+		 *which must be known to have one, and returns them.
+		 *Relies on the table's best moves where possible, and searches again where not.
+		 *Under limits, (see solveLimited()), those searches can stop, and then so does the witness, wherever it has got to.*/
+		std::vector<Position> findWitness(Board& board);
+
+
+		/*Fills `moves` with every move the turn player's policy allows,
+		 *and returns how many there are.
+		 *If the turn player can win immediately, only one winning move is returned,
+		 *since every such move leads to the same outcome.*/
+		static uint8_t candidateMoves(const Board& board, Position moves[NUM_SQUARES]);
+
+
+		/*Appends every position `depth` allowed moves below the board to `frontier`, in search order.
+		 *Games which end sooner are appended where they end.
+		 *Returns the number of positions above the frontier which were passed through.*/
+		uint64_t buildFrontier(Board& board, std::vector<Position>& moves, s_t depth, std::vector<FrontierNode>& frontier);
+
+
+		/*solve(), spread across the thread pool.*/
+		SolveResult solveParallel(Board& board);
+
+
+		/*Searches within `limits`, for solveAsync(), on a single thread,
+		 *until every outcome in `target` has been found, the whole tree has been searched, or a limit is hit.*/
+		SolveResult solveLimited(Board& board, OutcomeSet target, const SolveLimits& searchLimits, const std::atomic<bool>& cancel);
+
+
+		/*Checks the limits, and reports progress if it is due.
+		 *Returns true once the search has to stop.*/
+		bool checkLimits(s_t moves);
+
+
+		/*Reports progress, with the search at a position with `moves` tokens.*/
+		void reportProgress(std::chrono::steady_clock::time_point now, s_t moves);
+
+
 	public:
-		Solver();
-		
-		
+		/*Creates a solver with its own transposition table.
+		 *`threads` is the number of threads each search runs on.
+		 *A single thread, (the default), gives the same result and node count every time.
+		 *With more, the reachable outcomes which were asked for are still always the same,
+		 *but the witness line, the node count, and any extra outcomes found along the way can vary.*/
+		explicit Solver(s_t threads = 1);
+
+
+		/*Creates a solver which reads and writes `sharedTable`.
+		 *Several solvers, including ones running on other threads, may share the same table,
+		 *which must outlive all of them.
+		 *Results depend on the seats' policies, so solvers with different ones mustn't share a table.*/
+		explicit Solver(TranspositionTable& sharedTable, s_t threads = 1);
+
+
+		/*Searches every continuation of `board` the seats' policies allow,
+		 *stopping early once every outcome in `target` has been shown to be reachable.
+		 *By default the search stops as soon as an X victory is found.
+		 *Pass ALL_OUTCOMES to get the complete set of reachable outcomes.
+		 *The board is back in its original position when this returns.*/
+		SolveResult solve(Board& board, OutcomeSet target = X_WINS);
+
+
+		/*Starts searching a copy of `board` as a task on `sharedPool`, or on the solver's own pool if none is given,
+		 *and returns straight away, with a handle to wait for the result on, or cancel the search with.
+		 *Several solvers, (eg. one per request, sharing one table), can run their searches on the same pool,
+		 *so no thread is started per search. The search itself runs on a single thread.
+		 *Every outcome the search comes across is reachable, so when it runs out of time or nodes, or is cancelled,
+		 *it still returns every outcome it found by then, and as much of a witness as the limits leave room for, if X can win.
+		 *(Searching one move deeper at a time instead would have to exhaust every position above the first possible win,
+		 *while depth-first lines reach finished games right away.)
+		 *The solver mustn't be used, or destroyed, until the search has finished.*/
+		SolveHandle solveAsync(const Board& board, const SolveLimits& limits, OutcomeSet target = X_WINS,
+			ThreadPool* sharedPool = nullptr);
+
+
+		/*Has solve() save its progress to `path` every `intervalSeconds`, and once more when it finishes:
+		 *which of its tasks have finished, what they found, and the transposition table, (in a file beside it),
+		 *copied out while the threads carry on searching, (see saveCheckpoint()).
+		 *The first save writes the whole table, and later ones only the blocks of it which changed since.
+		 *With `resumeFrom` set, a search finding a checkpoint of the same position, players and target at `path`
+		 *loads it, and only searches the tasks which hadn't finished, giving the same answer as a search from scratch.
+		 *Otherwise any checkpoint already at `path` is deleted when the search starts.
+		 *solve() then always splits the search into tasks, even on a single thread,
+		 *and throws std::runtime_error if the file is a checkpoint of another search, or can't be read or written.
+		 *An empty path turns checkpoints back off. solveAsync() doesn't save any.*/
+		void setCheckpoint(const std::string& path, double intervalSeconds, bool resumeFrom);
 };
 
 
+MTT_INSTANTIATE_SEATS(extern template, Solver, MTT_Board3x5)
+MTT_INSTANTIATE_SEATS(extern template, Solver, MTT_Board4x4)
+MTT_INSTANTIATE_SEATS(extern template, Solver, MTT_Board5x5)
+
+
 #endif
@@ -0,0 +1,217 @@
+#include "tablebase.hpp"
+#include <vector>
+#include <algorithm>
+#include <fstream>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+
+template <class Board>
+Tablebase<Board>::Tablebase(const std::string& path)
+	: file(path)
+{
+	const Header* header = reinterpret_cast<const Header*>(file.data());
+	if (file.size() < sizeof(Header) || std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0
+		|| header->version != VERSION)
+	{
+		throw std::runtime_error("\"" + path + "\" is not a tablebase file, (or was built by an older version).");
+	}
+
+	if (header->rows != Board::Geometry::ROWS || header->columns != Board::Geometry::COLUMNS
+		|| header->numToWin != Board::Geometry::NUM_TO_WIN || header->numPlayers != Board::Geometry::NUM_PLAYERS
+		|| header->entrySize != sizeof(uint32_t) || header->size != Rank::SIZE)
+	{
+		throw std::runtime_error("\"" + path + "\" was built for a different board.");
+	}
+
+	if (file.size() != sizeof(Header) + Rank::SIZE * sizeof(uint32_t))
+	{
+		throw std::runtime_error("\"" + path + "\" is truncated.");
+	}
+
+	entries = reinterpret_cast<const uint32_t*>(file.data() + sizeof(Header));
+}
+
+
+template <class Board>
+bool Tablebase<Board>::lookup(const Board& board, TablebaseEntry& entry) const
+{
+	typename Board::PositionKey key = board.getKey();
+	if (!Rank::isLegal(key))
+	{
+		return false;
+	}
+
+	uint32_t packed = entries[Rank::rank(key)];
+	if (packed == UNREACHABLE)
+	{
+		return false;
+	}
+
+	entry = unpack(packed);
+	return true;
+}
+
+
+template <class Board>
+uint32_t Tablebase<Board>::pack(const TablebaseEntry& entry)
+{
+	uint32_t packed = entry.reachable;
+	for (s_t outcome = 0; outcome < 4; outcome++)
+	{
+		packed |= uint32_t(entry.distance[outcome] & 0x7F) << (4 + 7 * outcome);
+	}
+	return packed;
+}
+
+
+template <class Board>
+TablebaseEntry Tablebase<Board>::unpack(uint32_t packed)
+{
+	TablebaseEntry entry;
+	entry.reachable = packed & 0xF;
+	for (s_t outcome = 0; outcome < 4; outcome++)
+	{
+		entry.distance[outcome] = (packed >> (4 + 7 * outcome)) & 0x7F;
+	}
+	return entry;
+}
+
+
+template <class Board>
+uint64_t Tablebase<Board>::build(const std::string& path, std::ostream* log)
+{
+	if (!BUILDABLE)
+	{
+		throw std::runtime_error("The " + std::to_string(Board::Geometry::ROWS) + "x" + std::to_string(Board::Geometry::COLUMNS)
+			+ " board has " + std::to_string(Rank::SIZE) + " legal positions, too many to build a tablebase of.");
+	}
+
+	//Positions which have been reached, but not solved yet. Never a valid packed entry.
+	const uint32_t PENDING = ~uint32_t(0);
+
+	std::vector<uint32_t> solved(Rank::SIZE, UNREACHABLE);
+	solved[Rank::rank(Board().canonical().key)] = PENDING;
+
+	for (s_t tokens = 0; tokens < NUM_SQUARES; tokens++)
+	{
+		Board board;
+		uint64_t reached = 0;
+
+		for (uint64_t rank = Rank::layerStart(tokens); rank < Rank::layerStart(tokens + 1); rank++)
+		{
+			if (solved[rank] != PENDING)
+			{
+				continue;
+			}
+
+			board.setKey(Rank::unrank(rank));
+			if (board.isOver())
+			{
+				continue;
+			}
+
+			typename Board::Bitboard empty = board.emptySquares();
+			while (empty)
+			{
+				Position move = Board::squarePosition(lowestBit(empty));
+				board.makeMove(move.row, move.col);
+				uint32_t& childEntry = solved[Rank::rank(board.canonical().key)];
+				reached += (childEntry != PENDING);
+				childEntry = PENDING;
+				board.undoLastMove();
+				empty &= empty - 1;
+			}
+		}
+
+		if (log)
+		{
+			*log << "Reached " << reached << " positions with " << (tokens + 1) << " tokens.\n";
+		}
+	}
+
+	//Solve from the full board back to the empty one.
+	uint64_t numReachable = 0;
+	for (s_t tokens = NUM_SQUARES + 1; tokens-- > 0;)
+	{
+		Board board;
+
+		for (uint64_t rank = Rank::layerStart(tokens); rank < Rank::layerStart(tokens + 1); rank++)
+		{
+			if (solved[rank] != PENDING)
+			{
+				continue;
+			}
+
+			board.setKey(Rank::unrank(rank));
+			TablebaseEntry entry {0, {0, 0, 0, 0}};
+
+			if (board.isOver())
+			{
+				entry.reachable = outcomeOf(board.getWinner());
+			}
+
+			typename Board::Bitboard allowed = board.isOver() ? 0 : board.semiCompetentMoves();
+			while (allowed)
+			{
+				Position move = Board::squarePosition(lowestBit(allowed));
+				board.makeMove(move.row, move.col);
+				allowed &= allowed - 1;
+
+				TablebaseEntry childEntry = unpack(solved[Rank::rank(board.getKey())]);
+				board.undoLastMove();
+				for (s_t outcome = 0; outcome < 4; outcome++)
+				{
+					if (!(childEntry.reachable & (1 << outcome)))
+					{
+						continue;
+					}
+					if (!(entry.reachable & (1 << outcome)) || childEntry.distance[outcome] + 1 < entry.distance[outcome])
+					{
+						entry.distance[outcome] = childEntry.distance[outcome] + 1;
+					}
+				}
+				entry.reachable |= childEntry.reachable;
+			}
+
+			//Symmetric copies which are the same position just get written more than once.
+			for (uint8_t symmetry = 0; symmetry < Board::NUM_SYMMETRIES; symmetry++)
+			{
+				uint32_t& copy = solved[Rank::rank(board.getKey(static_cast<Symmetry>(symmetry)))];
+				numReachable += (copy != pack(entry));
+				copy = pack(entry);
+			}
+		}
+
+		if (log)
+		{
+			*log << "Solved positions with " << tokens << " tokens.\n";
+		}
+	}
+
+	Header header {};
+	std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+	header.version = VERSION;
+	header.rows = Board::Geometry::ROWS;
+	header.columns = Board::Geometry::COLUMNS;
+	header.numToWin = Board::Geometry::NUM_TO_WIN;
+	header.numPlayers = Board::Geometry::NUM_PLAYERS;
+	header.entrySize = sizeof(uint32_t);
+	header.size = Rank::SIZE;
+
+	std::ofstream output(path, std::ios::binary);
+	output.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+	output.write(reinterpret_cast<const char*>(solved.data()), solved.size() * sizeof(uint32_t));
+
+	if (!output)
+	{
+		throw std::runtime_error("Could not write \"" + path + "\".");
+	}
+	return numReachable;
+}
+
+
+template class Tablebase<MTT_Board3x5>;
+template class Tablebase<MTT_Board4x4>;
+template class Tablebase<MTT_Board5x5>;
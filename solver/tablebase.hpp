@@ -0,0 +1,118 @@
+#ifndef TABLEBASE_HPP
+#define TABLEBASE_HPP
+
+#include "mtt_board.hpp"
+#include "mapped_file.hpp"
+#include "position_rank.hpp"
+#include "outcome.hpp"
+#include <string>
+#include <ostream>
+#include <bit>
+#include <cstdint>
+
+
+/*What the tablebase knows about a single position.*/
+struct TablebaseEntry
+{
+	/*Every outcome some sequence of semi-competent moves can reach from the position.
+	 *Unlike a search result, this is always complete.*/
+	OutcomeSet reachable;
+
+	/*Fewest moves needed to reach each outcome, indexed in the order X, O, Y, draw,
+	 *(the same order as the Outcome flags). Zero for the outcome of a finished game.
+	 *Only meaningful for outcomes in `reachable`.*/
+	uint8_t distance[4];
+
+	uint8_t distanceTo(Outcome outcome) const { return distance[std::countr_zero(unsigned(outcome))]; }
+};
+
+
+/*The answer for every position which can come up in a real game on one board variant,
+ *computed ahead of time and stored in a file, so a query is a lookup rather than a search.
+ *
+ *The file holds one entry for every legal position, in PositionRank order,
+ *so a position's entry sits at its rank, and positions which can't be reached in a real game are left blank.
+ *
+ *Building the table starts by marking every position reachable through any sequence of legal moves,
+ *(one copy out of each set of symmetric copies), one layer of token counts at a time.
+ *It then solves the layers backwards, starting from the full board:
+ *every move out of a position leads into the next layer, which has already been solved,
+ *so each position only has to combine the entries of the positions its semi-competent moves lead to.
+ *The result is then copied to every symmetric copy of the position.
+ *Only small boards are practical; the 3x5 board has about 72 million legal positions.*/
+template <class Board>
+class Tablebase
+{
+	private:
+		typedef PositionRank<typename Board::Geometry> Rank;
+		static constexpr uint8_t NUM_SQUARES = Board::NUM_SQUARES;
+		static_assert(NUM_SQUARES < 128, "Distances are stored in 7 bits.");
+
+
+		/*Start of every tablebase file, followed by `size` packed entries.*/
+		struct Header
+		{
+			char magic[4];
+			uint32_t version;
+			uint8_t rows;
+			uint8_t columns;
+			uint8_t numToWin;
+			uint8_t numPlayers;
+			uint32_t entrySize;
+			uint64_t size;
+		};
+
+		static constexpr char MAGIC[4] = {'M', 'T', 'T', 'B'};
+		static constexpr uint32_t VERSION = 2;
+
+
+		/*Marks a blank entry, for a position which can't be reached.*/
+		static constexpr uint32_t UNREACHABLE = 0;
+
+
+		MappedFile file;
+		const uint32_t* entries;
+
+
+		/*Entries are packed into 32 bits: `reachable` in the lowest 4,
+		 *then 7 bits for each distance, in the same order as the distances themselves.
+		 *Every reachable position can reach some outcome, so a packed entry is never UNREACHABLE.*/
+		static uint32_t pack(const TablebaseEntry& entry);
+		static TablebaseEntry unpack(uint32_t packed);
+
+
+	public:
+		/*Opens the tablebase file at `path`.
+		 *Throws std::runtime_error if it can't be read, or wasn't built for this board variant.*/
+		explicit Tablebase(const std::string& path);
+
+
+		/*Looks up the board's current position.
+		 *Returns true and fills `entry` iff the position is in the table,
+		 *which it is iff it can be reached in a real game.*/
+		bool lookup(const Board& board, TablebaseEntry& entry) const;
+
+
+		/*Number of entries in the file, (one per legal position, reachable or not).*/
+		uint64_t size() const { return Rank::SIZE; }
+
+
+		/*Whether build() can make the tablebase for this board variant.
+		 *It keeps an entry for every legal position in memory, so it only takes variants with up to 2^32 of them, (16GB).
+		 *That rules out 5x5, which has about 47 trillion.*/
+		static constexpr bool BUILDABLE = Rank::SIZE <= (uint64_t(1) << 32);
+
+
+		/*Builds the tablebase for this board variant, writes it to `path`, and returns how many reachable positions it holds.
+		 *Progress is written to `log` if one is given.
+		 *Throws std::runtime_error if the variant isn't BUILDABLE, or the file can't be written.*/
+		static uint64_t build(const std::string& path, std::ostream* log = nullptr);
+};
+
+
+extern template class Tablebase<MTT_Board3x5>;
+extern template class Tablebase<MTT_Board4x4>;
+extern template class Tablebase<MTT_Board5x5>;
+
+
+#endif
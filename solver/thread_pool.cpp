@@ -0,0 +1,137 @@
+#include "thread_pool.hpp"
+#include <algorithm>
+
+
+namespace
+{
+	//The pool, (if any), that the current thread works for, and its index in that pool.
+	thread_local const ThreadPool* currentPool = nullptr;
+	thread_local std::size_t currentIndex = 0;
+}
+
+
+ThreadPool::ThreadPool(std::size_t numThreads)
+{
+	queued = 0;
+	unfinished = 0;
+	nextWorker = 0;
+	stopping = false;
+
+	numThreads = std::max<std::size_t>(numThreads, 1);
+	for (std::size_t index = 0; index < numThreads; index++)
+	{
+		workers.push_back(std::make_unique<Worker>());
+	}
+
+	//Workers are only started once every queue exists, since any of them may be stolen from.
+	for (std::size_t index = 0; index < numThreads; index++)
+	{
+		workers[index]->thread = std::thread(&ThreadPool::workerLoop, this, index);
+	}
+}
+
+
+ThreadPool::~ThreadPool()
+{
+	wait();
+
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		stopping = true;
+	}
+	wakeUp.notify_all();
+
+	for (auto& worker : workers)
+	{
+		worker->thread.join();
+	}
+}
+
+
+void ThreadPool::submit(std::function<void()> task)
+{
+	std::size_t index = (currentPool == this) ? currentIndex
+		: nextWorker.fetch_add(1, std::memory_order_relaxed) % workers.size();
+
+	/*Counted before it is queued, so the count never dips below zero when a worker grabs it straight away.
+	 *Taking the sleep lock makes sure a worker about to go to sleep sees the new count.*/
+	unfinished.fetch_add(1);
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		queued.fetch_add(1);
+	}
+	{
+		std::lock_guard<std::mutex> lock(workers[index]->mutex);
+		workers[index]->tasks.push_back(std::move(task));
+	}
+	wakeUp.notify_one();
+}
+
+
+void ThreadPool::wait()
+{
+	std::unique_lock<std::mutex> lock(sleepMutex);
+	allFinished.wait(lock, [this]() { return unfinished.load() == 0; });
+}
+
+
+bool ThreadPool::takeTask(std::size_t index, std::function<void()>& task)
+{
+	//Newest first from our own queue, since it is the most likely to still be in cache.
+	{
+		Worker& own = *workers[index];
+		std::lock_guard<std::mutex> lock(own.mutex);
+		if (!own.tasks.empty())
+		{
+			task = std::move(own.tasks.back());
+			own.tasks.pop_back();
+			return true;
+		}
+	}
+
+	//Oldest first from everyone else's, since older tasks tend to be bigger.
+	for (std::size_t offset = 1; offset < workers.size(); offset++)
+	{
+		Worker& victim = *workers[(index + offset) % workers.size()];
+		std::lock_guard<std::mutex> lock(victim.mutex);
+		if (!victim.tasks.empty())
+		{
+			task = std::move(victim.tasks.front());
+			victim.tasks.pop_front();
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+void ThreadPool::workerLoop(std::size_t index)
+{
+	currentPool = this;
+	currentIndex = index;
+
+	while (true)
+	{
+		std::function<void()> task;
+		if (takeTask(index, task))
+		{
+			queued.fetch_sub(1);
+			task();
+
+			if (unfinished.fetch_sub(1) == 1)
+			{
+				std::lock_guard<std::mutex> lock(sleepMutex);
+				allFinished.notify_all();
+			}
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(sleepMutex);
+		wakeUp.wait(lock, [this]() { return stopping || queued.load() > 0; });
+		if (stopping && queued.load() == 0)
+		{
+			return;
+		}
+	}
+}
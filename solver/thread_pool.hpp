@@ -0,0 +1,86 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <memory>
+#include <cstddef>
+
+
+/*Fixed set of worker threads which run submitted tasks.
+ *Every worker has its own queue of tasks. Tasks submitted from a worker go onto that worker's queue,
+ *and tasks submitted from anywhere else are dealt out between the queues in turn.
+ *A worker runs the newest task on its own queue first,
+ *and when its queue is empty, steals the oldest task from another worker's queue,
+ *so that uneven tasks still keep every thread busy.*/
+class ThreadPool
+{
+	private:
+		struct Worker
+		{
+			std::mutex mutex;
+			std::deque<std::function<void()>> tasks;
+			std::thread thread;
+		};
+
+
+		std::vector<std::unique_ptr<Worker>> workers;
+
+
+		/*Tasks sitting in a queue, and tasks which have been submitted but not finished.*/
+		std::atomic<std::size_t> queued;
+		std::atomic<std::size_t> unfinished;
+
+
+		/*Queue which the next task submitted from outside the pool goes onto.*/
+		std::atomic<std::size_t> nextWorker;
+
+
+		/*Idle workers and wait() sleep on these.*/
+		std::mutex sleepMutex;
+		std::condition_variable wakeUp;
+		std::condition_variable allFinished;
+		bool stopping;
+
+
+		void workerLoop(std::size_t index);
+
+
+		/*Takes a task from the given worker's own queue, or failing that, steals one from another queue.
+		 *Returns false if every queue is empty.*/
+		bool takeTask(std::size_t index, std::function<void()>& task);
+
+
+	public:
+		/*Starts `numThreads` workers, (one per hardware thread by default).*/
+		explicit ThreadPool(std::size_t numThreads = std::thread::hardware_concurrency());
+
+
+		/*Finishes every submitted task, then stops the workers.*/
+		~ThreadPool();
+
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+
+		/*Queues a task to run on one of the workers.
+		 *Safe to call from any thread, including from inside a running task.*/
+		void submit(std::function<void()> task);
+
+
+		/*Blocks until every submitted task has finished.
+		 *Must not be called from inside a task.*/
+		void wait();
+
+
+		std::size_t size() const { return workers.size(); }
+};
+
+
+#endif
@@ -0,0 +1,222 @@
+#include "transposition_table.hpp"
+#include "search_stats.hpp"
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+
+
+TranspositionTable::TranspositionTable(std::size_t megabytes, ReplacementPolicy policy)
+{
+	//Find the largest power of two number of buckets which fits in the budget, (at least one).
+	std::size_t budget = megabytes * 1024 * 1024 / sizeof(Bucket);
+	std::size_t numBuckets = 1;
+	while (numBuckets * 2 <= budget)
+	{
+		numBuckets *= 2;
+	}
+
+	buckets = std::make_unique<Bucket[]>(numBuckets);
+	bucketMask = numBuckets - 1;
+	this->policy = policy;
+	clear();
+}
+
+
+bool TranspositionTable::probe(uint64_t key, TTEntry& entry) const
+{
+	Bucket& bucket = bucketFor(key);
+	MTT_COUNT(STAT_TT_PROBES);
+
+	for (Slot& slot : bucket.slots)
+	{
+		uint64_t data = slot.data.load(std::memory_order_relaxed);
+		uint64_t check = slot.check.load(std::memory_order_relaxed);
+
+		if (data != 0 && (check ^ data) == key)
+		{
+			entry = unpack(data);
+			MTT_COUNT(STAT_TT_HITS);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+void TranspositionTable::store(uint64_t key, const TTEntry& entry)
+{
+	Bucket& bucket = bucketFor(key);
+	Slot* victim = nullptr;
+	Slot* shallowest = nullptr;
+	uint8_t shallowestDepth = UINT8_MAX;
+
+	//Prefer overwriting the same position, then an empty slot.
+	for (Slot& slot : bucket.slots)
+	{
+		uint64_t data = slot.data.load(std::memory_order_relaxed);
+		uint64_t check = slot.check.load(std::memory_order_relaxed);
+
+		if (data == 0 || (check ^ data) == key)
+		{
+			victim = &slot;
+			break;
+		}
+
+		uint8_t depth = unpack(data).depth;
+		if (depth < shallowestDepth)
+		{
+			shallowestDepth = depth;
+			shallowest = &slot;
+		}
+	}
+
+	//The bucket is full of other positions, so let the replacement policy pick one.
+	if (victim == nullptr)
+	{
+		MTT_COUNT(STAT_TT_COLLISIONS);
+		switch (policy)
+		{
+			case ReplacementPolicy::ALWAYS:
+				//Use the top bits of the key, since the bottom bits already picked the bucket.
+				victim = &bucket.slots[key >> 62];
+				break;
+
+			case ReplacementPolicy::DEPTH_PREFERRED:
+				//Keep the bucket as it is if everything in it cost more to find than the new entry.
+				if (shallowestDepth > entry.depth)
+				{
+					return;
+				}
+				victim = shallowest;
+				break;
+		}
+	}
+
+	uint64_t data = pack(entry);
+	MTT_COUNT(STAT_TT_STORES);
+	victim->check.store(key ^ data, std::memory_order_relaxed);
+	victim->data.store(data, std::memory_order_relaxed);
+
+	if (changedBlocks)
+	{
+		changedBlocks[(key & bucketMask) * SLOTS_PER_BUCKET / BLOCK_SLOTS].changed.store(true, std::memory_order_release);
+	}
+}
+
+
+void TranspositionTable::clear()
+{
+	for (uint64_t index = 0; index <= bucketMask; index++)
+	{
+		for (Slot& slot : buckets[index].slots)
+		{
+			slot.check.store(0, std::memory_order_relaxed);
+			slot.data.store(0, std::memory_order_relaxed);
+		}
+	}
+}
+
+
+void TranspositionTable::trackChanges(bool track)
+{
+	changedBlocks.reset(track ? new BlockFlag[numBlocks()] : nullptr);
+	for (std::size_t block = 0; track && block < numBlocks(); block++)
+	{
+		changedBlocks[block].changed.store(false, std::memory_order_relaxed);
+	}
+}
+
+
+uint64_t TranspositionTable::saveChanges(std::ostream& output, bool everything)
+{
+	std::streamoff start = output.tellp();
+	uint64_t numSlots = capacity();
+	output.write(reinterpret_cast<const char*>(&numSlots), sizeof(numSlots));
+
+	uint64_t written = 0;
+	std::vector<uint64_t> block;
+	block.reserve(2 * BLOCK_SLOTS);
+	for (std::size_t index = 0; index < numBlocks(); index++)
+	{
+		//Clear the flag before copying, so any store from here on marks the block for the next save.
+		bool changed = !changedBlocks || changedBlocks[index].changed.exchange(false, std::memory_order_acquire);
+		if (!changed && !everything)
+		{
+			continue;
+		}
+
+		uint64_t first = index * BLOCK_SLOTS;
+		uint64_t count = std::min<uint64_t>(BLOCK_SLOTS, numSlots - first);
+		for (uint64_t slot = first; slot < first + count; slot++)
+		{
+			const Slot& copied = buckets[slot / SLOTS_PER_BUCKET].slots[slot % SLOTS_PER_BUCKET];
+			block.push_back(copied.check.load(std::memory_order_relaxed));
+			block.push_back(copied.data.load(std::memory_order_relaxed));
+		}
+
+		output.seekp(start + std::streamoff(sizeof(numSlots) + 2 * first * sizeof(uint64_t)));
+		output.write(reinterpret_cast<const char*>(block.data()), block.size() * sizeof(uint64_t));
+		block.clear();
+		written++;
+	}
+
+	return written;
+}
+
+
+void TranspositionTable::load(std::istream& input)
+{
+	uint64_t numSlots = 0;
+	input.read(reinterpret_cast<char*>(&numSlots), sizeof(numSlots));
+
+	//A table of the same size takes every slot back where it was, and any other re-stores each entry by its key.
+	bool sameSize = (numSlots == capacity());
+	std::vector<uint64_t> block(2 * BLOCK_SLOTS);
+	for (uint64_t first = 0; input && first < numSlots; first += BLOCK_SLOTS)
+	{
+		uint64_t count = std::min<uint64_t>(BLOCK_SLOTS, numSlots - first);
+		input.read(reinterpret_cast<char*>(block.data()), 2 * count * sizeof(uint64_t));
+
+		for (uint64_t index = 0; input && index < count; index++)
+		{
+			uint64_t check = block[2 * index];
+			uint64_t data = block[2 * index + 1];
+			if (sameSize)
+			{
+				Slot& slot = buckets[(first + index) / SLOTS_PER_BUCKET].slots[(first + index) % SLOTS_PER_BUCKET];
+				slot.check.store(check, std::memory_order_relaxed);
+				slot.data.store(data, std::memory_order_relaxed);
+			}
+			else if (data != 0)
+			{
+				store(check ^ data, unpack(data));
+			}
+		}
+	}
+
+	if (!input)
+	{
+		throw std::runtime_error("The transposition table is cut short.");
+	}
+}
+
+
+uint64_t TranspositionTable::pack(const TTEntry& entry)
+{
+	return uint64_t(entry.reachable)
+		| (uint64_t(entry.known) << 8)
+		| (uint64_t(entry.bestMove) << 16)
+		| (uint64_t(entry.depth) << 24);
+}
+
+
+TTEntry TranspositionTable::unpack(uint64_t data)
+{
+	TTEntry entry;
+	entry.reachable = data & 0xFF;
+	entry.known = (data >> 8) & 0xFF;
+	entry.bestMove = (data >> 16) & 0xFF;
+	entry.depth = (data >> 24) & 0xFF;
+	return entry;
+}
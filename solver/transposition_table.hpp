@@ -0,0 +1,142 @@
+#ifndef TRANSPOSITION_TABLE_HPP
+#define TRANSPOSITION_TABLE_HPP
+
+#include "outcome.hpp"
+#include <atomic>
+#include <memory>
+#include <istream>
+#include <ostream>
+#include <cstdint>
+
+
+/*What the table remembers about a single searched position.*/
+struct TTEntry
+{
+	/*Outcomes shown to be reachable from the position.*/
+	OutcomeSet reachable;
+
+	/*Outcomes whose reachability is known for certain.
+	 *Every outcome in `reachable` is known. If the search of the position was exhaustive,
+	 *then every outcome is known, and anything missing from `reachable` is unreachable.*/
+	OutcomeSet known;
+
+	/*Square index, (row * COLUMNS + col), of the first move found leading to an X victory,
+	 *or NO_MOVE if there is none.
+	 *The solver stores it as played on the canonical symmetric copy of the position.*/
+	uint8_t bestMove;
+
+	/*Number of empty squares left in the position.
+	 *Positions with more empty squares took more work to search, and are worth keeping.*/
+	uint8_t depth;
+};
+
+const uint8_t NO_MOVE = 0xFF;
+
+
+/*Decides which entry of a full bucket gets overwritten by a new position.*/
+enum class ReplacementPolicy
+{
+	ALWAYS,				//Overwrite a slot picked by the new key, regardless of what it holds.
+	DEPTH_PREFERRED		//Overwrite the slot holding the least expensive search.
+};
+
+
+/*Fixed-size hash table of search results, keyed on 64-bit Zobrist hashes.
+ *The table is safe to share between threads without any locking:
+ *each slot stores the key XORed with its data, so a slot torn by two threads
+ *writing at once simply fails its key check on the next probe and reads as a miss.
+ *Slots are grouped into buckets the size of a cache line,
+ *so a probe never touches more than one line of memory.*/
+class TranspositionTable
+{
+	private:
+		struct Slot
+		{
+			std::atomic<uint64_t> check;	//key XOR data.
+			std::atomic<uint64_t> data;		//Packed TTEntry. Zero means the slot is empty.
+		};
+
+		static const std::size_t SLOTS_PER_BUCKET = 4;
+
+		struct alignas(64) Bucket
+		{
+			Slot slots[SLOTS_PER_BUCKET];
+		};
+
+
+		std::unique_ptr<Bucket[]> buckets;
+		uint64_t bucketMask;
+		ReplacementPolicy policy;
+
+
+		/*While changes are tracked, one flag per block of BLOCK_SLOTS slots, set by store() after writing to the block,
+		 *and cleared by saveChanges() before copying it, so a store racing with a save is always picked up by the next one.
+		 *Each flag has a cache line to itself, so that threads storing into different blocks don't contend.*/
+		static const std::size_t BLOCK_SLOTS = 1 << 16;
+
+		struct alignas(64) BlockFlag
+		{
+			std::atomic<bool> changed;
+		};
+
+		std::unique_ptr<BlockFlag[]> changedBlocks;
+		std::size_t numBlocks() const { return (capacity() + BLOCK_SLOTS - 1) / BLOCK_SLOTS; }
+
+
+		static uint64_t pack(const TTEntry& entry);
+		static TTEntry unpack(uint64_t data);
+
+		Bucket& bucketFor(uint64_t key) const { return buckets[key & bucketMask]; }
+
+
+	public:
+		/*Creates an empty table using at most `megabytes` of memory,
+		 *rounded down to a power of two number of buckets.*/
+		explicit TranspositionTable(std::size_t megabytes = 64,
+			ReplacementPolicy policy = ReplacementPolicy::DEPTH_PREFERRED);
+
+
+		/*Looks up the position with the given hash.
+		 *Returns true and fills `entry` iff it was found.*/
+		bool probe(uint64_t key, TTEntry& entry) const;
+
+
+		/*Records a search result for the position with the given hash,
+		 *overwriting an older entry for the same position if there is one.*/
+		void store(uint64_t key, const TTEntry& entry);
+
+
+		/*Empties every slot. Not safe to call while other threads are using the table.*/
+		void clear();
+
+
+		/*Starts keeping track of which blocks of slots store() changes, with every block unchanged for now,
+		 *or with `track` false, stops, (which saves store() the bookkeeping).
+		 *Not safe to call while other threads are using the table.*/
+		void trackChanges(bool track);
+
+
+		/*Writes the table to `output`, starting from where it is positioned: the number of slots,
+		 *then each slot's check and data words, in bucket order, a block at a time.
+		 *With `everything` false, only the blocks changed since trackChanges() or the last save are written,
+		 *each over its own place in a copy of the table written earlier, (so `output` has to be seekable).
+		 *Without tracking, every block is written.
+		 *Safe to call while other threads are using the table: each half of a slot is copied atomically,
+		 *and a slot torn by a store in between just reads back as a miss.
+		 *Returns the number of blocks written.*/
+		uint64_t saveChanges(std::ostream& output, bool everything);
+
+
+		/*Reads slots written by saveChanges() into the table, on top of whatever it holds.
+		 *A table of a different size stores the entries one at a time, so some of them may not fit.
+		 *Not safe to call while other threads are using the table.
+		 *Throws std::runtime_error if the input is cut short.*/
+		void load(std::istream& input);
+
+
+		/*Total number of entries the table can hold.*/
+		std::size_t capacity() const { return (bucketMask + 1) * SLOTS_PER_BUCKET; }
+};
+
+
+#endif
@@ -0,0 +1,93 @@
+#ifndef XOSHIRO_HPP
+#define XOSHIRO_HPP
+
+#include <cstdint>
+
+
+/*xoshiro256**, a small and very fast pseudorandom number generator by David Blackman and Sebastiano Vigna.
+ *Good enough for statistics, but not for anything that needs to be unpredictable.
+ *Each jump() moves the generator 2^128 numbers ahead,
+ *so generators seeded the same and then jumped different numbers of times never overlap,
+ *which gives every thread its own independent stream.*/
+class Xoshiro256
+{
+	private:
+		uint64_t state[4];
+
+
+		static uint64_t rotateLeft(uint64_t word, int bits)
+		{
+			return (word << bits) | (word >> (64 - bits));
+		}
+
+
+	public:
+		/*Fills the state from `seed` with SplitMix64, as the authors recommend,
+		 *so that similar seeds still give unrelated streams.*/
+		explicit Xoshiro256(uint64_t seed = 0)
+		{
+			for (uint64_t& word : state)
+			{
+				seed += 0x9E3779B97F4A7C15;
+				uint64_t mixed = seed;
+				mixed = (mixed ^ (mixed >> 30)) * 0xBF58476D1CE4E5B9;
+				mixed = (mixed ^ (mixed >> 27)) * 0x94D049BB133111EB;
+				word = mixed ^ (mixed >> 31);
+			}
+		}
+
+
+		uint64_t next()
+		{
+			uint64_t result = rotateLeft(state[1] * 5, 7) * 9;
+			uint64_t shifted = state[1] << 17;
+
+			state[2] ^= state[0];
+			state[3] ^= state[1];
+			state[1] ^= state[2];
+			state[0] ^= state[3];
+			state[2] ^= shifted;
+			state[3] = rotateLeft(state[3], 45);
+
+			return result;
+		}
+
+
+		/*Returns a random number below `bound`, using a multiply and shift instead of a division.
+		 *The bias this leaves is around bound / 2^32, far too small to matter for board-sized bounds.*/
+		uint32_t below(uint32_t bound)
+		{
+			return uint32_t(((next() >> 32) * bound) >> 32);
+		}
+
+
+		/*Advances the generator by 2^128 numbers.*/
+		void jump()
+		{
+			const uint64_t JUMP[] = {0x180EC6D33CFD0ABA, 0xD5A61266F0C9392C, 0xA9582618E03FC9AA, 0x39ABDC4529B1661C};
+
+			uint64_t jumped[4] = {0, 0, 0, 0};
+			for (uint64_t word : JUMP)
+			{
+				for (int bit = 0; bit < 64; bit++)
+				{
+					if (word & (uint64_t(1) << bit))
+					{
+						for (int index = 0; index < 4; index++)
+						{
+							jumped[index] ^= state[index];
+						}
+					}
+					next();
+				}
+			}
+
+			for (int index = 0; index < 4; index++)
+			{
+				state[index] = jumped[index];
+			}
+		}
+};
+
+
+#endif
@@ -1,5 +1,8 @@
 #include <iostream>
+#include <random>
 #include "mtt_board.hpp"
+#include "mtt_board_batch.hpp"
+#include "census.hpp"
 
 void printMenu();
 
@@ -8,7 +11,10 @@ void testCustomPosition();
 void testMoves();
 void testUndo();
 void testGameOver();
-void userFinishesGame(MTT_Board& board);
+void testThreats();
+void testCensus();
+void testBatch();
+void userFinishesGame(MTT_Board3x5& board);
 
 
 int main(int argc, char** argv)
@@ -43,6 +49,18 @@ int main(int argc, char** argv)
 				testUndo();
 				break;
 
+			case 'T':
+				testThreats();
+				break;
+
+			case 'S':
+				testCensus();
+				break;
+
+			case 'K':
+				testBatch();
+				break;
+
 			case 'Q':
 				std::cout << "Goodbye.\n";
 				break;
@@ -62,6 +80,9 @@ void printMenu()
 	std::cout << "C: Ensure moves are played correctly.\n";
 	std::cout << "D: Ensure endgames are handled correctly.\n";
 	std::cout << "U: Ensure moves are undone correctly.\n";
+	std::cout << "T: Ensure winning squares are tracked correctly.\n";
+	std::cout << "S: Ensure the position census counts positions correctly.\n";
+	std::cout << "K: Ensure the batch kernels agree with the board.\n";
 	std::cout << "Q: Quit.\n";
 }
 
@@ -69,7 +90,7 @@ void printMenu()
 //Simply run the blank constructor and ensure everything is set up correctly.
 void testEmptyBoard()
 {
-	MTT_Board board = MTT_Board();
+	MTT_Board3x5 board = MTT_Board3x5();
 
 	//Check board and turn player.
 	std::cout << "Board position after initialization: " << board.getBoardPosition() << std::endl;
@@ -86,11 +107,11 @@ void testEmptyBoard()
 
 void testCustomPosition()
 {
-	MTT_Board board;
+	MTT_Board3x5 board;
 	std::string testPosition;
 
 	testPosition = "X4/5/5 O";
-	board = MTT_Board(testPosition);
+	board = MTT_Board3x5(testPosition);
 
 	std::cout << (board.getBoardPosition() == testPosition
 			? "Position set correctly." : "Something went wrong.") << std::endl;
@@ -99,7 +120,7 @@ void testCustomPosition()
 
 void testMoves()
 {
-	MTT_Board board = MTT_Board();
+	MTT_Board3x5 board = MTT_Board3x5();
 
 	std::cout << "Placing 'X' in top-left corner...";
 	std::cout << (board.makeMove(0, 0) ? "Done.\n" : "Something went wrong.\n");
@@ -136,7 +157,7 @@ void testMoves()
  *Test after each move to make sure it does end in a draw.*/
 void testGameOver()
 {
-	MTT_Board board = MTT_Board();
+	MTT_Board3x5 board = MTT_Board3x5();
 
 	auto isWon = [&board](s_t row, s_t col)
 	{
@@ -225,7 +246,7 @@ void testUndo()
 
 	std::cout << "Undoing a single move...\n";
 
-	auto board = MTT_Board();
+	auto board = MTT_Board3x5();
 	board.makeMove(0, 0);
 	board.undoMove(0, 0);
 
@@ -235,7 +256,7 @@ void testUndo()
 
 	std::cout << "Undoing a winning move...\n";
 
-	board = MTT_Board("XOY2/XOY2/5 X");
+	board = MTT_Board3x5("XOY2/XOY2/5 X");
 	board.makeMove(2, 0);
 	board.undoMove(2, 0);
 
@@ -243,4 +264,212 @@ void testUndo()
 	std::cout << "Position is:        " << board.getBoardPosition() << "\n";
 	std::cout << "numberOfMoves should be 6 and is " << board.getNumMoves() << "\n";
 	std::cout << "gameOver should be false and is " << board.isOver() << "\n\n";
+
+	std::cout << "Undoing several moves with undoLastMove()...\n";
+
+	board = MTT_Board3x5("XOY2/XOY2/5 X");
+	board.makeMove(0, 3);
+	board.makeMove(1, 3);
+	board.makeMove(2, 1);
+	board.undoLastMove();
+	board.undoLastMove();
+	board.undoLastMove();
+
+	std::cout << "Position should be: XOY2/XOY2/5 X\n";
+	std::cout << "Position is:        " << board.getBoardPosition() << "\n";
+	std::cout << "X's winning squares should be 1024, (just (2, 0)), and are " << int(board.winningSquares(X)) << "\n";
+	std::cout << "A fourth undo should fail, and " << (board.undoLastMove() ? "succeeded" : "failed") << "\n\n";
+
+	std::cout << "Undoing a token which isn't part of the winning line...\n";
+
+	board = MTT_Board3x5("XXX2/OO1OY/Y1Y1X O");
+	board.undoMove(2, 4);
+
+	std::cout << "Position should be: XXX2/OO1OY/Y1Y2 X\n";
+	std::cout << "Position is:        " << board.getBoardPosition() << "\n";
+	std::cout << "X should still have won, and the winner is " << char(board.getWinner()) << "\n\n";
+
+	std::cout << "Undoing a move from a position where it isn't the usual player's turn...\n";
+
+	board = MTT_Board3x5("5/5/5 O");
+	uint64_t hash = board.getHash();
+	board.makeMove(0, 0);
+	board.undoLastMove();
+
+	std::cout << "Position should be: 5/5/5 O\n";
+	std::cout << "Position is:        " << board.getBoardPosition() << "\n";
+	std::cout << "The hash should be back to " << hash << ", and is " << board.getHash() << "\n";
+
+	board.makeMove(0, 0);
+	std::cout << "Undoing (0, 1), which is empty, should fail, and " << (board.undoMove(0, 1) ? "succeeded" : "failed") << "\n";
+	board.undoMove(0, 0);
+	std::cout << "Undoing (0, 0) with undoMove() should give 5/5/5 O, and gives " << board.getBoardPosition() << "\n\n";
+}
+
+
+void testThreats()
+{
+	//Prints every square set in a bitboard.
+	auto printSquares = [](MTT_Board3x5::Bitboard squares)
+	{
+		for (s_t square = 0; square < MTT_Board3x5::NUM_SQUARES; square++)
+		{
+			if (squares & (MTT_Board3x5::Bitboard(1) << square))
+			{
+				Position position = MTT_Board3x5::squarePosition(square);
+				std::cout << " (" << int(position.row) << ", " << int(position.col) << ")";
+			}
+		}
+		std::cout << "\n";
+	};
+
+	MTT_Board3x5 board = MTT_Board3x5("XX3/OO3/Y4 Y");
+
+	std::cout << "Winning squares for X should be: (0, 2)\n";
+	std::cout << "Winning squares for X are:      ";
+	printSquares(board.winningSquares(X));
+
+	std::cout << "Winning squares for O should be: (1, 2)\n";
+	std::cout << "Winning squares for O are:      ";
+	printSquares(board.winningSquares(O));
+
+	std::cout << "Y can't win, so Y's forced moves should be X's winning squares: (0, 2)\n";
+	std::cout << "Y's forced moves are:                                          ";
+	printSquares(board.forcedMoves());
+
+	std::cout << "Blocking X at (0, 2)...\n";
+	board.makeMove(0, 2);
+	std::cout << "Winning squares for X should be empty, and are:";
+	printSquares(board.winningSquares(X));
+
+	std::cout << "Undoing the block...\n";
+	board.undoMove(0, 2);
+	std::cout << "Winning squares for X should be (0, 2) again, and are:";
+	printSquares(board.winningSquares(X));
+	std::cout << std::endl;
+}
+
+
+/*Counts the first few layers from the empty board, which every symmetry leaves as it is,
+ *and from a corner opening, which no symmetry but the identity leaves as it is.
+ *Until someone has 3 tokens, no game can have ended, so every way of placing the tokens is a position.*/
+void testCensus()
+{
+	PositionCensus<MTT_Board3x5> census(16, std::filesystem::temp_directory_path());
+
+	std::vector<CensusLayer> layers = census.run(MTT_Board3x5());
+	std::cout << "Positions from 5/5/5 X should be:  1 15 210 2730\n";
+	std::cout << "Positions from 5/5/5 X are:        ";
+	for (s_t tokens = 0; tokens < 4; tokens++)
+	{
+		std::cout << " " << layers[tokens].positions;
+	}
+	std::cout << "\n";
+
+	layers = census.run(MTT_Board3x5("X4/5/5 O"));
+	std::cout << "Positions from X4/5/5 O should be: 1 14 182 2184\n";
+	std::cout << "Positions from X4/5/5 O are:       ";
+	for (s_t tokens = 0; tokens < 4; tokens++)
+	{
+		std::cout << " " << layers[tokens].positions;
+	}
+	std::cout << "\n\n";
+}
+
+
+/*Runs every batch kernel on random positions of the board's size, with and without AVX2,
+ *and counts the boards where a kernel disagrees with MTT_Board.*/
+template <class Board>
+void testBatchSize(std::mt19937_64& random)
+{
+	typedef typename MTT_BoardBatch<Board>::Lane Lane;
+	const s_t NUM_BOARDS = 1003;	//Not a multiple of eight, so the scalar code finishes off every AVX2 run.
+	const s_t NUM_PLAYERS = Board::Geometry::NUM_PLAYERS;
+
+	//Random games, stopped after a random number of moves, or when they end.
+	std::vector<Board> boards(NUM_BOARDS);
+	MTT_BoardBatch<Board> start;
+	for (Board& board : boards)
+	{
+		s_t numMoves = random() % (Board::NUM_SQUARES + 1);
+		for (s_t move = 0; move < numMoves && !board.isOver(); move++)
+		{
+			typename Board::Bitboard empty = board.emptySquares();
+			for (s_t skip = random() % popCount(empty); skip > 0; skip--)
+			{
+				empty &= empty - 1;
+			}
+			Position square = Board::squarePosition(lowestBit(empty));
+			board.makeMove(square.row, square.col);
+		}
+		start.add(board);
+	}
+
+	//Each board plays a random empty square, or sits the move out.
+	std::vector<uint8_t> squares(NUM_BOARDS, MTT_BoardBatch<Board>::SKIP);
+	for (s_t index = 0; index < NUM_BOARDS; index++)
+	{
+		typename Board::Bitboard empty = boards[index].emptySquares();
+		if (!boards[index].isOver() && random() % 4 != 0)
+		{
+			for (s_t skip = random() % popCount(empty); skip > 0; skip--)
+			{
+				empty &= empty - 1;
+			}
+			squares[index] = lowestBit(empty);
+		}
+	}
+
+	for (bool vectorized : {false, true})
+	{
+		MTT_BoardBatch<Board> batch = start;
+		batch.setVectorized(vectorized);
+		std::vector<Lane> winners(NUM_BOARDS);
+		std::vector<Lane> moves(NUM_BOARDS);
+		std::vector<Lane> threats[NUM_PLAYERS];
+		batch.findWinners(winners.data());
+		batch.legalMoves(moves.data());
+		for (s_t player = 0; player < NUM_PLAYERS; player++)
+		{
+			threats[player].resize(NUM_BOARDS);
+			batch.threats(player, threats[player].data());
+		}
+		batch.applyMoves(squares.data());
+
+		s_t mismatches = 0;
+		for (s_t index = 0; index < NUM_BOARDS; index++)
+		{
+			const Board& board = boards[index];
+			bool matches = winners[index] == ((board.getWinner() == NONE) ? 0 : Lane(1) << Board::tokenIndex(board.getWinner()))
+				&& moves[index] == (board.isOver() ? 0 : Lane(board.emptySquares()));
+			for (s_t player = 0; player < NUM_PLAYERS && !board.isOver(); player++)
+			{
+				matches = matches && threats[player][index] == Lane(board.emptySquares() & board.winningSquares(Board::players[player]));
+			}
+
+			Board played = board;
+			if (squares[index] != MTT_BoardBatch<Board>::SKIP)
+			{
+				Position square = Board::squarePosition(squares[index]);
+				played.makeMove(square.row, square.col);
+			}
+			matches = matches && batch.board(index).getKey() == played.getKey();
+
+			mismatches += !matches;
+		}
+
+		std::cout << int(Board::Geometry::ROWS) << "x" << int(Board::Geometry::COLUMNS) << " kernels "
+			<< (vectorized ? (batch.usesAvx2() ? "with AVX2" : "with AVX2, (not supported here, so scalar again)") : "without AVX2")
+			<< " should match the board on all " << NUM_BOARDS << " boards, and differ on " << mismatches << "\n";
+	}
+}
+
+
+void testBatch()
+{
+	std::mt19937_64 random(12345);
+	testBatchSize<MTT_Board3x5>(random);
+	testBatchSize<MTT_Board4x4>(random);
+	testBatchSize<MTT_Board5x5>(random);
+	std::cout << "\n";
 }
@@ -0,0 +1,476 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <filesystem>
+#include <stdexcept>
+#include "mtt_board.hpp"
+#include "search_stats.hpp"
+#include "solver.hpp"
+#include "thread_pool.hpp"
+#include "bounded_queue.hpp"
+#include "result_database.hpp"
+
+
+/*Settings taken from the command line.*/
+struct AnalyzeOptions
+{
+	OutcomeSet target = ALL_OUTCOMES;
+	std::size_t tableMegabytes = 64;
+	std::size_t threads = std::max(std::thread::hardware_concurrency(), 1u);
+	bool json = false;
+	std::string statsPath;
+	double statsInterval = 0;
+	std::string databasePath;
+};
+
+
+/*Consecutive input lines which travel through the pipeline together,
+ *so that passing work between stages costs little next to solving it.
+ *`sequence` numbers batches in input order, which is the order their output is written in.*/
+struct Batch
+{
+	uint64_t sequence;
+	uint64_t firstLine;
+	std::vector<std::string> lines;
+	std::string output;
+};
+
+
+//Lines per batch, and batches each queue holds, (and workers may run ahead of the writer), per solving thread.
+const s_t BATCH_LINES = 64;
+const s_t BATCHES_PER_THREAD = 4;
+
+
+void printUsage();
+void writeJsonString(std::string& output, const std::string& text);
+
+template <class Board>
+int analyze(Board board, std::istream& input, std::vector<std::string> firstLines, const AnalyzeOptions& options);
+
+template <class Board>
+void analyzeBatch(Batch& batch, Board& board, Solver<Board>& solver, const AnalyzeOptions& options,
+	const ResultDatabase<Board>* database, std::vector<typename ResultDatabase<Board>::Record>& records);
+
+
+/*Solves a stream of positions, (one per line), and writes one line of results for each, in input order.
+ *Usage: mtt_analyze [file] [--size RxC] [--json] [--x-only] [--tt-mb megabytes] [--threads N]
+ *                   [--stats file] [--stats-every seconds] [--db file]
+ *Positions are read from `file`, or from standard input if no file is given.
+ *The board size is read from the first position, unless `--size` is given.
+ *Reading, solving, and writing run as separate stages connected by bounded queues,
+ *with solving spread across a thread pool, so one process can work through any number of positions
+ *while only holding a few batches of them in memory.
+ *`--stats` writes the search statistics to `file` as JSON when done, and every `--stats-every` seconds until then,
+ *if they were compiled in, (see the MTT_STATS CMake option).
+ *`--db` answers positions from a result database file where it can, and adds every position it had to solve to it.*/
+int main(int argc, char** argv)
+{
+	std::ios::sync_with_stdio(false);
+
+	AnalyzeOptions options;
+	std::string path;
+	uint8_t rows = 0;
+	uint8_t columns = 0;
+
+	int index = 1;
+	try
+	{
+		for (; index < argc; index++)
+		{
+			std::string argument = argv[index];
+			if (argument == "--json")
+			{
+				options.json = true;
+			}
+			else if (argument == "--x-only")
+			{
+				options.target = X_WINS;
+			}
+			else if (argument == "--size" && index + 1 < argc)
+			{
+				if (!parseBoardSize(argv[++index], rows, columns))
+				{
+					std::cerr << "Could not read board size \"" << argv[index] << "\".\n";
+					return 1;
+				}
+			}
+			else if (argument == "--tt-mb" && index + 1 < argc)
+			{
+				options.tableMegabytes = std::stoul(argv[++index]);
+			}
+			else if (argument == "--threads" && index + 1 < argc)
+			{
+				options.threads = std::max<std::size_t>(std::stoul(argv[++index]), 1);
+			}
+			else if (argument == "--stats" && index + 1 < argc)
+			{
+				options.statsPath = argv[++index];
+			}
+			else if (argument == "--stats-every" && index + 1 < argc)
+			{
+				options.statsInterval = std::stod(argv[++index]);
+			}
+			else if (argument == "--db" && index + 1 < argc)
+			{
+				options.databasePath = argv[++index];
+			}
+			else if (argument == "--help")
+			{
+				printUsage();
+				return 0;
+			}
+			else
+			{
+				path = argument;
+			}
+		}
+	}
+	catch (const std::logic_error&)
+	{
+		//std::stoul() and the like throw for anything that isn't a number, or is too big for one.
+		std::cerr << "Could not read the number given to " << argv[index - 1] << ".\n";
+		return 1;
+	}
+
+	std::ifstream file;
+	if (!path.empty())
+	{
+		file.open(path);
+		if (!file)
+		{
+			std::cerr << "Could not open \"" << path << "\".\n";
+			return 1;
+		}
+	}
+	std::istream& input = path.empty() ? std::cin : file;
+
+	std::ofstream statsFile;
+	std::unique_ptr<StatsReporter> stats;
+	if (!options.statsPath.empty())
+	{
+		statsFile.open(options.statsPath);
+		if (!statsFile)
+		{
+			std::cerr << "Could not open \"" << options.statsPath << "\".\n";
+			return 1;
+		}
+		if (!SearchStats::ENABLED)
+		{
+			std::cerr << "Search statistics weren't compiled in; rebuild with -DMTT_STATS=ON to count them.\n";
+		}
+		stats = std::make_unique<StatsReporter>(statsFile, options.statsInterval);
+	}
+
+	//The board size has to be known before anything can be solved, so read up to the first position now.
+	std::vector<std::string> firstLines;
+	std::string line;
+	while (rows == 0 && std::getline(input, line))
+	{
+		firstLines.push_back(line);
+		if (!line.empty() && line != "\r" && !boardSizeOf(line, rows, columns))
+		{
+			std::cerr << "Could not read position \"" << line << "\".\n";
+			return 1;
+		}
+	}
+
+	if (rows == 0)
+	{
+		//No positions at all, so there is nothing to do.
+		return 0;
+	}
+
+	int status = 1;
+	bool supported = withBoardSize(rows, columns, [&](auto board)
+	{
+		status = analyze(board, input, std::move(firstLines), options);
+	});
+
+	if (!supported)
+	{
+		std::cerr << "No " << int(rows) << "x" << int(columns) << " board is compiled in.\n";
+	}
+	return status;
+}
+
+
+/*Runs the three stages: this thread writes results, a second thread reads lines,
+ *and the thread pool solves them, each worker with its own board and solver,
+ *all sharing one transposition table, (and result database, if there is one).
+ *Workers finish batches out of order, so finished batches wait here until every batch before them is written.
+ *A worker holds off on a batch until it is within a window of the next one to be written,
+ *so however slow one batch is, only a window's worth of output ever waits behind it.
+ *New results are only added to the database once everything has been written.*/
+template <class Board>
+int analyze(Board board, std::istream& input, std::vector<std::string> firstLines, const AnalyzeOptions& options)
+{
+	typedef typename ResultDatabase<Board>::Record Record;
+
+	std::unique_ptr<ResultDatabase<Board>> database;
+	try
+	{
+		if (!options.databasePath.empty() && std::filesystem::exists(options.databasePath))
+		{
+			database = std::make_unique<ResultDatabase<Board>>(options.databasePath);
+		}
+	}
+	catch (const std::exception& error)
+	{
+		std::cerr << error.what() << "\n";
+		return 1;
+	}
+
+	BoundedQueue<Batch> toSolve(options.threads * BATCHES_PER_THREAD);
+	BoundedQueue<Batch> toWrite(options.threads * BATCHES_PER_THREAD);
+	TranspositionTable table(options.tableMegabytes);
+
+	const uint64_t window = options.threads * BATCHES_PER_THREAD;
+	uint64_t nextSequence = 0;
+	std::mutex writtenMutex;
+	std::condition_variable written;
+	std::vector<Record> newRecords;
+	std::mutex newRecordsMutex;
+
+	std::thread reader([&]()
+	{
+		Batch batch {0, 1, std::move(firstLines), ""};
+		uint64_t nextLine = 1 + batch.lines.size();
+		std::string line;
+
+		while (std::getline(input, line))
+		{
+			if (batch.lines.size() == BATCH_LINES)
+			{
+				uint64_t sequence = batch.sequence + 1;
+				toSolve.push(std::move(batch));
+				batch = {sequence, nextLine, {}, ""};
+			}
+			batch.lines.push_back(std::move(line));
+			nextLine++;
+		}
+		toSolve.push(std::move(batch));
+		toSolve.close();
+	});
+
+	if (!options.json)
+	{
+		std::cout << "line\tposition\twinners\tbest_move\tnodes\terror\n";
+	}
+
+	{
+		ThreadPool pool(options.threads);
+		std::atomic<std::size_t> working(pool.size());
+
+		for (std::size_t worker = 0; worker < pool.size(); worker++)
+		{
+			pool.submit([&, board]() mutable
+			{
+				Solver<Board> solver(table);
+				std::vector<Record> records;
+				Batch batch;
+				while (toSolve.pop(batch))
+				{
+					{
+						std::unique_lock<std::mutex> lock(writtenMutex);
+						written.wait(lock, [&]() { return batch.sequence < nextSequence + window; });
+					}
+					analyzeBatch(batch, board, solver, options, database.get(), records);
+					toWrite.push(std::move(batch));
+				}
+
+				if (!options.databasePath.empty())
+				{
+					std::lock_guard<std::mutex> lock(newRecordsMutex);
+					newRecords.insert(newRecords.end(), records.begin(), records.end());
+				}
+
+				if (working.fetch_sub(1) == 1)
+				{
+					toWrite.close();
+				}
+			});
+		}
+
+		//Only this thread changes nextSequence, so it can read it without the lock.
+		std::map<uint64_t, std::string> finished;
+		Batch batch;
+		while (toWrite.pop(batch))
+		{
+			finished[batch.sequence] = std::move(batch.output);
+			for (auto next = finished.find(nextSequence); next != finished.end(); next = finished.find(nextSequence))
+			{
+				std::cout << next->second;
+				finished.erase(next);
+				{
+					std::lock_guard<std::mutex> lock(writtenMutex);
+					nextSequence++;
+				}
+				written.notify_all();
+			}
+		}
+	}
+
+	reader.join();
+	std::cout.flush();
+
+	if (!options.databasePath.empty() && !newRecords.empty())
+	{
+		//save() reads the old file again itself.
+		database.reset();
+		try
+		{
+			ResultDatabase<Board>::save(options.databasePath, std::move(newRecords));
+		}
+		catch (const std::exception& error)
+		{
+			std::cerr << error.what() << "\n";
+			return 1;
+		}
+	}
+	return std::cout ? 0 : 1;
+}
+
+
+/*Solves every position in the batch, appending a line of results for each to the batch's output.
+ *Blank lines are skipped, but still counted, so line numbers always match the input.
+ *Positions the database can answer aren't searched, (and report zero nodes),
+ *and records of the ones which were searched are appended to `records`, if there is a database file to add them to.*/
+template <class Board>
+void analyzeBatch(Batch& batch, Board& board, Solver<Board>& solver, const AnalyzeOptions& options,
+	const ResultDatabase<Board>* database, std::vector<typename ResultDatabase<Board>::Record>& records)
+{
+	const Outcome outcomes[] = {X_WINS, O_WINS, Y_WINS, DRAW};
+	const char* names[] = {"X", "O", "Y", "draw"};
+	std::string& output = batch.output;
+
+	for (s_t index = 0; index < batch.lines.size(); index++)
+	{
+		std::string& position = batch.lines[index];
+		if (!position.empty() && position.back() == '\r')
+		{
+			position.pop_back();
+		}
+		if (position.empty())
+		{
+			continue;
+		}
+
+		std::string line = std::to_string(batch.firstLine + index);
+		ParseError error = board.trySetBoard(position);
+
+		if (error != ParseError::OK)
+		{
+			if (options.json)
+			{
+				output += "{\"line\":" + line + ",\"position\":";
+				writeJsonString(output, position);
+				output += ",\"error\":";
+				writeJsonString(output, describeParseError(error));
+				output += "}\n";
+			}
+			else
+			{
+				output += line + "\t" + position + "\t-\t-\t0\t" + describeParseError(error) + "\n";
+			}
+			continue;
+		}
+
+		SolveResult result;
+		if (database == nullptr || !database->answer(board, options.target, result))
+		{
+			result = solver.solve(board, options.target);
+			if (!options.databasePath.empty())
+			{
+				ResultDatabase<Board>::addResult(board, options.target, result, records);
+			}
+		}
+
+		//Comma separated either way; JSON just quotes each name.
+		std::string winners;
+		for (s_t outcome = 0; outcome < 4; outcome++)
+		{
+			if (result.reachable & options.target & outcomes[outcome])
+			{
+				winners += winners.empty() ? "" : ",";
+				winners += options.json ? "\"" + std::string(names[outcome]) + "\"" : names[outcome];
+			}
+		}
+
+		bool hasMove = !result.witness.empty();
+		Position move = hasMove ? result.witness[0] : Position {0, 0};
+
+		if (options.json)
+		{
+			output += "{\"line\":" + line + ",\"position\":";
+			writeJsonString(output, position);
+			output += ",\"winners\":[" + winners + "],\"best_move\":";
+			output += hasMove ? "[" + std::to_string(move.row) + "," + std::to_string(move.col) + "]" : "null";
+			output += ",\"nodes\":" + std::to_string(result.nodes) + "}\n";
+		}
+		else
+		{
+			output += line + "\t" + position + "\t" + (winners.empty() ? "-" : winners) + "\t";
+			output += hasMove ? std::to_string(move.row) + "," + std::to_string(move.col) : "-";
+			output += "\t" + std::to_string(result.nodes) + "\t\n";
+		}
+	}
+
+	batch.lines.clear();
+}
+
+
+/*Appends `text` as a quoted JSON string. Bad input lines can hold anything, so every special character is escaped.*/
+void writeJsonString(std::string& output, const std::string& text)
+{
+	const char* hexDigits = "0123456789abcdef";
+
+	output += '"';
+	for (char curChar : text)
+	{
+		unsigned char code = curChar;
+		if (curChar == '"' || curChar == '\\')
+		{
+			output += '\\';
+			output += curChar;
+		}
+		else if (code < 0x20)
+		{
+			output += "\\u00";
+			output += hexDigits[code >> 4];
+			output += hexDigits[code & 0xF];
+		}
+		else
+		{
+			output += curChar;
+		}
+	}
+	output += '"';
+}
+
+
+void printUsage()
+{
+	std::cout << "Usage: mtt_analyze [file] [--size RxC] [--json] [--x-only] [--tt-mb megabytes] [--threads N]\n";
+	std::cout << "                   [--stats file] [--stats-every seconds] [--db file]\n";
+	std::cout << "  file      File of positions, one per line. Defaults to standard input.\n";
+	std::cout << "  --size    Board size, eg. 5x5. Defaults to the size of the first position.\n";
+	std::cout << "  --json    Write one JSON object per line instead of tab separated columns.\n";
+	std::cout << "  --x-only  Only find out whether X can win, rather than every reachable outcome.\n";
+	std::cout << "  --tt-mb   Memory budget of the transposition table, in megabytes. Defaults to 64.\n";
+	std::cout << "  --threads Number of positions to solve at once. Defaults to one per core.\n";
+	std::cout << "  --stats   Write search statistics to this file as a line of JSON when done. Needs a build with -DMTT_STATS=ON.\n";
+	std::cout << "  --stats-every  Also write a line of statistics this often, in seconds, while solving.\n";
+	std::cout << "  --db      Answer positions from this result database where it can, and add the rest to it.\n";
+	std::cout << "Each position gets a line with every outcome reachable under the semi-competent rule, (\"winners\"),\n";
+	std::cout << "the first move of a line where X wins, (\"best_move\", as row,col), and the positions searched.\n";
+	std::cout << "Output is always in input order. Best moves and node counts depend on what the shared table already holds,\n";
+	std::cout << "so they only repeat exactly from run to run with --threads 1. Winners never change.\n";
+}
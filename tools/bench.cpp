@@ -0,0 +1,365 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <stdexcept>
+#include "mtt_board.hpp"
+#include "position_rank.hpp"
+#include "mtt_board_batch.hpp"
+
+
+/*Keeps the compiler from optimizing away work whose result is never used.*/
+volatile uint64_t sink;
+
+
+/*Times `operation`, which performs `count` operations, and prints the time taken per operation.*/
+template <class Operation>
+void measure(const std::string& name, uint64_t count, Operation&& operation)
+{
+	auto start = std::chrono::steady_clock::now();
+	operation();
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	std::cout << std::left << std::setw(24) << name << std::right
+		<< std::setw(12) << std::fixed << std::setprecision(2) << (seconds * 1e9 / count)
+		<< std::setw(16) << uint64_t(count / seconds) << "\n";
+}
+
+
+/*Plays every move from every empty square, undoing each one on the way back out,
+ *and returns the number of positions visited.*/
+template <class Board>
+uint64_t walkTree(Board& board, s_t depth)
+{
+	if (depth == 0 || board.isOver())
+	{
+		return 1;
+	}
+
+	uint64_t nodes = 1;
+	typename Board::Bitboard empty = board.emptySquares();
+	while (empty)
+	{
+		Position move = Board::squarePosition(lowestBit(empty));
+		empty &= empty - 1;
+
+		board.makeMove(move.row, move.col);
+		nodes += walkTree(board, depth - 1);
+		board.undoLastMove();
+	}
+	return nodes;
+}
+
+
+template <class Board>
+void runBenchmarks(Board empty, s_t numGames, s_t treeDepth)
+{
+	constexpr uint8_t ROWS = Board::Geometry::ROWS;
+	constexpr uint8_t COLUMNS = Board::Geometry::COLUMNS;
+
+	/*Record a fixed set of random games up front, so every benchmark replays the same moves.*/
+	std::mt19937_64 random(0x4D5454);
+	std::vector<std::vector<Position>> games(numGames);
+	std::vector<Board> midgames;
+	uint64_t totalMoves = 0;
+
+	for (auto& game : games)
+	{
+		Board board = empty;
+		while (!board.isOver())
+		{
+			Position move {uint8_t(random() % ROWS), uint8_t(random() % COLUMNS)};
+			if (board.makeMove(move.row, move.col))
+			{
+				game.push_back(move);
+				if (!board.isOver() && random() % 4 == 0)
+				{
+					midgames.push_back(board);
+				}
+			}
+		}
+		totalMoves += game.size();
+	}
+
+	std::vector<std::string> positions;
+	for (const Board& board : midgames)
+	{
+		positions.push_back(board.getBoardPosition());
+	}
+
+	std::cout << "Board: " << int(ROWS) << "x" << int(COLUMNS) << ", "
+		<< numGames << " random games, " << totalMoves << " moves\n";
+	std::cout << std::left << std::setw(24) << "operation" << std::right
+		<< std::setw(12) << "ns/op" << std::setw(16) << "ops/s" << "\n";
+
+	std::vector<Board> finished(numGames, empty);
+	measure("makeMove", totalMoves, [&]()
+	{
+		for (s_t game = 0; game < numGames; game++)
+		{
+			for (Position move : games[game])
+			{
+				finished[game].makeMove(move.row, move.col);
+			}
+		}
+	});
+
+	measure("undoLastMove", totalMoves, [&]()
+	{
+		for (s_t game = 0; game < numGames; game++)
+		{
+			for (s_t move = 0; move < games[game].size(); move++)
+			{
+				finished[game].undoLastMove();
+			}
+		}
+	});
+
+	//Every empty square of every midgame position, for the turn player.
+	uint64_t emptySquares = 0;
+	for (const Board& board : midgames)
+	{
+		emptySquares += popCount(board.emptySquares());
+	}
+	measure("isWinningSquare", emptySquares, [&]()
+	{
+		uint64_t wins = 0;
+		for (const Board& board : midgames)
+		{
+			typename Board::Bitboard squares = board.emptySquares();
+			while (squares)
+			{
+				Position square = Board::squarePosition(lowestBit(squares));
+				squares &= squares - 1;
+				wins += board.isWinningSquare(square.row, square.col, board.getTurnPlayer());
+			}
+		}
+		sink = wins;
+	});
+
+	measure("setBoard", positions.size(), [&]()
+	{
+		Board board;
+		uint64_t moves = 0;
+		for (const std::string& position : positions)
+		{
+			board.setBoard(position);
+			moves += board.getNumMoves();
+		}
+		sink = moves;
+	});
+
+	measure("parseKey", positions.size(), [&]()
+	{
+		typename Board::PositionKey keys = 0;
+		for (const std::string& position : positions)
+		{
+			typename Board::PositionKey key = 0;
+			Board::parseKey(position, key);
+			keys ^= key;
+		}
+		sink = uint64_t(keys);
+	});
+
+	measure("getBoardPosition", midgames.size(), [&]()
+	{
+		uint64_t length = 0;
+		for (const Board& board : midgames)
+		{
+			length += board.getBoardPosition().size();
+		}
+		sink = length;
+	});
+
+	measure("writeBoardPosition", midgames.size(), [&]()
+	{
+		char buffer[Board::MAX_POSITION_LENGTH];
+		uint64_t length = 0;
+		for (const Board& board : midgames)
+		{
+			length += board.writeBoardPosition(buffer);
+		}
+		sink = length;
+	});
+
+	typedef PositionRank<typename Board::Geometry> Rank;
+	std::vector<uint64_t> ranks(midgames.size());
+	measure("rank", midgames.size(), [&]()
+	{
+		for (s_t index = 0; index < midgames.size(); index++)
+		{
+			ranks[index] = Rank::rank(midgames[index].getKey());
+		}
+	});
+
+	measure("unrank", ranks.size(), [&]()
+	{
+		typename Board::PositionKey keys = 0;
+		for (uint64_t rank : ranks)
+		{
+			keys ^= Rank::unrank(rank);
+		}
+		sink = uint64_t(keys);
+	});
+
+	/*Bulk checks of every midgame position, first one board at a time with the board's own bit tricks,
+	 *then as a batch, with the scalar kernels and with AVX2, (if the CPU has it).
+	 *Each is repeated, since a single pass over a batch is too quick to time well.*/
+	const s_t REPEATS = 20;
+	const Token players[] = {X, O, Y};
+	typedef typename Board::Geometry Geometry;
+	MTT_BoardBatch<Board> batch;
+	for (const Board& board : midgames)
+	{
+		batch.add(board);
+	}
+	std::vector<uint32_t> lanes(batch.size());
+	uint64_t batchChecks = REPEATS * batch.size();
+
+	measure("winners, one by one", batchChecks, [&]()
+	{
+		uint64_t found = 0;
+		for (s_t repeat = 0; repeat < REPEATS; repeat++)
+		{
+			for (const Board& board : midgames)
+			{
+				for (s_t player = 0; player < Geometry::NUM_PLAYERS; player++)
+				{
+					found += Geometry::hasLine(board.playerSquares(players[player]));
+				}
+			}
+		}
+		sink = found;
+	});
+
+	measure("threats, one by one", batchChecks, [&]()
+	{
+		uint64_t found = 0;
+		for (s_t repeat = 0; repeat < REPEATS; repeat++)
+		{
+			for (const Board& board : midgames)
+			{
+				found += Geometry::threatSquares(board.playerSquares(board.getTurnPlayer())) & board.emptySquares();
+			}
+		}
+		sink = found;
+	});
+
+	for (bool vectorized : {false, true})
+	{
+		batch.setVectorized(vectorized);
+		if (vectorized && !batch.usesAvx2())
+		{
+			break;
+		}
+		std::string kernel = vectorized ? " (avx2)" : " (scalar)";
+
+		measure("batch winners" + kernel, batchChecks, [&]()
+		{
+			for (s_t repeat = 0; repeat < REPEATS; repeat++)
+			{
+				batch.findWinners(lanes.data());
+			}
+			sink = lanes[0];
+		});
+
+		measure("batch threats" + kernel, batchChecks, [&]()
+		{
+			for (s_t repeat = 0; repeat < REPEATS; repeat++)
+			{
+				batch.threats(repeat % Geometry::NUM_PLAYERS, lanes.data());
+			}
+			sink = lanes[0];
+		});
+
+		measure("batch legal" + kernel, batchChecks, [&]()
+		{
+			for (s_t repeat = 0; repeat < REPEATS; repeat++)
+			{
+				batch.legalMoves(lanes.data());
+			}
+			sink = lanes[0];
+		});
+	}
+
+	//Whole-tree throughput, which is what the solver actually spends its time on.
+	Board board = empty;
+	auto start = std::chrono::steady_clock::now();
+	uint64_t nodes = walkTree(board, treeDepth);
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	std::cout << "\nTree walk to depth " << treeDepth << ": " << nodes << " nodes, "
+		<< uint64_t(nodes / seconds) << " nodes/s\n";
+}
+
+
+void printUsage();
+
+
+/*Measures how fast the board's basic operations run, to catch performance regressions.
+ *Usage: bench [--size RxC] [--games N] [--depth N]*/
+int main(int argc, char** argv)
+{
+	uint8_t rows = 3;
+	uint8_t columns = 5;
+	s_t numGames = 200000;
+	s_t treeDepth = 6;
+
+	int index = 1;
+	try
+	{
+		for (; index < argc; index++)
+		{
+			std::string argument = argv[index];
+			if (argument == "--size" && index + 1 < argc)
+			{
+				if (!parseBoardSize(argv[++index], rows, columns))
+				{
+					std::cerr << "Could not read board size \"" << argv[index] << "\".\n";
+					return 1;
+				}
+			}
+			else if (argument == "--games" && index + 1 < argc)
+			{
+				numGames = std::stoul(argv[++index]);
+			}
+			else if (argument == "--depth" && index + 1 < argc)
+			{
+				treeDepth = std::stoul(argv[++index]);
+			}
+			else
+			{
+				printUsage();
+				return (argument == "--help") ? 0 : 1;
+			}
+		}
+	}
+	catch (const std::logic_error&)
+	{
+		//std::stoul() and the like throw for anything that isn't a number, or is too big for one.
+		std::cerr << "Could not read the number given to " << argv[index - 1] << ".\n";
+		return 1;
+	}
+
+	bool supported = withBoardSize(rows, columns, [&](auto board)
+	{
+		runBenchmarks(board, numGames, treeDepth);
+	});
+
+	if (!supported)
+	{
+		std::cerr << "No " << int(rows) << "x" << int(columns) << " board is compiled in.\n";
+		return 1;
+	}
+	return 0;
+}
+
+
+void printUsage()
+{
+	std::cout << "Usage: bench [--size RxC] [--games N] [--depth N]\n";
+	std::cout << "  --size   Board size to measure. Defaults to 3x5.\n";
+	std::cout << "  --games  Number of random games to replay. Defaults to 200000.\n";
+	std::cout << "  --depth  Depth of the full tree walk used to measure nodes/s. Defaults to 6.\n";
+}
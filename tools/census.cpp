@@ -0,0 +1,177 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <chrono>
+#include <filesystem>
+#include <stdexcept>
+#include "mtt_board.hpp"
+#include "census.hpp"
+
+
+/*Settings taken from the command line.*/
+struct CensusOptions
+{
+	std::size_t memoryMegabytes = 1024;
+	std::filesystem::path tempDirectory;
+	CensusMoves moves = CensusMoves::ALL;
+};
+
+
+void printUsage();
+
+template <class Board>
+int countPositions(Board board, const std::string& position, const CensusOptions& options);
+
+
+/*Counts every distinct position reachable from a position, for each number of tokens on the board,
+ *along with how many of them are finished games, and who won them.
+ *Usage: census [position] [--size RxC] [--memory-mb megabytes] [--temp directory] [--semi-competent]
+ *`position` uses the notation described by MTT_Board's constructor, and its board size is read from it.
+ *Without a position, the empty board of the size given by `--size`, (3x5 by default), is used.
+ *Layers bigger than `--memory-mb` are sorted on disk, in `--temp`, (the system's temporary directory by default).
+ *`--semi-competent` only follows the moves the semi-competent rule allows, instead of every empty square.*/
+int main(int argc, char** argv)
+{
+	std::string position;
+	uint8_t rows = 3;
+	uint8_t columns = 5;
+	CensusOptions options;
+
+	int index = 1;
+	try
+	{
+		for (; index < argc; index++)
+		{
+			std::string argument = argv[index];
+			if (argument == "--size" && index + 1 < argc)
+			{
+				if (!parseBoardSize(argv[++index], rows, columns))
+				{
+					std::cerr << "Could not read board size \"" << argv[index] << "\".\n";
+					return 1;
+				}
+			}
+			else if (argument == "--memory-mb" && index + 1 < argc)
+			{
+				options.memoryMegabytes = std::stoul(argv[++index]);
+			}
+			else if (argument == "--temp" && index + 1 < argc)
+			{
+				options.tempDirectory = argv[++index];
+			}
+			else if (argument == "--semi-competent")
+			{
+				options.moves = CensusMoves::SEMI_COMPETENT;
+			}
+			else if (argument == "--help")
+			{
+				printUsage();
+				return 0;
+			}
+			else
+			{
+				position = argument;
+			}
+		}
+	}
+	catch (const std::logic_error&)
+	{
+		//std::stoul() and the like throw for anything that isn't a number, or is too big for one.
+		std::cerr << "Could not read the number given to " << argv[index - 1] << ".\n";
+		return 1;
+	}
+
+	if (!position.empty() && !boardSizeOf(position, rows, columns))
+	{
+		std::cerr << "Could not read position \"" << position << "\".\n";
+		return 1;
+	}
+
+	int status = 1;
+	bool supported = withBoardSize(rows, columns, [&](auto board)
+	{
+		status = countPositions(board, position, options);
+	});
+
+	if (!supported)
+	{
+		std::cerr << "No " << int(rows) << "x" << int(columns) << " board is compiled in.\n";
+	}
+	return status;
+}
+
+
+template <class Board>
+int countPositions(Board board, const std::string& position, const CensusOptions& options)
+{
+	try
+	{
+		if (!position.empty())
+		{
+			board.setBoard(position);
+		}
+	}
+	catch (const std::exception& error)
+	{
+		std::cerr << "Could not read position \"" << position << "\": " << error.what() << "\n";
+		return 1;
+	}
+
+	std::vector<CensusLayer> layers;
+	auto start = std::chrono::steady_clock::now();
+	try
+	{
+		std::filesystem::path tempDirectory = options.tempDirectory.empty()
+			? std::filesystem::temp_directory_path() : options.tempDirectory;
+		PositionCensus<Board> census(options.memoryMegabytes, tempDirectory, options.moves);
+		layers = census.run(board, &std::cerr);
+	}
+	catch (const std::exception& error)
+	{
+		std::cerr << error.what() << "\n";
+		return 1;
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	std::cout << "Position:  " << board.getBoardPosition() << "\n";
+	std::cout << "Moves:     " << ((options.moves == CensusMoves::ALL) ? "every empty square" : "semi-competent") << "\n";
+	std::cout << "Time:      " << std::fixed << std::setprecision(2) << seconds << "s\n\n";
+
+	//Finished games are counted like positions, with symmetric copies counted separately.
+	std::cout << "Tokens    Positions   Up to symmetry      X wins      O wins      Y wins       Draws\n";
+	CensusLayer total {0, 0, {0, 0, 0, 0}, 0};
+	for (s_t index = 0; index < layers.size(); index++)
+	{
+		const CensusLayer& layer = layers[index];
+		std::cout << std::setw(6) << (board.getNumMoves() + index) << std::setw(13) << layer.positions
+			<< std::setw(17) << layer.classes;
+		for (s_t outcome = 0; outcome < 4; outcome++)
+		{
+			std::cout << std::setw(12) << layer.finished[outcome];
+			total.finished[outcome] += layer.finished[outcome];
+		}
+		std::cout << "\n";
+		total.positions += layer.positions;
+		total.classes += layer.classes;
+	}
+
+	std::cout << " Total" << std::setw(13) << total.positions << std::setw(17) << total.classes;
+	for (s_t outcome = 0; outcome < 4; outcome++)
+	{
+		std::cout << std::setw(12) << total.finished[outcome];
+	}
+	std::cout << "\n";
+	return 0;
+}
+
+
+void printUsage()
+{
+	std::cout << "Usage: census [position] [--size RxC] [--memory-mb megabytes] [--temp directory] [--semi-competent]\n";
+	std::cout << "  position     Board position to count from, eg. \"X4/5/5 O\". Defaults to the empty board.\n";
+	std::cout << "  --size       Size of the empty board to count from when no position is given, eg. 4x4. Defaults to 3x5.\n";
+	std::cout << "  --memory-mb  Memory budget for each layer, in megabytes, beyond which it is sorted on disk. Defaults to 1024.\n";
+	std::cout << "               Actual use can reach about twice this.\n";
+	std::cout << "  --temp       Directory for layers which don't fit in memory. Defaults to the system's temporary directory.\n";
+	std::cout << "  --semi-competent  Only follow the moves the semi-competent rule allows, rather than every empty square.\n";
+}
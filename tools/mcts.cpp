@@ -0,0 +1,237 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <stdexcept>
+#include "mtt_board.hpp"
+#include "monte_carlo.hpp"
+
+
+/*Settings taken from the command line.*/
+struct MctsOptions
+{
+	SearchBudget budget;
+	std::size_t treeMegabytes = 256;
+	std::size_t threads = std::max(std::thread::hardware_concurrency(), 1u);
+	uint64_t seed = 0;
+	double reportSeconds = 1;
+};
+
+
+void printUsage();
+
+template <class Board>
+int searchPosition(Board board, const std::string& position, const MctsOptions& options);
+
+template <s_t NUM_PLAYERS>
+void printRates(const std::array<double, NUM_PLAYERS + 1>& rates);
+
+
+/*Estimates how a position plays out between semi-competent players with a Monte Carlo tree search,
+ *for boards where an exact solve won't finish.
+ *Usage: mcts [position] [--size RxC] [--seconds S] [--playouts N] [--threads N] [--tree-mb megabytes] [--seed N]
+ *`position` uses the notation described by MTT_Board's constructor, and its board size is read from it.
+ *Without a position, the empty board of the size given by `--size`, (5x5 by default), is searched.
+ *The search stops after `--seconds`, or `--playouts`, whichever comes first, (5 seconds if neither is given).
+ *While it runs, the current best move and win rates are printed every second.*/
+int main(int argc, char** argv)
+{
+	std::string position;
+	uint8_t rows = 5;
+	uint8_t columns = 5;
+	MctsOptions options;
+
+	int index = 1;
+	try
+	{
+		for (; index < argc; index++)
+		{
+			std::string argument = argv[index];
+			if (argument == "--size" && index + 1 < argc)
+			{
+				if (!parseBoardSize(argv[++index], rows, columns))
+				{
+					std::cerr << "Could not read board size \"" << argv[index] << "\".\n";
+					return 1;
+				}
+			}
+			else if (argument == "--seconds" && index + 1 < argc)
+			{
+				options.budget.seconds = std::stod(argv[++index]);
+			}
+			else if (argument == "--playouts" && index + 1 < argc)
+			{
+				options.budget.playouts = std::stoull(argv[++index]);
+			}
+			else if (argument == "--threads" && index + 1 < argc)
+			{
+				options.threads = std::max<std::size_t>(std::stoul(argv[++index]), 1);
+			}
+			else if (argument == "--tree-mb" && index + 1 < argc)
+			{
+				options.treeMegabytes = std::stoul(argv[++index]);
+			}
+			else if (argument == "--seed" && index + 1 < argc)
+			{
+				options.seed = std::stoull(argv[++index]);
+			}
+			else if (argument == "--help")
+			{
+				printUsage();
+				return 0;
+			}
+			else
+			{
+				position = argument;
+			}
+		}
+	}
+	catch (const std::logic_error&)
+	{
+		//std::stoul() and the like throw for anything that isn't a number, or is too big for one.
+		std::cerr << "Could not read the number given to " << argv[index - 1] << ".\n";
+		return 1;
+	}
+
+	if (options.budget.seconds <= 0 && options.budget.playouts == 0)
+	{
+		options.budget.seconds = 5;
+	}
+
+	if (!position.empty() && !boardSizeOf(position, rows, columns))
+	{
+		std::cerr << "Could not read position \"" << position << "\".\n";
+		return 1;
+	}
+
+	int status = 1;
+	bool supported = withBoardSize(rows, columns, [&](auto board)
+	{
+		status = searchPosition(board, position, options);
+	});
+
+	if (!supported)
+	{
+		std::cerr << "No " << int(rows) << "x" << int(columns) << " board is compiled in.\n";
+	}
+	return status;
+}
+
+
+/*Runs the search on its own thread, and reads its results from this one while it runs.*/
+template <class Board>
+int searchPosition(Board board, const std::string& position, const MctsOptions& options)
+{
+	constexpr s_t NUM_PLAYERS = MonteCarloSearch<Board>::NUM_PLAYERS;
+
+	try
+	{
+		if (!position.empty())
+		{
+			board.setBoard(position);
+		}
+	}
+	catch (const std::exception& error)
+	{
+		std::cerr << "Could not read position \"" << position << "\": " << error.what() << "\n";
+		return 1;
+	}
+
+	std::cout << "Position:  " << board.getBoardPosition() << "\n";
+	if (board.isOver())
+	{
+		std::cout << "The game is already over.\n";
+		return 0;
+	}
+
+	MonteCarloSearch<Board> search(options.treeMegabytes, options.threads, 1.4, options.seed);
+	std::atomic<bool> finished(false);
+	auto start = std::chrono::steady_clock::now();
+
+	std::thread searcher([&]()
+	{
+		search.search(board, options.budget);
+		finished = true;
+	});
+
+	std::cout << std::fixed << std::setprecision(1);
+	auto nextReport = start;
+	while (!finished)
+	{
+		nextReport += std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+			std::chrono::duration<double>(options.reportSeconds));
+		while (!finished && std::chrono::steady_clock::now() < nextReport)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+		if (finished)
+		{
+			break;
+		}
+
+		Position best = search.bestMove();
+		double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		std::cout << std::setw(6) << elapsed << "s " << std::setw(12) << search.playouts() << " playouts, best ("
+			<< int(best.row) << ", " << int(best.col) << "),";
+		printRates<NUM_PLAYERS>(search.winRates());
+	}
+	searcher.join();
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	std::cout << "\nMove         Playouts";
+	for (s_t player = 0; player < NUM_PLAYERS; player++)
+	{
+		std::cout << "       " << char(Board::players[player]);
+	}
+	std::cout << "    draw\n";
+
+	for (const MoveStats<NUM_PLAYERS>& move : search.moveStats())
+	{
+		std::cout << "(" << int(move.move.row) << ", " << int(move.move.col) << ")  " << std::setw(13) << move.visits;
+		for (double rate : move.rates)
+		{
+			std::cout << std::setw(7) << rate * 100 << "%";
+		}
+		std::cout << "\n";
+	}
+
+	Position best = search.bestMove();
+	std::cout << "\nBest move: (" << int(best.row) << ", " << int(best.col) << ")\n";
+	std::cout << "Outcomes: ";
+	printRates<NUM_PLAYERS>(search.winRates());
+	std::cout << "Playouts:  " << search.playouts() << " in " << std::setprecision(2) << seconds << "s, ("
+		<< uint64_t(search.playouts() / seconds) << " per second)\n";
+	std::cout << "Tree:      " << search.treeSize() << " of " << search.treeCapacity() << " nodes\n";
+	return 0;
+}
+
+
+/*Prints each player's win rate, then the draw rate, on one line.*/
+template <s_t NUM_PLAYERS>
+void printRates(const std::array<double, NUM_PLAYERS + 1>& rates)
+{
+	const Token players[] = {X, O, Y};
+	for (s_t player = 0; player < NUM_PLAYERS; player++)
+	{
+		std::cout << " " << char(players[player]) << " " << rates[player] * 100 << "%";
+	}
+	std::cout << " draw " << rates[NUM_PLAYERS] * 100 << "%\n";
+}
+
+
+void printUsage()
+{
+	std::cout << "Usage: mcts [position] [--size RxC] [--seconds S] [--playouts N] [--threads N] [--tree-mb megabytes] [--seed N]\n";
+	std::cout << "  position   Board position to search, eg. \"X4/5/5/5/5 O\". Defaults to the empty board.\n";
+	std::cout << "  --size     Size of the empty board to search when no position is given, eg. 4x4. Defaults to 5x5.\n";
+	std::cout << "  --seconds  Stop after this many seconds. Defaults to 5 if --playouts isn't given either.\n";
+	std::cout << "  --playouts Stop after this many playouts.\n";
+	std::cout << "  --threads  Number of threads growing the tree. Defaults to one per core.\n";
+	std::cout << "  --tree-mb  Memory for the search tree, in megabytes. Defaults to 256.\n";
+	std::cout << "  --seed     Seed for the random playouts. With --threads 1 and --playouts, the same seed gives the same output.\n";
+	std::cout << "Win rates are the share of playouts, (games between random semi-competent players), ending in each outcome,\n";
+	std::cout << "with every player steering the tree towards their own wins.\n";
+}
@@ -0,0 +1,504 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <stdexcept>
+#include "mtt_board.hpp"
+#include "mtt_board_batch.hpp"
+
+
+/*Positions and game endings found exactly `depth` moves below a position.*/
+struct PerftCounts
+{
+	uint64_t nodes = 0;
+	uint64_t xWins = 0;
+	uint64_t oWins = 0;
+	uint64_t yWins = 0;
+	uint64_t draws = 0;
+
+	PerftCounts& operator+=(const PerftCounts& other)
+	{
+		nodes += other.nodes;
+		xWins += other.xWins;
+		oWins += other.oWins;
+		yWins += other.yWins;
+		draws += other.draws;
+		return *this;
+	}
+
+	bool operator==(const PerftCounts& other) const = default;
+
+	//Counts a finished game under whoever won it.
+	void addOutcome(Token winner, uint64_t count = 1)
+	{
+		switch (winner)
+		{
+			case X: xWins += count; break;
+			case O: oWins += count; break;
+			case Y: yWins += count; break;
+			default: draws += count; break;
+		}
+	}
+};
+
+
+/*Settings shared by every perft run.*/
+struct PerftOptions
+{
+	s_t maxDepth = 6;
+	bool bulk = false;		//Count the last move of every line without playing it.
+	bool hashed = false;	//Reuse counts for positions reached more than once.
+	bool verify = false;	//Check every count against ReferenceBoard.
+	bool batch = false;		//Count with MTT_BoardBatch's kernels instead of a single board.
+	s_t hashEntries = 1 << 20;
+};
+
+
+/*Straightforward board that finds wins by walking outwards from the last move,
+ *the same way MTT_Board originally did.
+ *It is slow, but simple enough to trust, so faster boards can be checked against it.*/
+template <class Board>
+class ReferenceBoard
+{
+	private:
+		static constexpr int ROWS = Board::Geometry::ROWS;
+		static constexpr int COLUMNS = Board::Geometry::COLUMNS;
+		static constexpr int NUM_TO_WIN = Board::Geometry::NUM_TO_WIN;
+		static constexpr s_t NUM_PLAYERS = Board::Geometry::NUM_PLAYERS;
+
+		Token squares[ROWS][COLUMNS];
+		s_t numberOfMoves = 0;
+		s_t turnIndex = 0;
+		bool gameOver = false;
+		Token victor = NONE;
+
+		//Counts matching tokens stepping away from (row, col), not counting (row, col) itself.
+		int countLine(int row, int col, int rowStep, int colStep) const
+		{
+			int count = 0;
+			for (int step = 1; step < NUM_TO_WIN; step++)
+			{
+				int curRow = row + rowStep * step;
+				int curCol = col + colStep * step;
+				if (curRow < 0 || curRow >= ROWS || curCol < 0 || curCol >= COLUMNS
+					|| squares[curRow][curCol] != squares[row][col])
+				{
+					break;
+				}
+				count++;
+			}
+			return count;
+		}
+
+	public:
+		/*Copies the position, turn player, and game state out of `board`.*/
+		explicit ReferenceBoard(const Board& board)
+		{
+			for (int row = 0; row < ROWS; row++)
+			{
+				for (int col = 0; col < COLUMNS; col++)
+				{
+					squares[row][col] = board.getSquare(row, col);
+					numberOfMoves += (squares[row][col] != NONE);
+				}
+			}
+			turnIndex = Board::tokenIndex(board.getTurnPlayer());
+			gameOver = board.isOver();
+			victor = board.getWinner();
+		}
+
+		bool isEmpty(int row, int col) const { return squares[row][col] == NONE; }
+		bool isOver() const { return gameOver; }
+		Token getWinner() const { return victor; }
+
+		void makeMove(int row, int col)
+		{
+			squares[row][col] = Board::players[turnIndex];
+			numberOfMoves++;
+
+			const int directions[4][2] = {{0, 1}, {1, 0}, {1, 1}, {-1, 1}};
+			for (const auto& direction : directions)
+			{
+				if (1 + countLine(row, col, direction[0], direction[1])
+					+ countLine(row, col, -direction[0], -direction[1]) >= NUM_TO_WIN)
+				{
+					gameOver = true;
+					victor = squares[row][col];
+				}
+			}
+			if (numberOfMoves == ROWS * COLUMNS)
+			{
+				gameOver = true;
+			}
+			turnIndex = (turnIndex + 1) % NUM_PLAYERS;
+		}
+
+		void undoMove(int row, int col)
+		{
+			squares[row][col] = NONE;
+			numberOfMoves--;
+			turnIndex = (turnIndex + NUM_PLAYERS - 1) % NUM_PLAYERS;
+			gameOver = false;
+			victor = NONE;
+		}
+};
+
+
+/*Runs perft on a single board variant, keeping its hash table between depths.*/
+template <class Board>
+class Perft
+{
+	private:
+		struct HashEntry
+		{
+			uint64_t hash;
+			s_t depth;
+			PerftCounts counts;
+		};
+
+		PerftOptions options;
+		std::vector<HashEntry> hashTable;
+
+	public:
+		explicit Perft(const PerftOptions& options)
+			: options(options)
+		{
+			if (options.hashed)
+			{
+				hashTable.assign(options.hashEntries, HashEntry{0, 0, {}});
+			}
+		}
+
+
+		/*Counts every position and finished game exactly `depth` moves below the board.
+		 *Games which end sooner than that are not counted.*/
+		PerftCounts count(Board& board, s_t depth)
+		{
+			PerftCounts counts;
+
+			if (depth == 0)
+			{
+				counts.nodes = 1;
+				if (board.isOver())
+				{
+					counts.addOutcome(board.getWinner());
+				}
+				return counts;
+			}
+
+			if (board.isOver())
+			{
+				return counts;
+			}
+
+			typename Board::Bitboard empty = board.emptySquares();
+
+			/*Every empty square is a move, and the winning-square bitboard already says which ones win.
+			 *A move that doesn't win only ends the game if it fills the last empty square.*/
+			if (depth == 1 && options.bulk)
+			{
+				typename Board::Bitboard wins = empty & board.winningSquares(board.getTurnPlayer());
+				counts.nodes = popCount(empty);
+				counts.addOutcome(board.getTurnPlayer(), popCount(wins));
+				if (counts.nodes == 1 && !wins)
+				{
+					counts.draws = 1;
+				}
+				return counts;
+			}
+
+			//Positions are symmetric copies of each other if and only if their counts are too.
+			uint64_t hash = 0;
+			if (options.hashed)
+			{
+				Symmetry symmetry;
+				hash = board.getSymmetricHash(symmetry);
+				const HashEntry& entry = hashTable[hash % hashTable.size()];
+				if (entry.hash == hash && entry.depth == depth)
+				{
+					return entry.counts;
+				}
+			}
+
+			while (empty)
+			{
+				Position move = Board::squarePosition(lowestBit(empty));
+				empty &= empty - 1;
+
+				board.makeMove(move.row, move.col);
+				counts += count(board, depth - 1);
+				board.undoLastMove();
+			}
+
+			if (options.hashed)
+			{
+				hashTable[hash % hashTable.size()] = {hash, depth, counts};
+			}
+			return counts;
+		}
+
+
+		/*The same count, made on batches of positions, (see MTT_BoardBatch), rather than one board,
+		 *with the kernels finding every position's moves and winner, and playing the moves.*/
+		static PerftCounts countBatch(const Board& board, s_t depth)
+		{
+			MTT_BoardBatch<Board> batch;
+			batch.add(board);
+			PerftCounts counts;
+			countBatch(batch, depth, counts);
+			return counts;
+		}
+
+
+		/*Adds the counts `depth` moves below every position in `batch` to `counts`.
+		 *Each position's children are gathered into a batch of their own, which is counted, (and emptied),
+		 *whenever it holds BATCH_SIZE positions or more, so only a batch or so per depth is kept at once.*/
+		static void countBatch(const MTT_BoardBatch<Board>& batch, s_t depth, PerftCounts& counts)
+		{
+			const s_t BATCH_SIZE = 4096;
+
+			std::vector<uint32_t> moves(batch.size());
+			batch.legalMoves(moves.data());
+
+			if (depth == 0)
+			{
+				std::vector<uint32_t> winners(batch.size());
+				batch.findWinners(winners.data());
+				counts.nodes += batch.size();
+				for (s_t index = 0; index < batch.size(); index++)
+				{
+					if (winners[index])
+					{
+						counts.addOutcome(Board::players[lowestBit(winners[index])]);
+					}
+					else if (!moves[index])
+					{
+						counts.draws++;
+					}
+				}
+				return;
+			}
+
+			MTT_BoardBatch<Board> children;
+			std::vector<uint8_t> squares;
+			for (s_t index = 0; index < batch.size(); index++)
+			{
+				for (uint32_t empty = moves[index]; empty; empty &= empty - 1)
+				{
+					children.add(batch, index);
+					squares.push_back(lowestBit(empty));
+				}
+
+				if (children.size() >= BATCH_SIZE || (index + 1 == batch.size() && children.size() > 0))
+				{
+					children.applyMoves(squares.data());
+					countBatch(children, depth - 1, counts);
+					children.clear();
+					squares.clear();
+				}
+			}
+		}
+
+
+		/*The same count, made on ReferenceBoard, with no shortcuts at all.*/
+		static PerftCounts countReference(ReferenceBoard<Board>& board, s_t depth)
+		{
+			PerftCounts counts;
+
+			if (depth == 0)
+			{
+				counts.nodes = 1;
+				if (board.isOver())
+				{
+					counts.addOutcome(board.getWinner());
+				}
+				return counts;
+			}
+
+			if (board.isOver())
+			{
+				return counts;
+			}
+
+			for (int row = 0; row < Board::Geometry::ROWS; row++)
+			{
+				for (int col = 0; col < Board::Geometry::COLUMNS; col++)
+				{
+					if (board.isEmpty(row, col))
+					{
+						board.makeMove(row, col);
+						counts += countReference(board, depth - 1);
+						board.undoMove(row, col);
+					}
+				}
+			}
+			return counts;
+		}
+};
+
+
+void printUsage();
+
+template <class Board>
+int runPerft(Board board, const std::string& position, const PerftOptions& options);
+
+
+/*Counts positions and finished games at every depth below a position,
+ *to measure how fast the board plays moves, and to check that it plays them correctly.
+ *Usage: perft [position] [--size RxC] [--depth N] [--bulk] [--hash] [--verify] [--batch]*/
+int main(int argc, char** argv)
+{
+	std::string position;
+	uint8_t rows = 3;
+	uint8_t columns = 5;
+	PerftOptions options;
+
+	int index = 1;
+	try
+	{
+		for (; index < argc; index++)
+		{
+			std::string argument = argv[index];
+			if (argument == "--depth" && index + 1 < argc)
+			{
+				options.maxDepth = std::stoul(argv[++index]);
+			}
+			else if (argument == "--size" && index + 1 < argc)
+			{
+				if (!parseBoardSize(argv[++index], rows, columns))
+				{
+					std::cerr << "Could not read board size \"" << argv[index] << "\".\n";
+					return 1;
+				}
+			}
+			else if (argument == "--bulk")
+			{
+				options.bulk = true;
+			}
+			else if (argument == "--hash")
+			{
+				options.hashed = true;
+			}
+			else if (argument == "--verify")
+			{
+				options.verify = true;
+			}
+			else if (argument == "--batch")
+			{
+				options.batch = true;
+			}
+			else if (argument == "--help")
+			{
+				printUsage();
+				return 0;
+			}
+			else
+			{
+				position = argument;
+			}
+		}
+	}
+	catch (const std::logic_error&)
+	{
+		//std::stoul() and the like throw for anything that isn't a number, or is too big for one.
+		std::cerr << "Could not read the number given to " << argv[index - 1] << ".\n";
+		return 1;
+	}
+
+	if (!position.empty() && !boardSizeOf(position, rows, columns))
+	{
+		std::cerr << "Could not read position \"" << position << "\".\n";
+		return 1;
+	}
+
+	//Batches don't keep hashes, and always play every move.
+	if (options.batch && (options.bulk || options.hashed))
+	{
+		std::cerr << "--batch can't be combined with --bulk or --hash.\n";
+		return 1;
+	}
+
+	int status = 1;
+	bool supported = withBoardSize(rows, columns, [&](auto board)
+	{
+		status = runPerft(board, position, options);
+	});
+
+	if (!supported)
+	{
+		std::cerr << "No " << int(rows) << "x" << int(columns) << " board is compiled in.\n";
+	}
+	return status;
+}
+
+
+template <class Board>
+int runPerft(Board board, const std::string& position, const PerftOptions& options)
+{
+	try
+	{
+		if (!position.empty())
+		{
+			board.setBoard(position);
+		}
+	}
+	catch (const std::exception& error)
+	{
+		std::cerr << "Could not read position \"" << position << "\": " << error.what() << "\n";
+		return 1;
+	}
+
+	//There's no point counting past the end of the game.
+	s_t maxDepth = std::min<s_t>(options.maxDepth, Board::NUM_SQUARES - board.getNumMoves());
+
+	std::cout << "Position: " << board.getBoardPosition() << "\n";
+	std::cout << std::setw(5) << "depth" << std::setw(16) << "nodes"
+		<< std::setw(14) << "X wins" << std::setw(14) << "O wins"
+		<< std::setw(14) << "Y wins" << std::setw(14) << "draws"
+		<< std::setw(14) << "nodes/s" << "\n";
+
+	Perft<Board> perft(options);
+	int status = 0;
+
+	for (s_t depth = 1; depth <= maxDepth; depth++)
+	{
+		auto start = std::chrono::steady_clock::now();
+		PerftCounts counts = options.batch ? Perft<Board>::countBatch(board, depth) : perft.count(board, depth);
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		std::cout << std::setw(5) << depth << std::setw(16) << counts.nodes
+			<< std::setw(14) << counts.xWins << std::setw(14) << counts.oWins
+			<< std::setw(14) << counts.yWins << std::setw(14) << counts.draws
+			<< std::setw(14) << uint64_t(counts.nodes / std::max(seconds, 1e-9)) << "\n";
+
+		if (options.verify)
+		{
+			ReferenceBoard<Board> reference(board);
+			if (!(Perft<Board>::countReference(reference, depth) == counts))
+			{
+				std::cout << "MISMATCH against the reference board at depth " << depth << "\n";
+				status = 1;
+			}
+		}
+	}
+
+	if (options.verify && status == 0)
+	{
+		std::cout << "Every depth matches the reference board.\n";
+	}
+	return status;
+}
+
+
+void printUsage()
+{
+	std::cout << "Usage: perft [position] [--size RxC] [--depth N] [--bulk] [--hash] [--verify] [--batch]\n";
+	std::cout << "  position  Position to count from. Defaults to the empty board.\n";
+	std::cout << "  --size    Size of the empty board to use when no position is given. Defaults to 3x5.\n";
+	std::cout << "  --depth   Deepest depth to count. Defaults to 6.\n";
+	std::cout << "  --bulk    Count the moves at the last depth without playing them.\n";
+	std::cout << "  --hash    Reuse counts for positions, (or reflections of them), reached more than once.\n";
+	std::cout << "  --verify  Check every depth against a simple reference board.\n";
+	std::cout << "  --batch   Count on batches of boards with their vectorized kernels. Can't be combined with --bulk or --hash.\n";
+}
@@ -0,0 +1,209 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <stdexcept>
+#include "mtt_board.hpp"
+#include "playouts.hpp"
+#include "player_policy.hpp"
+
+
+/*Settings taken from the command line.*/
+struct PlayoutOptions
+{
+	uint64_t games = 10000000;
+	std::size_t threads = std::max(std::thread::hardware_concurrency(), 1u);
+	PlayerModel players[3] = {PlayerModel::SEMI_COMPETENT, PlayerModel::SEMI_COMPETENT, PlayerModel::SEMI_COMPETENT};
+	uint64_t seed = 0;
+};
+
+
+void printUsage();
+
+template <class Board>
+int playPosition(Board board, const std::string& position, const PlayoutOptions& options);
+
+
+/*Plays millions of random games from a position, and prints how often each player wins, and how long games last.
+ *Usage: playouts [position] [--size RxC] [--games N] [--threads N] [--players models] [--random] [--seed N]
+ *`position` uses the notation described by MTT_Board's constructor, and its board size is read from it.
+ *Without a position, the empty board of the size given by `--size`, (3x5 by default), is used.
+ *Players are semi-competent unless `--players` gives each of them a model, (see player_policy.hpp),
+ *eg. "greedy,semi-competent,semi-competent", or a single one for everyone. `--random` is short for "--players random".
+ *The same seed and thread count always give the same numbers.*/
+int main(int argc, char** argv)
+{
+	std::string position;
+	uint8_t rows = 3;
+	uint8_t columns = 5;
+	PlayoutOptions options;
+
+	int index = 1;
+	try
+	{
+		for (; index < argc; index++)
+		{
+			std::string argument = argv[index];
+			if (argument == "--size" && index + 1 < argc)
+			{
+				if (!parseBoardSize(argv[++index], rows, columns))
+				{
+					std::cerr << "Could not read board size \"" << argv[index] << "\".\n";
+					return 1;
+				}
+			}
+			else if (argument == "--games" && index + 1 < argc)
+			{
+				options.games = std::stoull(argv[++index]);
+			}
+			else if (argument == "--threads" && index + 1 < argc)
+			{
+				options.threads = std::max<std::size_t>(std::stoul(argv[++index]), 1);
+			}
+			else if (argument == "--players" && index + 1 < argc)
+			{
+				if (!parsePlayerModels(argv[++index], options.players, 3))
+				{
+					std::cerr << "Could not read players \"" << argv[index] << "\".\n";
+					return 1;
+				}
+			}
+			else if (argument == "--random")
+			{
+				parsePlayerModels("random", options.players, 3);
+			}
+			else if (argument == "--seed" && index + 1 < argc)
+			{
+				options.seed = std::stoull(argv[++index]);
+			}
+			else if (argument == "--help")
+			{
+				printUsage();
+				return 0;
+			}
+			else
+			{
+				position = argument;
+			}
+		}
+	}
+	catch (const std::logic_error&)
+	{
+		//std::stoul() and the like throw for anything that isn't a number, or is too big for one.
+		std::cerr << "Could not read the number given to " << argv[index - 1] << ".\n";
+		return 1;
+	}
+
+	if (!position.empty() && !boardSizeOf(position, rows, columns))
+	{
+		std::cerr << "Could not read position \"" << position << "\".\n";
+		return 1;
+	}
+
+	int status = 1;
+	bool supported = withBoardSize(rows, columns, [&](auto board)
+	{
+		status = playPosition(board, position, options);
+	});
+
+	if (!supported)
+	{
+		std::cerr << "No " << int(rows) << "x" << int(columns) << " board is compiled in.\n";
+	}
+	return status;
+}
+
+
+template <class Board>
+int playPosition(Board board, const std::string& position, const PlayoutOptions& options)
+{
+	constexpr s_t NUM_PLAYERS = PlayoutGenerator<Board>::NUM_PLAYERS;
+
+	try
+	{
+		if (!position.empty())
+		{
+			board.setBoard(position);
+		}
+	}
+	catch (const std::exception& error)
+	{
+		std::cerr << "Could not read position \"" << position << "\": " << error.what() << "\n";
+		return 1;
+	}
+
+	//The policies are compiled into the playouts, so the ones asked for are picked once, here.
+	PlayoutStats<Board> stats;
+	auto start = std::chrono::steady_clock::now();
+	withSeatPolicies<NUM_PLAYERS>(options.players, [&](auto seats)
+	{
+		PlayoutGenerator<Board, decltype(seats)> generator(board);
+		stats = generator.run(options.games, options.threads, options.seed);
+	});
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	uint64_t total = std::max<uint64_t>(stats.total(), 1);
+	const char* names[] = {"X", "O", "Y"};
+
+	std::cout << "Position:  " << board.getBoardPosition() << "\n";
+	std::cout << "Players:  ";
+	for (s_t player = 0; player < NUM_PLAYERS; player++)
+	{
+		std::cout << " " << names[player] << " " << playerModelName(options.players[player]) << ((player + 1 < NUM_PLAYERS) ? "," : "\n");
+	}
+	std::cout << "Games:     " << stats.total() << " in " << std::fixed << std::setprecision(2) << seconds << "s, ("
+		<< uint64_t(stats.total() / seconds) << " per second)\n\n";
+
+	std::cout << "Outcome          Games  Share\n";
+	for (s_t outcome = 0; outcome <= NUM_PLAYERS; outcome++)
+	{
+		std::cout << std::left << std::setw(8) << ((outcome < NUM_PLAYERS) ? names[outcome] : "draw") << std::right
+			<< std::setw(13) << stats.outcomeCount(outcome)
+			<< std::setw(6) << std::setprecision(2) << stats.outcomeCount(outcome) * 100.0 / total << "%\n";
+	}
+
+	//Only lengths that came up are listed, each with its share of all games, then how those games ended.
+	std::cout << "\nMoves    Share";
+	for (s_t outcome = 0; outcome <= NUM_PLAYERS; outcome++)
+	{
+		std::cout << std::setw(8) << ((outcome < NUM_PLAYERS) ? names[outcome] : "draw");
+	}
+	std::cout << "\n";
+
+	double meanLength = 0;
+	for (s_t length = 0; length <= Board::NUM_SQUARES; length++)
+	{
+		uint64_t games = stats.lengthCount(length);
+		meanLength += double(length) * games / total;
+		if (games == 0)
+		{
+			continue;
+		}
+
+		std::cout << std::setw(5) << length << std::setw(8) << games * 100.0 / total << "%";
+		for (s_t outcome = 0; outcome <= NUM_PLAYERS; outcome++)
+		{
+			std::cout << std::setw(7) << stats.games[outcome][length] * 100.0 / games << "%";
+		}
+		std::cout << "\n";
+	}
+	std::cout << "\nMean length: " << meanLength << " moves\n";
+	return 0;
+}
+
+
+void printUsage()
+{
+	std::cout << "Usage: playouts [position] [--size RxC] [--games N] [--threads N] [--players models] [--random] [--seed N]\n";
+	std::cout << "  position  Board position to play from, eg. \"X4/5/5 O\". Defaults to the empty board.\n";
+	std::cout << "  --size    Size of the empty board to play from when no position is given, eg. 5x5. Defaults to 3x5.\n";
+	std::cout << "  --games   Number of games to play. Defaults to 10000000.\n";
+	std::cout << "  --threads Number of threads to play on. Defaults to one per core.\n";
+	std::cout << "  --players How each player picks their moves: random, greedy, or semi-competent, (the default),\n";
+	std::cout << "            as a comma separated list in turn order, eg. \"greedy,semi-competent,random\", or one for everyone.\n";
+	std::cout << "            random plays any empty square, greedy takes a win if there is one, and semi-competent also blocks.\n";
+	std::cout << "  --random  Short for \"--players random\".\n";
+	std::cout << "  --seed    Seed for the random moves. The same seed and thread count always give the same numbers.\n";
+}
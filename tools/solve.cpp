@@ -0,0 +1,457 @@
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <filesystem>
+#include <thread>
+#include <algorithm>
+#include <stdexcept>
+#include "mtt_board.hpp"
+#include "search_stats.hpp"
+#include "solver.hpp"
+#include "player_policy.hpp"
+#include "proof_search.hpp"
+#include "outcome_odds.hpp"
+#include "result_database.hpp"
+
+
+/*Settings taken from the command line.*/
+struct SolveOptions
+{
+	OutcomeSet target = X_WINS;
+	std::size_t tableMegabytes = 64;
+	std::size_t threads = std::max(std::thread::hardware_concurrency(), 1u);
+	bool proofSearch = false;
+	ProofGoal goal = ProofGoal::X_CAN_WIN;
+	uint64_t maxNodes = UINT64_MAX;
+	double seconds = 0;
+	bool printTree = false;
+	bool odds = false;
+	std::string statsPath;
+	double statsInterval = 0;
+	std::string databasePath;
+	std::string checkpointPath;
+	double checkpointInterval = 600;
+	bool resume = false;
+	PlayerModel players[3] = {PlayerModel::SEMI_COMPETENT, PlayerModel::SEMI_COMPETENT, PlayerModel::SEMI_COMPETENT};
+	bool customPlayers = false;
+};
+
+
+void printUsage();
+void printOutcomes(OutcomeSet outcomes);
+void printProofTree(const ProofResult& result);
+
+template <class Board>
+int solvePosition(Board board, const std::string& position, const SolveOptions& options);
+
+template <class Board>
+void provePosition(Board& board, const SolveOptions& options);
+
+template <class Board>
+void computeOdds(Board& board);
+
+
+/*Answers the README's question for a single position:
+ *can X ever win if every player is semi-competent?
+ *Usage: solve [position] [--size RxC] [--all] [--tt-mb megabytes] [--threads N] [--players models] [--time seconds]
+ *             [--prove] [--forced] [--max-nodes N] [--tree] [--odds] [--stats file] [--stats-every seconds] [--db file]
+ *             [--checkpoint file] [--checkpoint-every seconds] [--resume]
+ *`position` uses the notation described by MTT_Board's constructor, and its board size is read from it.
+ *Without a position, the empty board of the size given by `--size`, (3x5 by default), is solved.
+ *`--all` searches for every reachable outcome instead of stopping at the first X victory.
+ *`--tt-mb` sets the memory budget of the transposition table.
+ *`--threads` sets how many threads search at once. One thread gives the exact same output every run.
+ *`--players` swaps the semi-competent rule for another model per player, (see player_policy.hpp),
+ *eg. "greedy,semi-competent,semi-competent", or a single one for everyone. Only the exhaustive search takes it.
+ *`--prove` answers the question with a proof-number search instead, and `--forced` asks that search
+ *whether X can win however O and Y play, rather than whether X can ever win.
+ *`--time` and `--max-nodes` stop the search once it has taken that long, or visited that many positions,
+ *and print what it found by then, (see Solver::solveAsync()), checking in on it every second.
+ *`--max-nodes` caps how many positions the proof search expands too, and `--tree` prints the proof it finds.
+ *`--odds` works out the exact chance of each outcome when players pick between their allowed moves at random.
+ *`--stats` writes the search statistics to `file` as JSON when done, and every `--stats-every` seconds until then,
+ *if they were compiled in, (see the MTT_STATS CMake option).
+ *`--db` answers from a result database file instead of searching, if the file already knows the answer,
+ *and otherwise adds what the search found to it, creating the file if it doesn't exist yet.
+ *`--checkpoint` saves the exhaustive search's progress to `file` every `--checkpoint-every` seconds, (10 minutes by default),
+ *and when it's done, and `--resume` carries on from the checkpoint in that file, if there is one,
+ *(see Solver::setCheckpoint()). The table is saved beside it, in `file`.table, which is as big as `--tt-mb`.*/
+int main(int argc, char** argv)
+{
+	std::string position;
+	uint8_t rows = 3;
+	uint8_t columns = 5;
+	SolveOptions options;
+
+	int index = 1;
+	try
+	{
+		for (; index < argc; index++)
+		{
+			std::string argument = argv[index];
+			if (argument == "--all")
+			{
+				options.target = ALL_OUTCOMES;
+			}
+			else if (argument == "--size" && index + 1 < argc)
+			{
+				if (!parseBoardSize(argv[++index], rows, columns))
+				{
+					std::cerr << "Could not read board size \"" << argv[index] << "\".\n";
+					return 1;
+				}
+			}
+			else if (argument == "--tt-mb" && index + 1 < argc)
+			{
+				options.tableMegabytes = std::stoul(argv[++index]);
+			}
+			else if (argument == "--threads" && index + 1 < argc)
+			{
+				options.threads = std::stoul(argv[++index]);
+			}
+			else if (argument == "--players" && index + 1 < argc)
+			{
+				if (!parsePlayerModels(argv[++index], options.players, 3))
+				{
+					std::cerr << "Could not read players \"" << argv[index] << "\".\n";
+					return 1;
+				}
+				options.customPlayers = true;
+			}
+			else if (argument == "--prove")
+			{
+				options.proofSearch = true;
+			}
+			else if (argument == "--forced")
+			{
+				options.proofSearch = true;
+				options.goal = ProofGoal::X_FORCES_WIN;
+			}
+			else if (argument == "--max-nodes" && index + 1 < argc)
+			{
+				options.maxNodes = std::stoull(argv[++index]);
+			}
+			else if (argument == "--time" && index + 1 < argc)
+			{
+				options.seconds = std::stod(argv[++index]);
+			}
+			else if (argument == "--tree")
+			{
+				options.printTree = true;
+			}
+			else if (argument == "--odds")
+			{
+				options.odds = true;
+			}
+			else if (argument == "--stats" && index + 1 < argc)
+			{
+				options.statsPath = argv[++index];
+			}
+			else if (argument == "--stats-every" && index + 1 < argc)
+			{
+				options.statsInterval = std::stod(argv[++index]);
+			}
+			else if (argument == "--db" && index + 1 < argc)
+			{
+				options.databasePath = argv[++index];
+			}
+			else if (argument == "--checkpoint" && index + 1 < argc)
+			{
+				options.checkpointPath = argv[++index];
+			}
+			else if (argument == "--checkpoint-every" && index + 1 < argc)
+			{
+				options.checkpointInterval = std::stod(argv[++index]);
+			}
+			else if (argument == "--resume")
+			{
+				options.resume = true;
+			}
+			else if (argument == "--help")
+			{
+				printUsage();
+				return 0;
+			}
+			else
+			{
+				position = argument;
+			}
+		}
+	}
+	catch (const std::logic_error&)
+	{
+		//std::stoul() and the like throw for anything that isn't a number, or is too big for one.
+		std::cerr << "Could not read the number given to " << argv[index - 1] << ".\n";
+		return 1;
+	}
+
+	if (!position.empty() && !boardSizeOf(position, rows, columns))
+	{
+		std::cerr << "Could not read position \"" << position << "\".\n";
+		return 1;
+	}
+
+	//The proof search, the odds, and the database all assume the semi-competent rule.
+	if (options.customPlayers && (options.proofSearch || options.odds || !options.databasePath.empty()))
+	{
+		std::cerr << "--players can't be combined with --prove, --forced, --odds or --db.\n";
+		return 1;
+	}
+
+	//Checkpoints are only taken by the search without limits.
+	if (options.resume && options.checkpointPath.empty())
+	{
+		std::cerr << "--resume needs a --checkpoint file to resume from.\n";
+		return 1;
+	}
+	if (!options.checkpointPath.empty()
+		&& (options.proofSearch || options.odds || options.seconds > 0 || options.maxNodes != UINT64_MAX))
+	{
+		std::cerr << "--checkpoint can't be combined with --prove, --forced, --odds, --time or --max-nodes.\n";
+		return 1;
+	}
+
+	int status = 1;
+	bool supported = withBoardSize(rows, columns, [&](auto board)
+	{
+		status = solvePosition(board, position, options);
+	});
+
+	if (!supported)
+	{
+		std::cerr << "No " << int(rows) << "x" << int(columns) << " board is compiled in.\n";
+	}
+	return status;
+}
+
+
+/*Solves `position` on a board of the matching variant,
+ *or solves `board` as handed in if `position` is empty.*/
+template <class Board>
+int solvePosition(Board board, const std::string& position, const SolveOptions& options)
+{
+	try
+	{
+		if (!position.empty())
+		{
+			board.setBoard(position);
+		}
+	}
+	catch (const std::exception& error)
+	{
+		std::cerr << "Could not read position \"" << position << "\": " << error.what() << "\n";
+		return 1;
+	}
+
+	//Reports a final line of statistics when it goes out of scope, at the end of whichever search runs.
+	std::ofstream statsFile;
+	std::unique_ptr<StatsReporter> stats;
+	if (!options.statsPath.empty())
+	{
+		statsFile.open(options.statsPath);
+		if (!statsFile)
+		{
+			std::cerr << "Could not open \"" << options.statsPath << "\".\n";
+			return 1;
+		}
+		if (!SearchStats::ENABLED)
+		{
+			std::cerr << "Search statistics weren't compiled in; rebuild with -DMTT_STATS=ON to count them.\n";
+		}
+		stats = std::make_unique<StatsReporter>(statsFile, options.statsInterval);
+	}
+
+	if (options.proofSearch)
+	{
+		provePosition(board, options);
+		return 0;
+	}
+
+	if (options.odds)
+	{
+		computeOdds(board);
+		return 0;
+	}
+
+	SolveResult result;
+	bool fromDatabase = false;
+	try
+	{
+		if (!options.databasePath.empty() && std::filesystem::exists(options.databasePath))
+		{
+			ResultDatabase<Board> database(options.databasePath);
+			fromDatabase = database.answer(board, options.target, result);
+		}
+
+		if (!fromDatabase)
+		{
+			TranspositionTable table(options.tableMegabytes);
+			withSeatPolicies<Board::Geometry::NUM_PLAYERS>(options.players, [&](auto seats)
+			{
+				Solver<Board, decltype(seats)> solver(table, options.threads);
+				if (!options.checkpointPath.empty())
+				{
+					solver.setCheckpoint(options.checkpointPath, options.checkpointInterval, options.resume);
+				}
+				if (options.seconds == 0 && options.maxNodes == UINT64_MAX)
+				{
+					result = solver.solve(board, options.target);
+					return;
+				}
+
+				SolveLimits limits;
+				limits.seconds = options.seconds;
+				limits.maxNodes = options.maxNodes;
+				limits.progressInterval = 1;
+				limits.onProgress = [](const SolveProgress& progress)
+				{
+					std::cerr << std::fixed << std::setprecision(1) << progress.seconds << "s: " << progress.nodes << " nodes, "
+						<< (progress.xCanWin() ? "X can win" : "no X victory found yet") << "\n";
+				};
+				result = solver.solveAsync(board, limits, options.target).get();
+			});
+		}
+
+		if (!fromDatabase && !options.databasePath.empty() && result.complete())
+		{
+			std::vector<typename ResultDatabase<Board>::Record> records;
+			ResultDatabase<Board>::addResult(board, options.target, result, records);
+			ResultDatabase<Board>::save(options.databasePath, std::move(records));
+		}
+	}
+	catch (const std::exception& error)
+	{
+		std::cerr << error.what() << "\n";
+		return 1;
+	}
+
+	std::cout << "Position:  " << board.getBoardPosition() << "\n";
+	if (options.customPlayers)
+	{
+		const char* names[] = {"X", "O", "Y"};
+		std::cout << "Players:  ";
+		for (s_t player = 0; player < Board::Geometry::NUM_PLAYERS; player++)
+		{
+			std::cout << " " << names[player] << " " << playerModelName(options.players[player])
+				<< ((player + 1 < Board::Geometry::NUM_PLAYERS) ? "," : "\n");
+		}
+	}
+	std::cout << "X can win: " << (result.xCanWin() ? "yes" : (result.complete() ? "no" : "unknown")) << "\n";
+	if (!result.complete())
+	{
+		std::cout << "Stopped:   " << ((result.status == SolveStatus::OUT_OF_TIME) ? "out of time" : "out of nodes")
+			<< ", (only outcomes found by then are listed)\n";
+	}
+
+	if (result.xCanWin())
+	{
+		//A search which was stopped may not have had room to follow the witness to the end.
+		Board end = board;
+		std::cout << "Witness:  ";
+		for (Position move : result.witness)
+		{
+			std::cout << " (" << int(move.row) << ", " << int(move.col) << ")";
+			end.makeMove(move.row, move.col);
+		}
+		std::cout << (end.isOver() ? "\n" : " ..., (cut short by the limit)\n");
+	}
+
+	if (options.target == ALL_OUTCOMES)
+	{
+		printOutcomes(result.reachable);
+	}
+
+	std::cout << "Nodes:     " << result.nodes << (fromDatabase ? ", (answered from the database)" : "") << "\n";
+	return 0;
+}
+
+
+template <class Board>
+void provePosition(Board& board, const SolveOptions& options)
+{
+	ProofSearch<Board> search(options.tableMegabytes);
+	ProofResult result = search.prove(board, options.goal, options.maxNodes);
+
+	std::cout << "Position:  " << board.getBoardPosition() << "\n";
+	std::cout << ((options.goal == ProofGoal::X_FORCES_WIN) ? "X can force a win: " : "X can win: ")
+		<< (!result.resolved ? "unknown, (ran out of nodes)" : (result.proven ? "yes" : "no")) << "\n";
+
+	if (result.proven)
+	{
+		std::cout << "Proof:     " << result.proofTree.size() << " moves"
+			<< (result.treeComplete ? "" : ", (too big to list in full)") << "\n";
+		if (options.printTree)
+		{
+			printProofTree(result);
+		}
+	}
+
+	std::cout << "Nodes:     " << result.nodes << "\n";
+}
+
+
+template <class Board>
+void computeOdds(Board& board)
+{
+	OddsSolver<Board> solver;
+	OutcomeOdds odds = solver.solve(board);
+
+	std::cout << "Position:  " << board.getBoardPosition() << "\n";
+	std::cout << "X can win: " << ((odds.of(X_WINS) > 0) ? "yes" : "no") << "\n";
+	std::cout << "Chances:  " << std::fixed << std::setprecision(6)
+		<< " X " << odds.of(X_WINS) * 100 << "%"
+		<< ", O " << odds.of(O_WINS) * 100 << "%"
+		<< ", Y " << odds.of(Y_WINS) * 100 << "%"
+		<< ", draw " << odds.of(DRAW) * 100 << "%\n";
+	std::cout << "Positions: " << solver.numPositions() << "\n";
+}
+
+
+void printUsage()
+{
+	std::cout << "Usage: solve [position] [--size RxC] [--all] [--tt-mb megabytes] [--threads N] [--players models] [--time seconds]\n";
+	std::cout << "             [--prove] [--forced] [--max-nodes N] [--tree] [--odds] [--stats file] [--stats-every seconds] [--db file]\n";
+	std::cout << "             [--checkpoint file] [--checkpoint-every seconds] [--resume]\n";
+	std::cout << "  position  Board position to solve, eg. \"X4/5/5 O\". Defaults to the empty board.\n";
+	std::cout << "  --size    Size of the empty board to solve when no position is given, eg. 5x5. Defaults to 3x5.\n";
+	std::cout << "  --all     Find every reachable outcome, not just whether X can win.\n";
+	std::cout << "  --tt-mb   Memory budget of the transposition table, in megabytes. Defaults to 64.\n";
+	std::cout << "  --threads Number of threads to search with. Defaults to one per core. 1 always gives the same output.\n";
+	std::cout << "  --players How each player picks their moves: random, greedy, or semi-competent, (the default),\n";
+	std::cout << "            as a comma separated list in turn order, eg. \"greedy,semi-competent,random\", or one for everyone.\n";
+	std::cout << "  --time    Stop searching after this many seconds, and print what was found by then. Searches on one thread.\n";
+	std::cout << "  --prove   Answer with a single threaded proof-number search instead of the exhaustive one.\n";
+	std::cout << "  --forced  Prove whether X can win however O and Y play, rather than whether X can ever win.\n";
+	std::cout << "  --max-nodes  Stop searching after visiting, (or for the proof search, expanding), this many positions.\n";
+	std::cout << "  --tree    Print the proof, one move per line, each indented one step further than the move it answers.\n";
+	std::cout << "  --odds    Work out the exact chance of each outcome when every player picks at random between the moves\n";
+	std::cout << "            the semi-competent rule allows. Practical for any 3x5 or 4x4 position, but not the empty 5x5 board.\n";
+	std::cout << "  --stats   Write search statistics to this file as a line of JSON when done. Needs a build with -DMTT_STATS=ON.\n";
+	std::cout << "  --stats-every  Also write a line of statistics this often, in seconds, while searching.\n";
+	std::cout << "  --db      Answer from this result database if it knows the answer, and otherwise add the answer to it.\n";
+	std::cout << "  --checkpoint  Save the search's progress to this file now and then, and when it's done.\n";
+	std::cout << "  --checkpoint-every  How often to save it, in seconds. Defaults to 600.\n";
+	std::cout << "  --resume  Carry on from the checkpoint in the --checkpoint file, if there is one, rather than starting over.\n";
+}
+
+
+void printOutcomes(OutcomeSet outcomes)
+{
+	std::cout << "Reachable:";
+	if (outcomes & X_WINS) std::cout << " X";
+	if (outcomes & O_WINS) std::cout << " O";
+	if (outcomes & Y_WINS) std::cout << " Y";
+	if (outcomes & DRAW) std::cout << " draw";
+	std::cout << "\n";
+}
+
+
+void printProofTree(const ProofResult& result)
+{
+	for (const ProofStep& step : result.proofTree)
+	{
+		std::cout << std::string(2 * step.depth, ' ') << "(" << int(step.move.row) << ", " << int(step.move.col) << ")\n";
+	}
+}
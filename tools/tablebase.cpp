@@ -0,0 +1,183 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include "mtt_board.hpp"
+#include "tablebase.hpp"
+
+void printUsage();
+void printEntry(const TablebaseEntry& entry);
+
+template <class Board>
+int buildTablebase(Board, const std::string& path);
+
+template <class Board>
+int queryTablebase(Board board, const std::string& path, const std::vector<std::string>& positions);
+
+
+/*Builds a tablebase file, or answers positions from one.
+ *Usage: tablebase build [--size RxC] [--file path]
+ *       tablebase query [position...] [--file path]
+ *Queried positions are read from the command line, or one per line from standard input if none are given.
+ *The board size of a query is read from the first position.*/
+int main(int argc, char** argv)
+{
+	if (argc < 2 || (std::string(argv[1]) != "build" && std::string(argv[1]) != "query"))
+	{
+		printUsage();
+		return (argc >= 2 && std::string(argv[1]) == "--help") ? 0 : 1;
+	}
+
+	bool building = std::string(argv[1]) == "build";
+	uint8_t rows = 3;
+	uint8_t columns = 5;
+	std::string path;
+	std::vector<std::string> positions;
+
+	for (int index = 2; index < argc; index++)
+	{
+		std::string argument = argv[index];
+		if (argument == "--size" && index + 1 < argc)
+		{
+			if (!parseBoardSize(argv[++index], rows, columns))
+			{
+				std::cerr << "Could not read board size \"" << argv[index] << "\".\n";
+				return 1;
+			}
+		}
+		else if (argument == "--file" && index + 1 < argc)
+		{
+			path = argv[++index];
+		}
+		else if (argument == "--help")
+		{
+			printUsage();
+			return 0;
+		}
+		else
+		{
+			positions.push_back(argument);
+		}
+	}
+
+	if (!building && positions.empty())
+	{
+		std::string line;
+		while (std::getline(std::cin, line))
+		{
+			if (!line.empty())
+			{
+				positions.push_back(line);
+			}
+		}
+	}
+
+	if (!building && !positions.empty() && !boardSizeOf(positions[0], rows, columns))
+	{
+		std::cerr << "Could not read position \"" << positions[0] << "\".\n";
+		return 1;
+	}
+
+	if (path.empty())
+	{
+		path = "tablebase_" + std::to_string(rows) + "x" + std::to_string(columns) + ".bin";
+	}
+
+	int status = 1;
+	bool supported = withBoardSize(rows, columns, [&](auto board)
+	{
+		status = building ? buildTablebase(board, path) : queryTablebase(board, path, positions);
+	});
+
+	if (!supported)
+	{
+		std::cerr << "No " << int(rows) << "x" << int(columns) << " board is compiled in.\n";
+	}
+	return status;
+}
+
+
+/*Builds the tablebase of the board's variant, (the board itself only picks the variant).*/
+template <class Board>
+int buildTablebase(Board, const std::string& path)
+{
+	try
+	{
+		uint64_t size = Tablebase<Board>::build(path, &std::cout);
+		std::cout << "Wrote " << size << " positions to " << path << "\n";
+	}
+	catch (const std::exception& error)
+	{
+		std::cerr << error.what() << "\n";
+		return 1;
+	}
+	return 0;
+}
+
+
+template <class Board>
+int queryTablebase(Board board, const std::string& path, const std::vector<std::string>& positions)
+{
+	try
+	{
+		Tablebase<Board> tablebase(path);
+		int status = 0;
+
+		for (const std::string& position : positions)
+		{
+			std::cout << position << ":";
+			TablebaseEntry entry;
+			try
+			{
+				board.setBoard(position);
+			}
+			catch (const std::exception& error)
+			{
+				std::cout << " invalid position (" << error.what() << ")\n";
+				status = 1;
+				continue;
+			}
+
+			if (tablebase.lookup(board, entry))
+			{
+				printEntry(entry);
+			}
+			else
+			{
+				std::cout << " unreachable\n";
+			}
+		}
+		return status;
+	}
+	catch (const std::exception& error)
+	{
+		std::cerr << error.what() << "\n";
+		return 1;
+	}
+}
+
+
+void printUsage()
+{
+	std::cout << "Usage: tablebase build [--size RxC] [--file path]\n";
+	std::cout << "       tablebase query [position...] [--file path]\n";
+	std::cout << "  build     Solve every reachable position of the board size given by --size, (3x5 by default, 4x4 at most).\n";
+	std::cout << "  query     Look up each position, (read one per line from standard input if none are given).\n";
+	std::cout << "  --file    Tablebase file to write or read. Defaults to tablebase_RxC.bin.\n";
+}
+
+
+/*Prints every reachable outcome, along with the fewest moves it takes to get there.*/
+void printEntry(const TablebaseEntry& entry)
+{
+	const Outcome outcomes[] = {X_WINS, O_WINS, Y_WINS, DRAW};
+	const char* names[] = {"X", "O", "Y", "draw"};
+
+	for (s_t index = 0; index < 4; index++)
+	{
+		if (entry.reachable & outcomes[index])
+		{
+			std::cout << " " << names[index] << " in " << int(entry.distanceTo(outcomes[index]));
+		}
+	}
+	std::cout << "\n";
+}